@@ -16,6 +16,17 @@ android {
         versionName = "1.0"
 
         testInstrumentationRunner = "androidx.test.runner.AndroidJUnitRunner"
+
+        externalNativeBuild {
+            cmake {
+                // ./gradlew -PnativeInstrumentation ... builds the native counters and tracing in (getNativeStats)
+                if (project.hasProperty("nativeInstrumentation")) {
+                    arguments += "-DRESTAURANT_INSTRUMENTATION=ON"
+                    // Links libc++ into the library, so its allocations are counted too (core/AllocationCounter.cpp)
+                    arguments += "-DANDROID_STL=c++_static"
+                }
+            }
+        }
     }
 
     buildTypes {
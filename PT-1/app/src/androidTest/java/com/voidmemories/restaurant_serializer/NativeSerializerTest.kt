@@ -0,0 +1,691 @@
+package com.voidmemories.restaurant_serializer
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertThrows
+import org.junit.Assert.assertTrue
+import org.junit.Assume.assumeTrue
+import org.json.JSONArray
+import org.json.JSONObject
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.File
+import java.nio.ByteBuffer
+import java.time.DayOfWeek
+import java.time.LocalTime
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+
+@RunWith(AndroidJUnit4::class)
+class NativeSerializerTest {
+    private val externalFunctions = ExternalFunctions()
+    private val restaurant = SyntheticRestaurants.restaurant(7)
+
+    @Test
+    fun serializeIntoDirectBufferMatchesString() {
+        val expected = externalFunctions.serializeRestaurant(restaurant).toByteArray(Charsets.UTF_8)
+        val buffer = ByteBuffer.allocateDirect(64 * 1024)
+
+        val written = externalFunctions.serializeRestaurantInto(restaurant, buffer)
+
+        assertEquals(expected.size, written)
+        val actual = ByteArray(written).also { buffer.get(it) }
+        assertTrue(expected.contentEquals(actual))
+    }
+
+    @Test
+    fun serializeIntoTooSmallBufferReturnsRequiredSize() {
+        val expectedSize = externalFunctions.serializeRestaurant(restaurant).toByteArray(Charsets.UTF_8).size
+        val buffer = ByteBuffer.allocateDirect(16)
+
+        assertEquals(expectedSize, externalFunctions.serializeRestaurantInto(restaurant, buffer))
+    }
+
+    @Test
+    fun doublesKeepFullPrecision() {
+        val precise = restaurant.copy(rating = 4.123456789, menu = listOf(MenuItem("m", "n", "d", 0.1 + 0.2, "c")))
+        val json = externalFunctions.serializeRestaurant(precise)
+
+        assertTrue(json.contains("\"rating\":4.123456789,"))
+        assertTrue(json.contains("\"price\":0.30000000000000004,"))
+    }
+
+    @Test
+    fun stringsAreEscapedAndEncodedAsStandardUtf8() {
+        val tricky = "Say \"hi\" \\ tab\t newline\n bell\u0007 caf\u00e9 \u65e5\u672c \uD83C\uDF54 end"
+        val withTricky = restaurant.copy(
+            name = tricky,
+            cuisines = listOf(tricky),
+            menu = listOf(MenuItem("m\"1", tricky, tricky.repeat(20), 1.5, null))
+        )
+
+        val json = externalFunctions.serializeRestaurant(withTricky)
+        val parsed = JSONObject(json)
+        assertEquals(tricky, parsed.getString("name"))
+        assertEquals(tricky, parsed.getJSONArray("cuisines").getString(0))
+        val item = parsed.getJSONArray("menu").getJSONObject(0)
+        assertEquals("m\"1", item.getString("id"))
+        assertEquals(tricky.repeat(20), item.getString("description"))
+
+        val buffer = ByteBuffer.allocateDirect(64 * 1024)
+        val written = externalFunctions.serializeRestaurantInto(withTricky, buffer)
+        val bytes = ByteArray(written).also { buffer.get(it) }
+        assertEquals(json, String(bytes, Charsets.UTF_8))
+    }
+
+    @Test
+    fun openingHoursMatchJavaToString() {
+        val times = listOf(
+            LocalTime.MIDNIGHT, LocalTime.NOON, LocalTime.MAX, LocalTime.of(8, 5), LocalTime.of(8, 5, 9),
+            LocalTime.of(1, 2, 3, 120_000_000), LocalTime.of(1, 2, 3, 123_456_000),
+            LocalTime.of(1, 2, 3, 1), LocalTime.of(1, 2, 0, 5_000)
+        )
+        val hours = times.mapIndexed { i, time ->
+            OpeningHour(DayOfWeek.values()[i % 7], time, times[(i + 1) % times.size])
+        }
+
+        val parsed = JSONObject(externalFunctions.serializeRestaurant(restaurant.copy(openingHours = hours)))
+        val array = parsed.getJSONArray("openingHours")
+        hours.forEachIndexed { i, hour ->
+            val json = array.getJSONObject(i)
+            assertEquals(hour.dayOfWeek.toString(), json.getString("dayOfWeek"))
+            assertEquals(hour.openTime.toString(), json.getString("openTime"))
+            assertEquals(hour.closeTime.toString(), json.getString("closeTime"))
+        }
+    }
+
+    @Test
+    fun keysFollowPropertyDeclarationOrder() {
+        val parsed = JSONObject(externalFunctions.serializeRestaurant(restaurant))
+
+        assertEquals(
+            listOf("id", "name", "address", "rating", "cuisines", "phoneNumber", "website", "openingHours", "menu"),
+            parsed.keys().asSequence().toList()
+        )
+        assertEquals(
+            listOf("street", "city", "state", "zipCode", "country"),
+            parsed.getJSONObject("address").keys().asSequence().toList()
+        )
+        assertEquals(
+            listOf("id", "name", "description", "price", "category"),
+            parsed.getJSONArray("menu").getJSONObject(0).keys().asSequence().toList()
+        )
+    }
+
+    @Test
+    fun jsonFormatMatchesStringOutput() {
+        val expected = externalFunctions.serializeRestaurant(restaurant).toByteArray(Charsets.UTF_8)
+
+        assertTrue(expected.contentEquals(externalFunctions.serializeRestaurant(restaurant, SerializationFormat.JSON)))
+    }
+
+    @Test
+    fun binaryFormatsWriteRawDoublesAndAreSmaller() {
+        val json = externalFunctions.serializeRestaurant(restaurant, SerializationFormat.JSON)
+        val rating = ByteBuffer.allocate(8).putDouble(restaurant.rating).array()
+        // Restaurant is a 9-entry map: CBOR major type 5, MessagePack fixmap
+        val expectations = mapOf(
+            SerializationFormat.CBOR to Pair(0xA9.toByte(), byteArrayOf(0x66) + "rating".toByteArray() + 0xFB.toByte()),
+            SerializationFormat.MESSAGE_PACK to Pair(0x89.toByte(), byteArrayOf(0xA6.toByte()) + "rating".toByteArray() + 0xCB.toByte())
+        )
+
+        for ((format, expected) in expectations) {
+            val encoded = externalFunctions.serializeRestaurant(restaurant, format)
+            assertEquals(expected.first, encoded[0])
+            assertTrue(indexOf(encoded, expected.second + rating) > 0)
+            assertTrue(encoded.size < json.size)
+
+            val buffer = ByteBuffer.allocateDirect(encoded.size)
+            assertEquals(encoded.size, externalFunctions.serializeRestaurantInto(restaurant, format, buffer))
+            assertTrue(encoded.contentEquals(ByteArray(encoded.size).also { buffer.get(it) }))
+        }
+    }
+
+    private fun indexOf(haystack: ByteArray, needle: ByteArray): Int =
+        (0..haystack.size - needle.size).firstOrNull { start ->
+            needle.indices.all { haystack[start + it] == needle[it] }
+        } ?: -1
+
+    @Test
+    fun deserializeRoundTripsSerializerOutput() {
+        val tricky = "Say \"hi\" \\ tab\t caf\u00e9 \u65e5\u672c \uD83C\uDF54"
+        val withTricky = restaurant.copy(
+            name = tricky,
+            openingHours = listOf(OpeningHour(DayOfWeek.SUNDAY, LocalTime.of(23, 59, 1, 120_000_000), LocalTime.MIDNIGHT)),
+            menu = SyntheticRestaurants.restaurant(8, menuSize = 1_000).menu
+        )
+
+        for (original in listOf(restaurant, withTricky)) {
+            val json = externalFunctions.serializeRestaurant(original)
+            assertEquals(original, externalFunctions.deserializeRestaurant(json))
+
+            val bytes = json.toByteArray(Charsets.UTF_8)
+            val buffer = ByteBuffer.allocateDirect(bytes.size + 3).apply { put(byteArrayOf(1, 2, 3)); put(bytes) }
+            buffer.position(3)
+            assertEquals(original, externalFunctions.deserializeRestaurant(buffer))
+        }
+    }
+
+    @Test
+    fun deserializeAcceptsReorderedKeysAndSkipsUnknownOnes() {
+        val json = externalFunctions.serializeRestaurant(restaurant)
+        val reordered = JSONObject(json).apply { put("unknown", JSONObject(mapOf("nested" to listOf(1, "]")))) }
+        val shuffled = JSONObject(reordered.keys().asSequence().toList().reversed().associateWith { reordered.get(it) })
+
+        assertEquals(restaurant, externalFunctions.deserializeRestaurant(shuffled.toString()))
+    }
+
+    @Test
+    fun deserializeRejectsMalformedJson() {
+        val json = externalFunctions.serializeRestaurant(restaurant)
+        val rating = Regex("\"rating\":[^,]+,")
+        fun withRating(number: String) = json.replace(rating, "\"rating\":$number,")
+        assertEquals(425.0, externalFunctions.deserializeRestaurant(withRating("4.25E+2")).rating, 0.0)
+
+        // Any length of digits is valid JSON
+        assertEquals(4.25, externalFunctions.deserializeRestaurant(withRating("4.25" + "0".repeat(200))).rating, 0.0)
+
+        // Skipped under an unknown key, but still checked
+        fun withUnknown(value: String) = "{\"unknown\":$value," + json.removePrefix("{")
+        assertEquals(restaurant, externalFunctions.deserializeRestaurant(withUnknown("[1,{\"a\":[true,null]},\"]\"]")))
+        val skipped = listOf("{\"a\":tru}", "[1,,2]", "{\"a\" 1}", "{1:2}", "[1 2]", "\"\\x\"", "[01]", "\"\u0001\"")
+
+        // Numbers outside the JSON grammar that strtod or from_chars would still take
+        val numbers = listOf("+1", ".5", "1.", "01", "-01", "-", "1e", "1e+", "1.e5")
+        val controlCharacter = json.replaceFirst("\"name\":\"", "\"name\":\"\t")
+        val malformedJson = listOf(json.dropLast(1), controlCharacter) + numbers.map(::withRating) +
+            skipped.map(::withUnknown)
+        for (malformed in malformedJson) {
+            assertThrows(malformed, IllegalArgumentException::class.java) {
+                externalFunctions.deserializeRestaurant(malformed)
+            }
+        }
+    }
+
+    @Test
+    fun cachedOutputTracksContentChanges() {
+        val uncached = externalFunctions.serializeRestaurant(restaurant)
+        val repriced = restaurant.copy(rating = 1.5)
+        try {
+            externalFunctions.setSerializationCacheCapacity(1L shl 20)
+            val before = externalFunctions.getSerializationCacheStats()
+
+            assertEquals(uncached, externalFunctions.serializeRestaurant(restaurant))
+            assertEquals(uncached, externalFunctions.serializeRestaurant(restaurant))
+            // Same id, new content: a miss, but the unchanged menu is spliced in from its fragment
+            assertEquals(
+                externalFunctions.serializeRestaurants(listOf(repriced)).removeSurrounding("[", "]"),
+                externalFunctions.serializeRestaurant(repriced)
+            )
+            externalFunctions.invalidateSerializationCache(restaurant.id)
+            assertEquals(uncached, externalFunctions.serializeRestaurant(restaurant))
+
+            val after = externalFunctions.getSerializationCacheStats()
+            assertEquals(2L, after.hits - before.hits)
+            assertTrue(after.fragmentHits > before.fragmentHits)
+        } finally {
+            externalFunctions.setSerializationCacheCapacity(0)
+        }
+    }
+
+    @Test
+    fun stringDeduplicationKeepsJsonAndShrinksCbor() {
+        val restaurants = SyntheticRestaurants.restaurants(50)
+        val json = externalFunctions.serializeRestaurants(restaurants)
+        val single = externalFunctions.serializeRestaurant(restaurant, SerializationFormat.MESSAGE_PACK)
+        val cbor = externalFunctions.serializeRestaurants(restaurants, SerializationFormat.CBOR)
+        try {
+            externalFunctions.setStringDeduplicationEnabled(true)
+            val before = externalFunctions.getStringDeduplicationStats()
+
+            assertEquals(json, externalFunctions.serializeRestaurants(restaurants))
+            assertTrue(single.contentEquals(externalFunctions.serializeRestaurant(restaurant, SerializationFormat.MESSAGE_PACK)))
+            val deduplicated = externalFunctions.serializeRestaurants(restaurants, SerializationFormat.CBOR)
+            // Tag 256 opens the stringref namespace, around the same 50-element array
+            assertEquals(listOf(0xD9, 0x01, 0x00, 0x98, 50).map { it.toByte() }, deduplicated.take(5))
+            assertTrue(deduplicated.size < cbor.size)
+
+            val after = externalFunctions.getStringDeduplicationStats()
+            assertTrue(after.hits > before.hits)
+            assertTrue(after.identityHits > before.identityHits) // The shared "SomeCity" literal
+            assertTrue(after.bytesSaved > before.bytesSaved)
+        } finally {
+            externalFunctions.setStringDeduplicationEnabled(false)
+        }
+    }
+
+    @Test
+    fun diffOfRatingChangeIsASingleReplace() {
+        val patch = externalFunctions.diffRestaurants(restaurant, restaurant.copy(rating = 4.25))
+
+        assertEquals("""[{"op":"replace","path":"/rating","value":4.25}]""", patch)
+        assertEquals("[]", externalFunctions.diffRestaurants(restaurant, restaurant.copy()))
+    }
+
+    @Test
+    fun diffPatchTurnsOldJsonIntoNewJson() {
+        val menu = restaurant.menu
+        val versions = listOf(
+            restaurant.copy(menu = menu.map { if (it == menu[3]) it.copy(price = it.price + 1) else it }),
+            restaurant.copy(menu = menu.drop(1).filter { it != menu[5] }),
+            restaurant.copy(menu = listOf(menu[0].copy(id = "new-item")) + menu + menu[1].copy(id = "last")),
+            restaurant.copy(menu = menu.reversed(), cuisines = restaurant.cuisines + "Fusion"),
+            restaurant.copy(
+                openingHours = restaurant.openingHours.drop(2).map { it.copy(closeTime = LocalTime.of(23, 0)) },
+                address = restaurant.address.copy(city = "Elsewhere")
+            )
+        )
+
+        for (updated in versions) {
+            val patched = applyJsonPatch(
+                JSONObject(externalFunctions.serializeRestaurant(restaurant)),
+                JSONArray(externalFunctions.diffRestaurants(restaurant, updated))
+            )
+            assertEquals(JSONObject(externalFunctions.serializeRestaurant(updated)).toString(), patched.toString())
+        }
+    }
+
+    /** Minimal RFC 6902 applier (add, remove, replace, move) over org.json, for checking diffRestaurants. */
+    private fun applyJsonPatch(document: JSONObject, patch: JSONArray): JSONObject {
+        fun parentOf(path: String): Pair<Any, String> {
+            val segments = path.split("/").drop(1)
+            var node: Any = document
+            for (segment in segments.dropLast(1)) {
+                node = if (node is JSONArray) node.get(segment.toInt()) else (node as JSONObject).get(segment)
+            }
+            return node to segments.last()
+        }
+        fun JSONArray.rebuilt(edit: (MutableList<Any?>) -> Unit): MutableList<Any?> =
+            MutableList(length()) { opt(it) }.also(edit)
+        fun JSONArray.replaceAll(values: List<Any?>) {
+            while (length() > 0) remove(length() - 1)
+            values.forEach { put(it) }
+        }
+        fun remove(path: String): Any? {
+            val (parent, key) = parentOf(path)
+            return if (parent is JSONArray) parent.remove(key.toInt()) else (parent as JSONObject).remove(key)
+        }
+        fun add(path: String, value: Any?, replace: Boolean) {
+            val (parent, key) = parentOf(path)
+            if (parent is JSONArray) {
+                val index = key.toInt()
+                parent.replaceAll(parent.rebuilt { if (replace) it[index] = value else it.add(index, value) })
+            } else {
+                (parent as JSONObject).put(key, value)
+            }
+        }
+
+        for (i in 0 until patch.length()) {
+            val op = patch.getJSONObject(i)
+            val path = op.getString("path")
+            when (op.getString("op")) {
+                "add" -> add(path, op.get("value"), replace = false)
+                "replace" -> add(path, op.get("value"), replace = true)
+                "remove" -> remove(path)
+                "move" -> add(path, remove(op.getString("from")), replace = false)
+                else -> throw IllegalArgumentException(op.toString())
+            }
+        }
+        return document
+    }
+
+    @Test
+    fun projectionKeepsOnlySelectedFieldsInDeclarationOrder() {
+        externalFunctions.compileProjection(listOf("menu.price", "rating", "id", "address.city")).use { projection ->
+            val json = JSONObject(externalFunctions.serializeRestaurantProjected(restaurant, projection))
+            val full = JSONObject(externalFunctions.serializeRestaurant(restaurant))
+
+            assertEquals(listOf("id", "address", "rating", "menu"), json.keys().asSequence().toList())
+            assertEquals(full.getString("id"), json.getString("id"))
+            assertEquals(full.getJSONObject("address").getString("city"), json.getJSONObject("address").getString("city"))
+            assertEquals(1, json.getJSONObject("address").length())
+            val menu = json.getJSONArray("menu")
+            assertEquals(restaurant.menu.size, menu.length())
+            assertEquals(listOf("price"), menu.getJSONObject(0).keys().asSequence().toList())
+            assertEquals(restaurant.menu[0].price, menu.getJSONObject(0).getDouble("price"), 0.0)
+        }
+    }
+
+    @Test
+    fun nullElementsAreSkippedInJsonArrays() {
+        @Suppress("UNCHECKED_CAST")
+        val withNulls = listOf(null, restaurant, null, restaurant, null) as List<Restaurant>
+        val json = JSONArray(externalFunctions.serializeRestaurants(withNulls))
+        assertEquals(2, json.length())
+        assertEquals(restaurant.id, json.getJSONObject(1).getString("id"))
+        externalFunctions.compileProjection(listOf("id")).use { projection ->
+            val projected = JSONArray(externalFunctions.serializeRestaurantsProjected(withNulls, projection))
+            assertEquals(2, projected.length())
+        }
+    }
+
+    @Test
+    fun projectionOfEveryFieldMatchesFullOutput() {
+        val fields = listOf("id", "name", "address", "rating", "cuisines", "phoneNumber", "website", "openingHours", "menu")
+        externalFunctions.compileProjection(fields).use { projection ->
+            assertEquals(
+                externalFunctions.serializeRestaurants(listOf(restaurant, restaurant), ndjson = true),
+                externalFunctions.serializeRestaurantsProjected(listOf(restaurant, restaurant), projection, ndjson = true)
+            )
+        }
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun projectionOfUnknownFieldIsRejected() {
+        externalFunctions.compileProjection(listOf("menu.calories"))
+    }
+
+    @Test
+    fun exportWritesTheSameNdjsonAsSerializeRestaurants() {
+        val restaurants = SyntheticRestaurants.restaurants(2_000) + SyntheticRestaurants.restaurant(1, menuSize = 10_000)
+        val expected = externalFunctions.serializeRestaurants(restaurants, ndjson = true).toByteArray(Charsets.UTF_8)
+        val file = File.createTempFile("export", ".ndjson")
+        try {
+            for (overlapIo in listOf(false, true)) {
+                assertEquals(expected.size.toLong(), externalFunctions.exportRestaurants(restaurants, file, overlapIo))
+                assertTrue(expected.contentEquals(file.readBytes()))
+            }
+        } finally {
+            file.delete()
+        }
+    }
+
+    @Test(expected = java.io.IOException::class)
+    fun exportToMissingDirectoryThrowsIOException() {
+        externalFunctions.exportRestaurants(listOf(restaurant), File("/nonexistent-dir/export.ndjson"))
+    }
+
+    @Test
+    fun failedExportRethrowsAndClosesTheFile() {
+        val failing = object : AbstractList<Restaurant>() {
+            override val size = 1
+            override fun get(index: Int): Restaurant = throw UnsupportedOperationException("unreadable list")
+        }
+        val file = File.createTempFile("export", ".ndjson")
+        try {
+            val openFiles = File("/proc/self/fd").list()!!.size
+            for (overlapIo in listOf(false, true)) {
+                assertThrows(UnsupportedOperationException::class.java) {
+                    externalFunctions.exportRestaurants(failing, file, overlapIo)
+                }
+            }
+            assertEquals(openFiles, File("/proc/self/fd").list()!!.size)
+        } finally {
+            file.delete()
+        }
+    }
+
+    @Test
+    fun asyncSerializationMatchesSynchronousOutput() {
+        val restaurants = SyntheticRestaurants.restaurants(200)
+        val futures = restaurants.map { externalFunctions.serializeRestaurantAsync(it) }
+        for ((expected, future) in restaurants.zip(futures)) {
+            assertEquals(externalFunctions.serializeRestaurant(expected), future.get(10, TimeUnit.SECONDS))
+        }
+
+        val delivered = CountDownLatch(1)
+        var json: String? = null
+        externalFunctions.serializeRestaurantAsync(restaurant) { result, _ ->
+            json = result
+            delivered.countDown()
+        }
+        assertTrue(delivered.await(10, TimeUnit.SECONDS))
+        assertEquals(externalFunctions.serializeRestaurant(restaurant), json)
+    }
+
+    @Test
+    fun cancelledAsyncSerializationIsSkipped() {
+        val big = SyntheticRestaurants.restaurant(2, menuSize = 50_000)
+        val first = externalFunctions.serializeRestaurantAsync(big)
+        val second = externalFunctions.serializeRestaurantAsync(big)
+
+        assertTrue(second.cancel(true))
+        assertEquals(externalFunctions.serializeRestaurant(big), first.get(10, TimeUnit.SECONDS))
+        assertTrue(second.isCancelled)
+    }
+
+    @Test
+    fun nativeStatsCountOnlyInInstrumentedBuilds() {
+        externalFunctions.resetNativeStats()
+        externalFunctions.startNativeTrace()
+        val json = externalFunctions.serializeRestaurant(restaurant)
+        val trace = JSONObject(externalFunctions.stopNativeTrace()).getJSONArray("traceEvents")
+        val stats = externalFunctions.getNativeStats()
+
+        if (!stats.enabled) {
+            assertEquals(0L, stats.totalJniCalls)
+            assertEquals(0, trace.length())
+            return
+        }
+        val menuStrings = restaurant.menu.size * 4L // id, name, description, category
+        assertTrue(stats.jniCalls.getValue(JniCallKind.STRING_READ) >= 2 * menuStrings)
+        assertTrue(stats.bytesProduced >= json.toByteArray(Charsets.UTF_8).size)
+        assertTrue(stats.phases.getValue(NativePhase.CALL).count >= 1)
+        assertTrue(stats.phases.getValue(NativePhase.TRANSCODE).count >= menuStrings)
+        assertTrue((0 until trace.length()).any { trace.getJSONObject(it).getString("name") == "serializeRestaurant" })
+    }
+
+    @Test
+    fun steadyStateSerializationDoesNotAllocate() {
+        // Only instrumented builds count allocations; elsewhere heapAllocations reads 0 whatever happens
+        assumeTrue("Allocation counts need a -PnativeInstrumentation build", externalFunctions.getNativeStats().enabled)
+        val batch = SyntheticRestaurants.restaurants(20, menuSize = 10)
+        val buffer = ByteBuffer.allocateDirect(64 * 1024)
+        fun serializeAll() {
+            externalFunctions.serializeRestaurant(restaurant)
+            externalFunctions.serializeRestaurantInto(restaurant, buffer)
+            externalFunctions.serializeRestaurant(restaurant, SerializationFormat.CBOR)
+            externalFunctions.serializeRestaurants(batch, ndjson = false)
+            externalFunctions.serializeRestaurants(batch, SerializationFormat.MESSAGE_PACK)
+        }
+        serializeAll() // Warms up the thread's scratch arena and output buffer
+        externalFunctions.resetNativeStats()
+
+        repeat(10) { serializeAll() }
+        val stats = externalFunctions.getNativeStats()
+
+        assertEquals(0L, stats.heapAllocations)
+    }
+
+    @Test
+    fun allocationCounterSeesLibraryAllocations() {
+        // The negative check for steadyStateSerializationDoesNotAllocate: a counter that missed libc++ would read 0
+        assumeTrue("Allocation counts need a -PnativeInstrumentation build", externalFunctions.getNativeStats().enabled)
+        try {
+            externalFunctions.setSerializationCacheCapacity(1L shl 20)
+            externalFunctions.resetNativeStats()
+            // A miss stores copies of the key and the bytes as std::strings, built inside libc++'s basic_string
+            externalFunctions.serializeRestaurant(restaurant.copy(id = "allocation-probe"))
+            assertTrue(externalFunctions.getNativeStats().heapAllocations > 0)
+        } finally {
+            externalFunctions.setSerializationCacheCapacity(0)
+        }
+    }
+
+    @Test
+    fun restaurantStoreQueriesMatchKotlinFilters() {
+        val restaurants = SyntheticRestaurants.restaurants(500)
+        val cuisine = restaurants[0].cuisines[0]
+        val cheap = MenuItemFilter(priceBelow = 10.0, category = restaurants[0].menu[0].category)
+        fun MenuItem.matches(filter: MenuItemFilter) =
+            price >= filter.minPrice && price < filter.priceBelow &&
+                (filter.category == null || category == filter.category)
+
+        externalFunctions.loadRestaurantStore(restaurants).use { store ->
+            assertEquals(500, store.restaurantCount)
+            assertEquals(500 * 20, store.menuItemCount)
+
+            val filter = RestaurantFilter(minRating = 3.0, cuisine = cuisine, menuItem = cheap)
+            val expected = restaurants.indices.filter { i ->
+                val r = restaurants[i]
+                r.rating >= 3.0 && cuisine in r.cuisines && r.menu.any { it.matches(cheap) }
+            }
+            assertEquals(expected, externalFunctions.filterRestaurants(store, filter).toList())
+            assertEquals(0, externalFunctions.filterRestaurants(store, RestaurantFilter(cuisine = "Martian")).size)
+
+            val expectedItems = restaurants.flatMapIndexed { r, restaurant ->
+                restaurant.menu.indices.filter { restaurant.menu[it].matches(cheap) }.flatMap { listOf(r, it) }
+            }
+            assertEquals(expectedItems, externalFunctions.filterMenuItems(store, cheap).toList())
+
+            val prices = restaurants.flatMap { it.menu }.filter { it.matches(cheap) }.map { it.price }
+            val summary = externalFunctions.summarizeMenuPrices(store, cheap, buckets = 4)
+            assertEquals(prices.size.toLong(), summary.count)
+            assertEquals(prices.minOrNull()!!, summary.min, 0.0)
+            assertEquals(prices.maxOrNull()!!, summary.max, 0.0)
+            assertEquals(prices.average(), summary.mean, 1e-9)
+            assertEquals(summary.count, summary.histogram.sum())
+        }
+    }
+
+    @Test
+    fun openingHoursIndexMatchesKotlinCheck() {
+        val lateNight = OpeningHour(DayOfWeek.SUNDAY, LocalTime.of(20, 0), LocalTime.of(2, 0)) // Into Monday
+        val restaurants = SyntheticRestaurants.restaurants(200).mapIndexed { i, r ->
+            when (i % 3) {
+                0 -> r.copy(openingHours = r.openingHours + lateNight)
+                1 -> r.copy(openingHours = emptyList())
+                else -> r
+            }
+        }
+        fun OpeningHour.isOpen(day: DayOfWeek, time: LocalTime) =
+            if (openTime < closeTime) dayOfWeek == day && time >= openTime && time < closeTime
+            else (dayOfWeek == day && time >= openTime) || (dayOfWeek.plus(1) == day && time < closeTime)
+
+        externalFunctions.loadOpeningHoursIndex(restaurants).use { index ->
+            assertEquals(200, index.restaurantCount)
+            val times = listOf(
+                DayOfWeek.MONDAY to LocalTime.of(1, 30), DayOfWeek.WEDNESDAY to LocalTime.NOON,
+                DayOfWeek.SUNDAY to LocalTime.of(23, 59), DayOfWeek.FRIDAY to LocalTime.of(5, 0)
+            )
+            for ((day, time) in times) {
+                val expected = restaurants.indices.filter { restaurants[it].openingHours.any { h -> h.isOpen(day, time) } }
+                assertEquals(expected, externalFunctions.restaurantsOpenAt(index, day, time).toList())
+                val first = expected.firstOrNull() ?: 0
+                assertEquals(expected.isNotEmpty(), externalFunctions.isOpenAt(index, first, day, time))
+            }
+            // Open Sunday 20:00 until Monday 02:00, so open for the whole of the 2 hours from 23:30
+            val lateOpen = externalFunctions.restaurantsOpenAt(index, DayOfWeek.SUNDAY, LocalTime.of(23, 30), minutes = 120)
+            assertTrue(0 in lateOpen)
+            assertEquals(0, externalFunctions.minutesUntilOpen(index, 0, DayOfWeek.MONDAY, LocalTime.of(1, 59)))
+
+            val untilOpen = externalFunctions.minutesUntilOpen(index, DayOfWeek.TUESDAY, LocalTime.of(3, 0))
+            assertEquals(-1, untilOpen[1])
+            val next = restaurants[2].openingHours.first { it.dayOfWeek == DayOfWeek.TUESDAY }.openTime
+            assertEquals(next.hour * 60 + next.minute - 180, untilOpen[2])
+        }
+
+        // Equal minutes after dropping the seconds: only exactly equal times are open around the clock
+        val brief = restaurant.copy(openingHours = listOf(
+            OpeningHour(DayOfWeek.WEDNESDAY, LocalTime.of(9, 0), LocalTime.of(9, 0, 30))))
+        val allDay = restaurant.copy(openingHours = listOf(
+            OpeningHour(DayOfWeek.WEDNESDAY, LocalTime.of(9, 0), LocalTime.of(9, 0))))
+        val shortHours = listOf(brief, allDay)
+        externalFunctions.loadOpeningHoursIndex(shortHours).use { index ->
+            val times = listOf(
+                DayOfWeek.WEDNESDAY to LocalTime.of(9, 0), DayOfWeek.WEDNESDAY to LocalTime.of(9, 1),
+                DayOfWeek.WEDNESDAY to LocalTime.of(20, 0), DayOfWeek.THURSDAY to LocalTime.of(8, 59)
+            )
+            for ((day, time) in times) {
+                val expected = shortHours.indices.filter { shortHours[it].openingHours.any { h -> h.isOpen(day, time) } }
+                assertEquals("$day $time", expected, externalFunctions.restaurantsOpenAt(index, day, time).toList())
+            }
+        }
+    }
+
+    @Test
+    fun menuSearchIndexMatchesKotlinSearch() {
+        val restaurants = SyntheticRestaurants.restaurants(100, menuSize = 12).mapIndexed { i, r ->
+            when (i % 10) {
+                0 -> r.copy(menu = r.menu + MenuItem("gf-$i", "Gluten-Free Pasta", "Pasta without gluten", 9.5, null))
+                5 -> r.copy(menu = r.menu + MenuItem("salad-$i", "Salad", "With a GLUTEN free dressing", 6.0, null))
+                else -> r
+            }
+        }
+        fun normalized(text: String?) = " " + (text ?: "").lowercase().replace(Regex("[^a-z0-9]+"), " ").trim()
+        fun expected(query: String, prefix: Boolean): Set<Pair<Int, Int>> {
+            val pattern = if (prefix) normalized(query) else normalized(query).drop(1)
+            return restaurants.flatMapIndexed { r, restaurant ->
+                restaurant.menu.indices.filter { m ->
+                    val item = restaurant.menu[m]
+                    pattern in normalized(item.name) || pattern in normalized(item.description)
+                }.map { r to it }
+            }.toSet()
+        }
+        fun IntArray.pairs() = (indices step 2).map { this[it] to this[it + 1] }
+
+        externalFunctions.loadMenuSearchIndex(restaurants).use { index ->
+            assertEquals(restaurants.sumOf { it.menu.size }, index.menuItemCount)
+            val queries = listOf(
+                "gluten free" to false, "GLUTEN" to true, "dish 1" to false, "ish 1" to true,
+                "number 11" to false, "ta" to false
+            )
+            for ((query, prefix) in queries) {
+                val found = externalFunctions.searchMenu(index, query, prefix, limit = 0).pairs()
+                assertEquals(query, expected(query, prefix), found.toSet())
+                assertEquals(query, found.size, found.toSet().size)
+            }
+            // Name matches come before description-only matches
+            val gluten = externalFunctions.searchMenu(index, "gluten", limit = 0).pairs()
+            assertEquals(20, gluten.size)
+            assertTrue(gluten.take(10).all { (r, _) -> r % 10 == 0 })
+            assertEquals(5, externalFunctions.searchMenu(index, "dish", limit = 5).size / 2)
+
+            // Editing one menu re-indexes that restaurant alone
+            val edited = restaurants[3].copy(menu = listOf(MenuItem("new", "Truffle Risotto", null, 20.0, null)))
+            externalFunctions.updateMenuSearchIndex(index, 3, edited)
+            assertEquals(listOf(3 to 0), externalFunctions.searchMenu(index, "risotto").pairs())
+            assertTrue(externalFunctions.searchMenu(index, "dish", limit = 0).pairs().none { it.first == 3 })
+            externalFunctions.updateMenuSearchIndex(index, 3, null)
+            assertTrue(externalFunctions.searchMenu(index, "truffle").isEmpty())
+            assertEquals(restaurants.sumOf { it.menu.size } - 12, index.menuItemCount)
+        }
+    }
+
+    /**
+     * Each menu item used to pin several local references until the call returned; with a 100k-item menu
+     * that overflows the local reference table on runtimes that cap it. Refs are now released per chunk.
+     */
+    @Test
+    fun hundredThousandItemMenuSerializesWithBoundedLocalRefs() {
+        val huge = SyntheticRestaurants.restaurant(1, menuSize = 100_000)
+
+        val json = assertLocalRefsBounded { externalFunctions.serializeRestaurant(huge) }
+
+        assertEquals(100_000, Regex("\"price\":").findAll(json).count())
+        assertTrue(json.endsWith("]}"))
+    }
+
+    @Test
+    fun largeBatchSerializesWithBoundedLocalRefs() {
+        val restaurants = SyntheticRestaurants.restaurants(20_000, menuSize = 5)
+
+        val ndjson = assertLocalRefsBounded { externalFunctions.serializeRestaurants(restaurants, ndjson = true) }
+
+        assertEquals(20_000, ndjson.count { it == '\n' })
+    }
+
+    /**
+     * Runs block and checks, through the instrumented build's live local reference count, that it never held more
+     * than LOCAL_REF_BUDGET references at once. ART's local reference table is large enough that a leak of one
+     * reference per element would not fail the call itself, so without instrumentation the check is skipped.
+     */
+    private fun <T> assertLocalRefsBounded(block: () -> T): T {
+        externalFunctions.resetNativeStats()
+        val result = block()
+        val stats = externalFunctions.getNativeStats()
+        assumeTrue("Local reference peaks need a -PnativeInstrumentation build", stats.enabled)
+        assertTrue("Peak of ${stats.localRefsPeak} local references", stats.localRefsPeak in 1..LOCAL_REF_BUDGET)
+        return result
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun serializeIntoHeapBufferIsRejected() {
+        externalFunctions.serializeRestaurantInto(restaurant, ByteBuffer.allocate(1024))
+    }
+
+    private companion object {
+        /** Chunked frames keep a few hundred references at most; a per-element leak reaches the element count. */
+        const val LOCAL_REF_BUDGET = 1_000L
+    }
+}
@@ -0,0 +1,404 @@
+package com.voidmemories.restaurant_serializer
+
+import android.util.Log
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.Assert.assertEquals
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.File
+import java.io.FileWriter
+import java.time.DayOfWeek
+import java.time.LocalTime
+
+/**
+ * Coarse timing of the native serializer entry points, reported through logcat (tag "SerializerBenchmark").
+ * Run with: ./gradlew connectedAndroidTest
+ */
+@RunWith(AndroidJUnit4::class)
+class SerializerBenchmarkTest {
+    private val externalFunctions = ExternalFunctions()
+
+    private fun measureNanosPerOp(iterations: Int, block: () -> Unit): Double {
+        repeat(3) { block() } // warm-up
+        val start = System.nanoTime()
+        repeat(iterations) { block() }
+        return (System.nanoTime() - start).toDouble() / iterations
+    }
+
+    private fun measureNanosPerRestaurant(restaurantCount: Int, block: () -> Unit): Double =
+        measureNanosPerOp(maxOf(1, 20_000 / restaurantCount), block) / restaurantCount
+
+    @Test
+    fun batchVersusSingleObject() {
+        for (batchSize in listOf(1, 100, 10_000)) {
+            val restaurants = SyntheticRestaurants.restaurants(batchSize)
+
+            val single = measureNanosPerRestaurant(batchSize) {
+                restaurants.forEach { externalFunctions.serializeRestaurant(it) }
+            }
+            val batch = measureNanosPerRestaurant(batchSize) {
+                externalFunctions.serializeRestaurants(restaurants)
+            }
+            Log.i(TAG, "batch=$batchSize single=%.0f ns/restaurant batched=%.0f ns/restaurant".format(single, batch))
+        }
+    }
+
+    @Test
+    fun encoderThroughput() {
+        val corpora = mapOf(
+            "sample" to SyntheticRestaurants.restaurant(0, menuSize = 2),
+            "menu1k" to SyntheticRestaurants.restaurant(1, menuSize = 1_000),
+            "menu10k" to SyntheticRestaurants.restaurant(2, menuSize = 10_000)
+        )
+        for ((label, restaurant) in corpora) {
+            val bytes = externalFunctions.serializeRestaurant(restaurant).length
+            val nanos = measureNanosPerOp(maxOf(10, 20_000 / (restaurant.menu.size + 1))) {
+                externalFunctions.serializeRestaurant(restaurant)
+            }
+            Log.i(TAG, "$label: %.0f ns/op, %.1f MB/s".format(nanos, bytes * 1_000.0 / nanos))
+        }
+    }
+
+    @Test
+    fun outputFormatSizeAndEncodeTime() {
+        val restaurants = SyntheticRestaurants.restaurants(1_000)
+        for (format in SerializationFormat.values()) {
+            val bytes = restaurants.sumOf { externalFunctions.serializeRestaurant(it, format).size }
+            val nanos = measureNanosPerRestaurant(restaurants.size) {
+                restaurants.forEach { externalFunctions.serializeRestaurant(it, format) }
+            }
+            Log.i(TAG, "format/$format: %d bytes/restaurant, %.0f ns/restaurant".format(bytes / restaurants.size, nanos))
+        }
+    }
+
+    @Test
+    fun deserializerThroughput() {
+        val corpora = mapOf(
+            "typical" to SyntheticRestaurants.restaurant(0),
+            "menu1k" to SyntheticRestaurants.restaurant(1, menuSize = 1_000)
+        )
+        for ((label, restaurant) in corpora) {
+            val json = externalFunctions.serializeRestaurant(restaurant)
+            val bytes = json.toByteArray(Charsets.UTF_8)
+            val buffer = java.nio.ByteBuffer.allocateDirect(bytes.size).put(bytes).also { it.flip() }
+            val iterations = maxOf(10, 20_000 / (restaurant.menu.size + 1))
+
+            val native = measureNanosPerOp(iterations) { externalFunctions.deserializeRestaurant(buffer) }
+            val orgJson = measureNanosPerOp(iterations) { org.json.JSONObject(json) }
+            Log.i(TAG, "decode/$label: native %.1f MB/s, org.json (tree only) %.1f MB/s".format(
+                bytes.size * 1_000.0 / native, bytes.size * 1_000.0 / orgJson))
+        }
+    }
+
+    @Test
+    fun cachedVersusUncachedSerialization() {
+        val restaurants = SyntheticRestaurants.restaurants(1_000)
+        val uncached = measureNanosPerRestaurant(restaurants.size) {
+            restaurants.forEach { externalFunctions.serializeRestaurant(it) }
+        }
+        try {
+            // Every restaurant and fragment lookup misses: the cache is emptied before each call
+            val missed = measureNanosPerRestaurant(restaurants.size) {
+                restaurants.forEach {
+                    externalFunctions.setSerializationCacheCapacity(0)
+                    externalFunctions.setSerializationCacheCapacity(64L shl 20)
+                    externalFunctions.serializeRestaurant(it)
+                }
+            }
+            val cached = measureNanosPerRestaurant(restaurants.size) {
+                restaurants.forEach { externalFunctions.serializeRestaurant(it) }
+            }
+            Log.i(TAG, "cache: uncached=%.0f ns/restaurant miss=%.0f ns/restaurant hit=%.0f ns/restaurant %s".format(
+                uncached, missed, cached, externalFunctions.getSerializationCacheStats()))
+        } finally {
+            externalFunctions.setSerializationCacheCapacity(0)
+        }
+    }
+
+    @Test
+    fun stringDeduplicationTimeAndSize() {
+        val restaurants = SyntheticRestaurants.restaurants(1_000)
+        for (format in SerializationFormat.values()) {
+            var plainSize = 0
+            val plain = measureNanosPerRestaurant(restaurants.size) {
+                plainSize = externalFunctions.serializeRestaurants(restaurants, format).size
+            }
+            try {
+                externalFunctions.setStringDeduplicationEnabled(true)
+                val before = externalFunctions.getStringDeduplicationStats()
+                var deduplicatedSize = 0
+                val deduplicated = measureNanosPerRestaurant(restaurants.size) {
+                    deduplicatedSize = externalFunctions.serializeRestaurants(restaurants, format).size
+                }
+                val after = externalFunctions.getStringDeduplicationStats()
+                Log.i(TAG, "dedup $format: plain=%.0f ns/restaurant %d bytes, deduplicated=%.0f ns/restaurant %d bytes, "
+                        .format(plain, plainSize, deduplicated, deduplicatedSize) +
+                        "hits=%.1f%% identity=%.1f%%".format(
+                            100.0 * (after.hits - before.hits) / (after.lookups - before.lookups),
+                            100.0 * (after.identityHits - before.identityHits) / (after.lookups - before.lookups)))
+            } finally {
+                externalFunctions.setStringDeduplicationEnabled(false)
+            }
+        }
+    }
+
+    @Test
+    fun parallelBatchScaling() {
+        val restaurants = SyntheticRestaurants.restaurants(50_000)
+        val cores = Runtime.getRuntime().availableProcessors()
+        try {
+            for (threads in 1..cores) {
+                externalFunctions.setSerializationThreads(threads)
+                val nanos = measureNanosPerRestaurant(restaurants.size) {
+                    externalFunctions.serializeRestaurants(restaurants, ndjson = true)
+                }
+                Log.i(TAG, "threads=$threads/$cores: %.0f ns/restaurant".format(nanos))
+            }
+        } finally {
+            externalFunctions.setSerializationThreads(1)
+        }
+    }
+
+    @Test
+    fun nativeExportVersusFileWriter() {
+        val restaurants = SyntheticRestaurants.restaurants(20_000)
+        val file = File.createTempFile("export", ".ndjson")
+        try {
+            val viaString = measureNanosPerRestaurant(restaurants.size) {
+                FileWriter(file).use { it.write(externalFunctions.serializeRestaurants(restaurants, ndjson = true)) }
+            }
+            val inline = measureNanosPerRestaurant(restaurants.size) {
+                externalFunctions.exportRestaurants(restaurants, file, overlapIo = false)
+            }
+            val overlapped = measureNanosPerRestaurant(restaurants.size) {
+                externalFunctions.exportRestaurants(restaurants, file)
+            }
+            Log.i(TAG, "export: String+FileWriter=%.0f ns/restaurant native=%.0f native+overlap=%.0f (%d bytes)".format(
+                viaString, inline, overlapped, file.length()))
+        } finally {
+            file.delete()
+        }
+    }
+
+    @Test
+    fun asyncCallerTimeVersusLatency() {
+        val restaurant = SyntheticRestaurants.restaurant(5, menuSize = 2_000)
+        repeat(20) { externalFunctions.serializeRestaurantAsync(restaurant).get() }
+
+        val rounds = 200
+        var callerNanos = 0L
+        var latencyNanos = 0L
+        repeat(rounds) {
+            val start = System.nanoTime()
+            val future = externalFunctions.serializeRestaurantAsync(restaurant)
+            callerNanos += System.nanoTime() - start
+            future.get()
+            latencyNanos += System.nanoTime() - start
+        }
+        val sync = measureNanosPerOp(rounds) { externalFunctions.serializeRestaurant(restaurant) }
+        Log.i(TAG, "async: caller=%.0f ns end-to-end=%.0f ns, sync=%.0f ns".format(
+            callerNanos.toDouble() / rounds, latencyNanos.toDouble() / rounds, sync))
+    }
+
+    @Test
+    fun projectedVersusFullSerialization() {
+        val restaurants = SyntheticRestaurants.restaurants(100)
+        externalFunctions.compileProjection(listOf("id", "name", "rating", "menu.price")).use { projection ->
+            val full = measureNanosPerRestaurant(restaurants.size) {
+                externalFunctions.serializeRestaurants(restaurants)
+            }
+            val projected = measureNanosPerRestaurant(restaurants.size) {
+                externalFunctions.serializeRestaurantsProjected(restaurants, projection)
+            }
+            Log.i(TAG, "projection id,name,rating,menu.price: full=%.0f ns/restaurant projected=%.0f".format(full, projected))
+
+            if (externalFunctions.getNativeStats().enabled) {
+                externalFunctions.resetNativeStats()
+                externalFunctions.serializeRestaurants(restaurants)
+                val fullCalls = externalFunctions.getNativeStats().totalJniCalls
+                externalFunctions.resetNativeStats()
+                externalFunctions.serializeRestaurantsProjected(restaurants, projection)
+                val projectedCalls = externalFunctions.getNativeStats().totalJniCalls
+                Log.i(TAG, "projection JNI calls/restaurant: full=${fullCalls / restaurants.size} " +
+                        "projected=${projectedCalls / restaurants.size}")
+            }
+        }
+    }
+
+    @Test
+    fun nativePhaseBreakdown() {
+        val restaurants = SyntheticRestaurants.restaurants(100)
+        restaurants.forEach { externalFunctions.serializeRestaurant(it) }
+        externalFunctions.resetNativeStats()
+        restaurants.forEach { externalFunctions.serializeRestaurant(it) }
+        val stats = externalFunctions.getNativeStats()
+        if (!stats.enabled) {
+            Log.i(TAG, "phases: build with -PnativeInstrumentation to collect native stats")
+            return
+        }
+        val calls = stats.phases.getValue(NativePhase.CALL).count
+        Log.i(TAG, "per call: %.0f JNI calls %s, %.0f local refs, %.0f bytes".format(
+            stats.totalJniCalls.toDouble() / calls, stats.jniCalls.mapValues { it.value / calls },
+            stats.localRefsCreated.toDouble() / calls, stats.bytesProduced.toDouble() / calls))
+        for ((phase, phaseStats) in stats.phases) {
+            if (phaseStats.count > 0) {
+                Log.i(TAG, "phase $phase: %.0f ns/call, $phaseStats".format(phaseStats.totalNanos.toDouble() / calls))
+            }
+        }
+    }
+
+    @Test
+    fun stringKernelThroughput() {
+        val texts = mapOf(
+            "ascii" to "Slow-cooked beef with roasted vegetables and a red wine sauce. ".repeat(4),
+            "escapeHeavy" to "\"quoted\"\\path\\\t\n<tag attr=\"x\">\r\n".repeat(8),
+            "nonLatin" to "\u725b\u8089\u3068\u91ce\u83dc\u306e\u8d64\u30ef\u30a4\u30f3\u716e\u8fbc\u307f \uD83C\uDF72 ".repeat(16)
+        )
+        for ((label, text) in texts) {
+            val base = SyntheticRestaurants.restaurant(3, menuSize = 500)
+            val restaurant = base.copy(menu = base.menu.map { it.copy(name = text, description = text) })
+            val bytes = externalFunctions.serializeRestaurant(restaurant).toByteArray(Charsets.UTF_8).size
+            val nanos = measureNanosPerOp(200) { externalFunctions.serializeRestaurant(restaurant) }
+            Log.i(TAG, "strings/$label: %.0f ns/op, %.1f MB/s".format(nanos, bytes * 1_000.0 / nanos))
+        }
+    }
+
+    @Test
+    fun fieldReadsVersusGetterCalls() {
+        val restaurants = SyntheticRestaurants.restaurants(1_000)
+        try {
+            for (fieldAccess in listOf(false, true)) {
+                externalFunctions.setFieldAccessEnabled(fieldAccess)
+                val nanos = measureNanosPerRestaurant(restaurants.size) {
+                    externalFunctions.serializeRestaurants(restaurants)
+                }
+                Log.i(TAG, "fieldAccess=$fieldAccess: %.0f ns/restaurant".format(nanos))
+            }
+        } finally {
+            externalFunctions.setFieldAccessEnabled(true)
+        }
+    }
+
+    @Test
+    fun fieldAndGetterModesProduceSameOutput() {
+        val restaurants = SyntheticRestaurants.restaurants(3)
+        try {
+            externalFunctions.setFieldAccessEnabled(false)
+            val viaGetters = externalFunctions.serializeRestaurants(restaurants)
+            externalFunctions.setFieldAccessEnabled(true)
+            assertEquals(viaGetters, externalFunctions.serializeRestaurants(restaurants))
+        } finally {
+            externalFunctions.setFieldAccessEnabled(true)
+        }
+    }
+
+    @Test
+    fun listFastPathAndToArrayProduceSameOutput() {
+        // ArrayList, Arrays$ArrayList and lists the fast path never takes
+        val restaurants = SyntheticRestaurants.restaurants(3).mapIndexed { i, r ->
+            when (i) {
+                0 -> r.copy(cuisines = ArrayList(r.cuisines), menu = r.menu.toMutableList())
+                1 -> r.copy(cuisines = listOf("Thai", "Vegan"), menu = listOf(*r.menu.toTypedArray()))
+                else -> r.copy(cuisines = listOf("Thai"), menu = r.menu.asReversed())
+            }
+        }
+        val restaurantLists = listOf(ArrayList(restaurants), listOf(*restaurants.toTypedArray()))
+        try {
+            externalFunctions.setListFastPathEnabled(false)
+            val viaToArray = restaurantLists.map { externalFunctions.serializeRestaurants(it) }
+            externalFunctions.setListFastPathEnabled(true)
+            assertEquals(viaToArray, restaurantLists.map { externalFunctions.serializeRestaurants(it) })
+        } finally {
+            externalFunctions.setListFastPathEnabled(true)
+        }
+    }
+
+    @Test
+    fun batchOutputMatchesSingleObjectOutput() {
+        val restaurants = SyntheticRestaurants.restaurants(3)
+        val singles = restaurants.map { externalFunctions.serializeRestaurant(it) }
+
+        assertEquals(singles.joinToString(",", "[", "]"), externalFunctions.serializeRestaurants(restaurants))
+        assertEquals(singles.joinToString("") { it + "\n" }, externalFunctions.serializeRestaurants(restaurants, ndjson = true))
+        assertEquals("[]", externalFunctions.serializeRestaurants(emptyList()))
+    }
+
+    @Test
+    fun parallelBatchMatchesSequentialOutput() {
+        val restaurants = SyntheticRestaurants.restaurants(1_000) +
+            SyntheticRestaurants.restaurant(1_000, menuSize = 20_000) + SyntheticRestaurants.restaurants(100)
+        val sequential = externalFunctions.serializeRestaurants(restaurants)
+        val sequentialNdjson = externalFunctions.serializeRestaurants(restaurants, ndjson = true)
+        try {
+            externalFunctions.setSerializationThreads(4)
+            assertEquals(sequential, externalFunctions.serializeRestaurants(restaurants))
+            assertEquals(sequentialNdjson, externalFunctions.serializeRestaurants(restaurants, ndjson = true))
+        } finally {
+            externalFunctions.setSerializationThreads(1)
+        }
+    }
+
+    @Test
+    fun restaurantStoreQueriesVersusKotlinFilters() {
+        val restaurants = SyntheticRestaurants.restaurants(50_000) // 1M menu items
+        val cheap = MenuItemFilter(priceBelow = 10.0)
+        val filter = RestaurantFilter(minRating = 4.0, cuisine = restaurants[0].cuisines[0], menuItem = cheap)
+        externalFunctions.loadRestaurantStore(restaurants).use { store ->
+            val kotlin = measureNanosPerOp(5) {
+                restaurants.filter { r ->
+                    r.rating >= 4.0 && filter.cuisine in r.cuisines && r.menu.any { it.price < 10.0 }
+                }
+            }
+            val native = measureNanosPerOp(20) { externalFunctions.filterRestaurants(store, filter) }
+            val items = measureNanosPerOp(20) { externalFunctions.filterMenuItems(store, cheap) }
+            val summary = measureNanosPerOp(20) { externalFunctions.summarizeMenuPrices(store) }
+            Log.i(TAG, "1M menu items (%d KB native): kotlin filter=%.2f ms, store filter=%.2f ms"
+                .format(store.memoryBytes / 1024, kotlin / 1e6, native / 1e6))
+            Log.i(TAG, "1M menu items: menu item filter=%.2f ms, price summary=%.2f ms".format(items / 1e6, summary / 1e6))
+        }
+    }
+
+    @Test
+    fun openNowIndexVersusKotlinCheck() {
+        val restaurants = SyntheticRestaurants.restaurants(10_000, menuSize = 1)
+        val day = DayOfWeek.FRIDAY
+        val time = LocalTime.of(22, 15)
+        externalFunctions.loadOpeningHoursIndex(restaurants).use { index ->
+            val kotlin = measureNanosPerOp(20) {
+                restaurants.indices.filter { i ->
+                    restaurants[i].openingHours.any { it.dayOfWeek == day && time >= it.openTime && time < it.closeTime }
+                }
+            }
+            val native = measureNanosPerOp(200) { externalFunctions.restaurantsOpenAt(index, day, time) }
+            val next = measureNanosPerOp(200) { externalFunctions.minutesUntilOpen(index, day, time) }
+            Log.i(TAG, "open now, 10k restaurants (%d KB index): kotlin=%.0f us index=%.0f us next opening=%.0f us"
+                .format(index.memoryBytes / 1024, kotlin / 1e3, native / 1e3, next / 1e3))
+        }
+    }
+
+    @Test
+    fun menuSearchIndexVersusKotlinScan() {
+        val restaurants = SyntheticRestaurants.restaurants(5_000, menuSize = 20)
+        val query = "dish 17"
+        externalFunctions.loadMenuSearchIndex(restaurants).use { index ->
+            val kotlin = measureNanosPerOp(5) {
+                restaurants.flatMapIndexed { r, restaurant ->
+                    restaurant.menu.indices.filter { m ->
+                        val item = restaurant.menu[m]
+                        item.name.contains(query, ignoreCase = true) ||
+                            item.description?.contains(query, ignoreCase = true) == true
+                    }.map { r to it }
+                }
+            }
+            val native = measureNanosPerOp(50) { externalFunctions.searchMenu(index, query, limit = 0) }
+            val edit = restaurants[42].copy(menu = restaurants[42].menu.drop(1))
+            val update = measureNanosPerOp(50) { externalFunctions.updateMenuSearchIndex(index, 42, edit) }
+            Log.i(TAG, "menu search, 100k items (%d KB index): kotlin=%.0f us index=%.0f us update one menu=%.0f us"
+                .format(index.memoryBytes / 1024, kotlin / 1e3, native / 1e3, update / 1e3))
+        }
+    }
+
+    private companion object {
+        const val TAG = "SerializerBenchmark"
+    }
+}
@@ -0,0 +1,47 @@
+package com.voidmemories.restaurant_serializer
+
+import java.time.DayOfWeek
+import java.time.LocalTime
+import kotlin.random.Random
+
+/**
+ * Seeded generator of synthetic restaurants, so benchmark and stress runs are reproducible.
+ */
+object SyntheticRestaurants {
+    private val cuisines = listOf("American", "Italian", "Thai", "Mexican", "Indian", "Fast Food", "Vegan")
+    private val categories = listOf("Starter", "Main", "Side", "Dessert", "Drink")
+
+    fun restaurant(index: Int, menuSize: Int = 20, random: Random = Random(index)): Restaurant =
+        Restaurant(
+            id = "rest-$index",
+            name = "Synthetic Diner $index",
+            address = Address(
+                street = "${random.nextInt(1, 9999)} Main St",
+                city = "SomeCity",
+                state = "CA",
+                zipCode = random.nextInt(10000, 99999).toString(),
+                country = "USA"
+            ),
+            rating = random.nextDouble(1.0, 5.0),
+            cuisines = List(random.nextInt(1, 4)) { cuisines[random.nextInt(cuisines.size)] },
+            phoneNumber = "555-${random.nextInt(1000, 9999)}",
+            website = "www.diner$index.example.com",
+            openingHours = DayOfWeek.values().map {
+                OpeningHour(it, LocalTime.of(random.nextInt(6, 11), 0), LocalTime.of(random.nextInt(18, 23), 30))
+            },
+            menu = List(menuSize) { item ->
+                MenuItem(
+                    id = "menu-$index-$item",
+                    name = "Dish $item",
+                    description = "Freshly prepared dish number $item",
+                    price = random.nextDouble(1.0, 40.0),
+                    category = categories[random.nextInt(categories.size)]
+                )
+            }
+        )
+
+    fun restaurants(count: Int, menuSize: Int = 20, seed: Int = 42): List<Restaurant> {
+        val random = Random(seed)
+        return List(count) { restaurant(it, menuSize, random) }
+    }
+}
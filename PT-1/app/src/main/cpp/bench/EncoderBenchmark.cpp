@@ -0,0 +1,428 @@
+/**
+ * Native-only benchmarks of the encoder layer (no JVM): JSON, CBOR and MessagePack encoding (also with a
+ * StringDictionary), fingerprinting and JSON scanning over seeded synthetic corpora shaped like the Restaurant model,
+ * plus the filter and aggregate queries of a RestaurantColumns store and the searches of a TrigramIndex, each over
+ * 1M menu items.
+ *
+ * Each corpus is recorded once onto an EventTape, so every benchmark replays exactly the events the model
+ * traversal would produce and measures the encoder alone. Build and run (Linux):
+ *
+ *   cmake -S app/src/main/cpp -B build-host -DCMAKE_BUILD_TYPE=Release
+ *   cmake --build build-host --target encoder-benchmark
+ *   build-host/encoder-benchmark --benchmark_out=encoder.json --benchmark_out_format=json
+ */
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include "../core/BinaryEncoders.h"
+#include "../core/EventTape.h"
+#include "../core/Fingerprint.h"
+#include "../core/JsonEncoder.h"
+#include "../core/JsonReader.h"
+#include "../core/JsonWriter.h"
+#include "../core/RestaurantColumns.h"
+#include "../core/StringDictionary.h"
+#include "../core/TrigramIndex.h"
+
+namespace {
+
+enum class TextStyle { Plain, Unicode, Escapes };
+
+struct CorpusSpec {
+    const char* name;
+    int restaurants;
+    int menuSize;
+    TextStyle style;
+};
+
+// The same five corpora as the JVM benchmark (bench/jvm/HostBenchmark.kt)
+constexpr CorpusSpec kCorpora[] = {
+        {"tiny", 1, 1, TextStyle::Plain},
+        {"typical", 100, 20, TextStyle::Plain},
+        {"menu1k", 1, 1000, TextStyle::Plain},
+        {"unicode", 100, 20, TextStyle::Unicode},
+        {"escapes", 100, 20, TextStyle::Escapes},
+};
+
+constexpr uint32_t kSeed = 42;
+
+struct Corpus {
+    EventTape tape;
+    int restaurants = 0;
+};
+
+const char16_t* const kPlainWords[] = {u"slow", u"cooked", u"beef", u"with", u"roasted", u"vegetables", u"sauce"};
+const char16_t* const kUnicodeWords[] = {u"牛肉", u"野菜", u"café", u"борщ",
+                                         u"\U0001F372", u"赤ワイン", u"crème"};
+const char16_t* const kEscapeWords[] = {u"\"quoted\"", u"back\\slash", u"tab\t", u"line\n", u"<tag attr=\"x\">",
+                                        u"\r\n", u"\u0001ctl"};
+
+std::u16string words(std::mt19937& random, TextStyle style, int count) {
+    const char16_t* const* vocabulary = style == TextStyle::Unicode   ? kUnicodeWords
+                                        : style == TextStyle::Escapes ? kEscapeWords
+                                                                      : kPlainWords;
+    std::u16string text;
+    for (int i = 0; i < count; i++) {
+        if (i > 0) text += u' ';
+        text += vocabulary[random() % 7];
+    }
+    return text;
+}
+
+std::u16string ascii(const std::string& text) {
+    return std::u16string(text.begin(), text.end());
+}
+
+void string(EventTape& tape, const std::u16string& text) {
+    tape.string(text.data(), text.size());
+}
+
+void plain(EventTape& tape, const char* text) {
+    tape.plainString(text, std::strlen(text));
+}
+
+// Mirrors the traversal of RestaurantModel: same keys, same order, same value kinds
+void recordRestaurant(EventTape& tape, std::mt19937& random, int index, const CorpusSpec& spec) {
+    static const char* const kDays[] = {"MONDAY", "TUESDAY", "WEDNESDAY", "THURSDAY", "FRIDAY", "SATURDAY", "SUNDAY"};
+    std::uniform_real_distribution<double> rating(1.0, 5.0);
+    std::uniform_real_distribution<double> price(1.0, 40.0);
+
+    tape.beginObject(9);
+    tape.key("id");
+    string(tape, ascii("rest-" + std::to_string(index)));
+    tape.key("name");
+    string(tape, words(random, spec.style, 3));
+    tape.key("address");
+    tape.beginObject(5);
+    tape.key("street");
+    string(tape, ascii(std::to_string(random() % 9999) + " Main St"));
+    tape.key("city");
+    string(tape, u"SomeCity");
+    tape.key("state");
+    string(tape, u"CA");
+    tape.key("zipCode");
+    string(tape, ascii(std::to_string(10000 + random() % 90000)));
+    tape.key("country");
+    string(tape, u"USA");
+    tape.endObject();
+    tape.key("rating");
+    tape.number(rating(random));
+    tape.key("cuisines");
+    tape.beginArray(2);
+    string(tape, words(random, spec.style, 1));
+    string(tape, words(random, spec.style, 1));
+    tape.endArray();
+    tape.key("phoneNumber");
+    string(tape, ascii("555-" + std::to_string(1000 + random() % 9000)));
+    tape.key("website");
+    string(tape, ascii("www.diner" + std::to_string(index) + ".example.com"));
+    tape.key("openingHours");
+    tape.beginArray(7);
+    for (const char* day : kDays) {
+        tape.beginObject(3);
+        tape.key("dayOfWeek");
+        plain(tape, day);
+        tape.key("openTime");
+        plain(tape, "09:00");
+        tape.key("closeTime");
+        plain(tape, "22:30");
+        tape.endObject();
+    }
+    tape.endArray();
+    tape.key("menu");
+    tape.beginArray(static_cast<size_t>(spec.menuSize));
+    for (int item = 0; item < spec.menuSize; item++) {
+        tape.beginObject(5);
+        tape.key("id");
+        string(tape, ascii("menu-" + std::to_string(index) + "-" + std::to_string(item)));
+        tape.key("name");
+        string(tape, words(random, spec.style, 2));
+        tape.key("description");
+        string(tape, words(random, spec.style, 8));
+        tape.key("price");
+        tape.number(price(random));
+        tape.key("category");
+        string(tape, words(random, spec.style, 1));
+        tape.endObject();
+    }
+    tape.endArray();
+    tape.endObject();
+}
+
+// Recorded on first use, so a filtered run only builds the corpora it needs
+const Corpus& corpus(size_t index) {
+    static Corpus corpora[std::size(kCorpora)];
+    const CorpusSpec& spec = kCorpora[index];
+    Corpus& result = corpora[index];
+    if (result.restaurants == 0) {
+        std::mt19937 random(kSeed);
+        for (int i = 0; i < spec.restaurants; i++) {
+            recordRestaurant(result.tape, random, i, spec);
+        }
+        result.restaurants = spec.restaurants;
+    }
+    return result;
+}
+
+std::string encodeJson(const Corpus& input) {
+    JsonWriter writer;
+    JsonEncoder encoder(writer);
+    input.tape.replay(0, input.tape.size(), encoder);
+    return std::string(writer.data(), writer.size());
+}
+
+void reportPerRestaurant(benchmark::State& state, const Corpus& input, size_t bytesPerIteration) {
+    state.SetItemsProcessed(state.iterations() * input.restaurants);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytesPerIteration));
+    state.counters["bytes_per_op"] = static_cast<double>(bytesPerIteration) / input.restaurants;
+}
+
+template <typename Encoder>
+void encode(benchmark::State& state, size_t corpusIndex) {
+    const Corpus& input = corpus(corpusIndex);
+    JsonWriter out;
+    for (auto _ : state) {
+        out.clear();
+        Encoder encoder(out);
+        input.tape.replay(0, input.tape.size(), encoder);
+        benchmark::DoNotOptimize(out.data());
+    }
+    reportPerRestaurant(state, input, out.size());
+}
+
+// A fresh StringDictionary per iteration, as in one native batch call; CBOR wraps the corpus in a stringref
+// namespace around one array
+template <typename Encoder>
+void encodeDeduplicated(benchmark::State& state, size_t corpusIndex) {
+    const Corpus& input = corpus(corpusIndex);
+    JsonWriter out;
+    StringDictionary::Stats stats{};
+    for (auto _ : state) {
+        out.clear();
+        StringDictionary strings;
+        Encoder encoder(out, &strings);
+        if constexpr (std::is_same_v<Encoder, binary::CborEncoder>) {
+            binary::CborEncoder::writeStringRefNamespace(out);
+            encoder.beginArray(static_cast<size_t>(input.restaurants));
+        }
+        input.tape.replay(0, input.tape.size(), encoder);
+        stats = strings.stats();
+        benchmark::DoNotOptimize(out.data());
+    }
+    reportPerRestaurant(state, input, out.size());
+    state.counters["hit_rate"] = stats.lookups ? static_cast<double>(stats.hits) / stats.lookups : 0.0;
+}
+
+// The serialization cache's fingerprint: record each restaurant onto a tape and hash the recorded bytes
+void fingerprintCorpus(benchmark::State& state, size_t corpusIndex) {
+    const Corpus& input = corpus(corpusIndex);
+    EventTape tape;
+    for (auto _ : state) {
+        tape.clear();
+        input.tape.replay(0, input.tape.size(), tape);
+        fingerprint::XxHash64 hash;
+        hash.update(tape.bytes(0), tape.size());
+        benchmark::DoNotOptimize(hash.digest());
+    }
+    reportPerRestaurant(state, input, encodeJson(input).size());
+}
+
+// A SerializationCache miss without the JNI reads, which it shares with encode_json: record, fingerprint, then
+// replay the tape into the encoder. The difference to encode_json is all the cache adds to a miss.
+void encodeCacheMiss(benchmark::State& state, size_t corpusIndex) {
+    const Corpus& input = corpus(corpusIndex);
+    JsonWriter out;
+    EventTape tape;
+    for (auto _ : state) {
+        out.clear();
+        tape.clear();
+        input.tape.replay(0, input.tape.size(), tape);
+        fingerprint::XxHash64 hash;
+        hash.update(tape.bytes(0), tape.size());
+        benchmark::DoNotOptimize(hash.digest());
+        JsonEncoder encoder(out);
+        tape.replay(0, tape.size(), encoder);
+        benchmark::DoNotOptimize(out.data());
+    }
+    reportPerRestaurant(state, input, out.size());
+}
+
+void scanJson(benchmark::State& state, size_t corpusIndex) {
+    const Corpus& input = corpus(corpusIndex);
+    std::string json = encodeJson(input);
+    for (auto _ : state) {
+        JsonReader reader(json.data(), json.size());
+        for (int i = 0; i < input.restaurants; i++) {
+            if (i > 0) reader.expect(',');
+            reader.skipValue();
+        }
+        reader.expectEnd();
+    }
+    reportPerRestaurant(state, input, json.size());
+}
+
+// 50,000 restaurants of 20 menu items, as in SerializerBenchmarkTest.restaurantStoreQueriesVersusKotlinFilters
+const columns::RestaurantColumns& columnStore() {
+    static const auto store = [] {
+        static const char* const kCuisines[] = {"American", "Italian", "Thai", "Mexican",
+                                                "Indian", "Fast Food", "Vegan"};
+        static const char* const kCategories[] = {"Starter", "Main", "Side", "Dessert", "Drink"};
+        std::mt19937 random(kSeed);
+        std::uniform_real_distribution<double> rating(1.0, 5.0);
+        std::uniform_real_distribution<double> price(1.0, 40.0);
+        auto table = std::make_unique<columns::RestaurantColumns>();
+        for (int i = 0; i < 50'000; i++) {
+            table->addRestaurant(rating(random));
+            for (uint32_t c = 1 + random() % 3; c > 0; c--) {
+                table->addCuisine(kCuisines[random() % 7]);
+            }
+            for (int item = 0; item < 20; item++) {
+                table->addMenuItem(price(random), std::string_view(kCategories[random() % 5]));
+            }
+        }
+        return table;
+    }();
+    return *store;
+}
+
+const columns::MenuItemFilter kCheapItems{-std::numeric_limits<double>::infinity(), 10.0, std::nullopt};
+
+void reportPerMenuItem(benchmark::State& state, const columns::RestaurantColumns& store, size_t matches) {
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * store.menuItemCount()));
+    state.counters["matches"] = static_cast<double>(matches);
+}
+
+void filterColumnRestaurants(benchmark::State& state) {
+    const columns::RestaurantColumns& store = columnStore();
+    columns::RestaurantFilter filter{4.0, std::numeric_limits<double>::infinity(), "Thai", kCheapItems};
+    size_t matches = 0;
+    for (auto _ : state) {
+        matches = store.filterRestaurants(filter).size();
+    }
+    reportPerMenuItem(state, store, matches);
+}
+
+void filterColumnMenuItems(benchmark::State& state) {
+    const columns::RestaurantColumns& store = columnStore();
+    size_t matches = 0;
+    for (auto _ : state) {
+        matches = store.filterMenuItems(kCheapItems).size() / 2;
+    }
+    reportPerMenuItem(state, store, matches);
+}
+
+void summarizeColumnPrices(benchmark::State& state) {
+    const columns::RestaurantColumns& store = columnStore();
+    size_t matches = 0;
+    for (auto _ : state) {
+        matches = store.summarizePrices(columns::MenuItemFilter{}, 10).count;
+    }
+    reportPerMenuItem(state, store, matches);
+}
+
+// 50,000 restaurants of 20 menu items named "<style> <dish>" and described "<dish> with <side>"
+std::u16string menuWords(std::initializer_list<const char*> words) {
+    std::string joined;
+    for (const char* word : words) {
+        joined += joined.empty() ? "" : " ";
+        joined += word;
+    }
+    return std::u16string(joined.begin(), joined.end());
+}
+
+search::TrigramIndex& menuSearchIndex() {
+    static const auto index = [] {
+        static const char* const kStyles[] = {"Spicy", "Grilled", "Crispy", "Smoked", "Classic", "Vegan", "Garlic"};
+        static const char* const kDishes[] = {"Chicken Wings", "Margherita Pizza", "Pad Thai", "Burrito",
+                                              "Tikka Masala", "Cheeseburger", "Caesar Salad", "Ramen", "Tacos"};
+        static const char* const kSides[] = {"fries", "rice", "naan", "slaw", "salsa"};
+        std::mt19937 random(kSeed);
+        auto built = std::make_unique<search::TrigramIndex>();
+        search::MenuText menu;
+        for (uint32_t restaurant = 0; restaurant < 50'000; restaurant++) {
+            menu.clear();
+            for (uint32_t item = 0; item < 20; item++) {
+                const char* dish = kDishes[random() % 9];
+                std::u16string name = menuWords({kStyles[random() % 7], dish});
+                std::u16string description = menuWords({dish, "with", kSides[random() % 5]});
+                menu.addItem(item, name.data(), name.size());
+                menu.setDescription(description.data(), description.size());
+            }
+            built->replaceRestaurant(restaurant, menu);
+        }
+        return built;
+    }();
+    return *index;
+}
+
+void searchMenu(benchmark::State& state, const char16_t* query, bool prefix) {
+    const search::TrigramIndex& index = menuSearchIndex();
+    std::u16string text(query);
+    size_t matches = 0;
+    for (auto _ : state) {
+        matches = index.search(text.data(), text.size(), prefix, 50).size();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * index.documentCount()));
+    state.counters["matches"] = static_cast<double>(matches);
+}
+
+// Replaces one restaurant's 20 items, as an edit of its menu would
+void updateMenuSearch(benchmark::State& state) {
+    search::TrigramIndex& index = menuSearchIndex();
+    search::MenuText menu;
+    std::u16string name = menuWords({"Truffle", "Ramen"});
+    std::u16string description = menuWords({"Ramen", "with", "egg"});
+    for (uint32_t item = 0; item < 20; item++) {
+        menu.addItem(item, name.data(), name.size());
+        menu.setDescription(description.data(), description.size());
+    }
+    uint32_t restaurant = 0;
+    for (auto _ : state) {
+        index.replaceRestaurant(restaurant, menu);
+        restaurant = (restaurant + 7919) % 50'000;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+void registerAll() {
+    for (size_t i = 0; i < std::size(kCorpora); i++) {
+        std::string suffix = std::string("/") + kCorpora[i].name;
+        benchmark::RegisterBenchmark(("encode_json" + suffix).c_str(), encode<JsonEncoder>, i);
+        benchmark::RegisterBenchmark(("encode_cbor" + suffix).c_str(), encode<binary::CborEncoder>, i);
+        benchmark::RegisterBenchmark(("encode_msgpack" + suffix).c_str(), encode<binary::MsgPackEncoder>, i);
+        benchmark::RegisterBenchmark(("encode_json_dedup" + suffix).c_str(), encodeDeduplicated<JsonEncoder>, i);
+        benchmark::RegisterBenchmark(("encode_cbor_stringref" + suffix).c_str(),
+                                     encodeDeduplicated<binary::CborEncoder>, i);
+        benchmark::RegisterBenchmark(("encode_msgpack_dedup" + suffix).c_str(),
+                                     encodeDeduplicated<binary::MsgPackEncoder>, i);
+        benchmark::RegisterBenchmark(("encode_json_cache_miss" + suffix).c_str(), encodeCacheMiss, i);
+        benchmark::RegisterBenchmark(("fingerprint" + suffix).c_str(), fingerprintCorpus, i);
+        benchmark::RegisterBenchmark(("scan_json" + suffix).c_str(), scanJson, i);
+    }
+    benchmark::RegisterBenchmark("column_filter_restaurants/menu1m", filterColumnRestaurants);
+    benchmark::RegisterBenchmark("column_filter_menu_items/menu1m", filterColumnMenuItems);
+    benchmark::RegisterBenchmark("column_price_summary/menu1m", summarizeColumnPrices);
+    benchmark::RegisterBenchmark("menu_search_substring/menu1m", searchMenu, u"tikka mas", false);
+    benchmark::RegisterBenchmark("menu_search_prefix/menu1m", searchMenu, u"chick", true);
+    benchmark::RegisterBenchmark("menu_search_update/menu1m", updateMenuSearch);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    registerAll();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,128 @@
+package com.voidmemories.restaurant_serializer.bench
+
+import com.voidmemories.restaurant_serializer.ExternalFunctions
+import com.voidmemories.restaurant_serializer.Restaurant
+import com.voidmemories.restaurant_serializer.SyntheticRestaurants
+import java.io.File
+import java.lang.management.ManagementFactory
+import java.util.Locale
+import kotlin.random.Random
+
+/**
+ * Desktop JVM benchmark of [ExternalFunctions.serializeRestaurant] over seeded synthetic corpora, the same five as
+ * the native encoder benchmark (EncoderBenchmark.cpp). Run it with the run-jvm-benchmark CMake target, which loads
+ * the host build of restaurant-lib and the jni-call-counter agent; results are written as JSON to the first
+ * argument (default jvm-benchmark.json) for regression gating.
+ *
+ * Per serialized restaurant it reports ns/op, UTF-8 output bytes/op, bytes allocated on the Java heap by the calling
+ * thread (the result String plus whatever the JNI calls allocate), and JNI calls (null without the agent).
+ */
+object JniCallCounter {
+    val available: Boolean =
+        System.getProperty("jni.counter")?.let { runCatching { System.load(it) }.isSuccess } ?: false
+
+    @JvmStatic
+    external fun callsOnThisThread(): Long
+}
+
+private val unicodeWords = listOf("牛肉", "野菜", "café", "борщ",
+    "🍲", "赤ワイン", "crème")
+private val escapeWords = listOf("\"quoted\"", "back\\slash", "tab\t", "line\n", "<tag attr=\"x\">", "\r\n", "\u0001ctl")
+
+private const val WARMUP_NANOS = 2_000_000_000L
+private const val MEASURE_NANOS = 3_000_000_000L
+
+private fun text(random: Random, words: List<String>, count: Int): String =
+    List(count) { words[random.nextInt(words.size)] }.joinToString(" ")
+
+/**
+ * Replaces every free-text field with words drawn from [words].
+ */
+private fun restyle(restaurants: List<Restaurant>, words: List<String>, seed: Int): List<Restaurant> {
+    val random = Random(seed)
+    return restaurants.map { restaurant ->
+        restaurant.copy(
+            name = text(random, words, 3),
+            cuisines = restaurant.cuisines.map { text(random, words, 1) },
+            menu = restaurant.menu.map {
+                it.copy(name = text(random, words, 2), description = text(random, words, 8), category = text(random, words, 1))
+            }
+        )
+    }
+}
+
+private fun corpora(): Map<String, List<Restaurant>> = linkedMapOf(
+    "tiny" to listOf(SyntheticRestaurants.restaurant(0, menuSize = 1)),
+    "typical" to SyntheticRestaurants.restaurants(100),
+    "menu1k" to listOf(SyntheticRestaurants.restaurant(1, menuSize = 1_000)),
+    "unicode" to restyle(SyntheticRestaurants.restaurants(100), unicodeWords, seed = 7),
+    "escapes" to restyle(SyntheticRestaurants.restaurants(100), escapeWords, seed = 11)
+)
+
+private class Result(
+    val corpus: String,
+    val nsPerOp: Double,
+    val bytesPerOp: Double,
+    val allocatedBytesPerOp: Double,
+    val jniCallsPerOp: Double?
+) {
+    fun toJson(): String =
+        """{"corpus":"$corpus","ns_per_op":%.1f,"bytes_per_op":%.1f,"allocated_bytes_per_op":%.1f,"jni_calls_per_op":%s}"""
+            .format(Locale.ROOT, nsPerOp, bytesPerOp, allocatedBytesPerOp,
+                jniCallsPerOp?.let { "%.1f".format(Locale.ROOT, it) } ?: "null")
+}
+
+private fun measure(functions: ExternalFunctions, corpus: String, restaurants: List<Restaurant>): Result {
+    val warmupEnd = System.nanoTime() + WARMUP_NANOS
+    while (System.nanoTime() < warmupEnd) {
+        restaurants.forEach { functions.serializeRestaurant(it) }
+    }
+    val bytes = restaurants.sumOf { functions.serializeRestaurant(it).toByteArray(Charsets.UTF_8).size.toLong() }
+
+    val threads = ManagementFactory.getThreadMXBean() as com.sun.management.ThreadMXBean
+    val threadId = Thread.currentThread().id
+    var ops = 0L
+    var sink = 0L
+    val allocatedBefore = threads.getThreadAllocatedBytes(threadId)
+    val callsBefore = if (JniCallCounter.available) JniCallCounter.callsOnThisThread() else 0L
+    val start = System.nanoTime()
+    val deadline = start + MEASURE_NANOS
+    do {
+        for (restaurant in restaurants) {
+            sink += functions.serializeRestaurant(restaurant).length
+        }
+        ops += restaurants.size
+    } while (System.nanoTime() < deadline)
+    val elapsed = System.nanoTime() - start
+    val calls = if (JniCallCounter.available) JniCallCounter.callsOnThisThread() - callsBefore else null
+    val allocated = threads.getThreadAllocatedBytes(threadId) - allocatedBefore
+    check(sink > 0)
+
+    return Result(
+        corpus = corpus,
+        nsPerOp = elapsed.toDouble() / ops,
+        bytesPerOp = bytes.toDouble() / restaurants.size,
+        allocatedBytesPerOp = allocated.toDouble() / ops,
+        jniCallsPerOp = calls?.let { it.toDouble() / ops }
+    )
+}
+
+fun main(args: Array<String>) {
+    val output = File(args.getOrElse(0) { "jvm-benchmark.json" })
+    val functions = ExternalFunctions()
+
+    val results = corpora().map { (name, restaurants) -> measure(functions, name, restaurants) }
+    for (result in results) {
+        println("%-8s %10.0f ns/op %9.0f B/op %9.0f alloc B/op %8s JNI calls/op".format(
+            result.corpus, result.nsPerOp, result.bytesPerOp, result.allocatedBytesPerOp,
+            result.jniCallsPerOp?.let { "%.0f".format(it) } ?: "n/a"))
+    }
+
+    val environment = """{"vm":"%s %s","os":"%s %s","cpus":%d}""".format(Locale.ROOT,
+        System.getProperty("java.vm.name"), System.getProperty("java.vm.version"),
+        System.getProperty("os.name"), System.getProperty("os.arch"), Runtime.getRuntime().availableProcessors())
+    output.writeText(results.joinToString(",\n    ", """{"environment":$environment,"results":[""" + "\n    ", "\n]}\n") {
+        it.toJson()
+    })
+    println("Results written to ${output.absolutePath}")
+}
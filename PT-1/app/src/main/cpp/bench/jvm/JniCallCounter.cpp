@@ -0,0 +1,122 @@
+/**
+ * JVMTI agent for the desktop benchmark: counts the JNI calls each thread makes.
+ *
+ * Loaded with -agentpath. Once the VM is initialised it replaces the JNI function table with one whose entries for
+ * the functions restaurant-lib uses bump a thread-local counter and then call the original. The benchmark reads
+ * its own thread's count through JniCallCounter.callsOnThisThread() (see HostBenchmark.kt), so calls made by JDK
+ * internals on other threads do not show up.
+ */
+#include <jni.h>
+#include <jvmti.h>
+
+#include <cstdint>
+
+namespace {
+
+JNINativeInterface_ original;
+thread_local int64_t callsOnThisThread = 0;
+
+template <auto Slot, typename Function>
+struct Counted;
+
+template <auto Slot, typename Result, typename... Args>
+struct Counted<Slot, Result(JNICALL*)(JNIEnv*, Args...)> {
+    static Result JNICALL call(JNIEnv* env, Args... args) {
+        callsOnThisThread++;
+        return (original.*Slot)(env, args...);
+    }
+};
+
+#define COUNT_JNI_CALL(name) \
+    table->name = &Counted<&JNINativeInterface_::name, decltype(JNINativeInterface_::name)>::call
+
+void countCalls(JNINativeInterface_* table) {
+    // Field reads and getter calls; the variadic Call*Method forms go through the V variants
+    COUNT_JNI_CALL(GetObjectField);
+    COUNT_JNI_CALL(GetBooleanField);
+    COUNT_JNI_CALL(GetByteField);
+    COUNT_JNI_CALL(GetIntField);
+    COUNT_JNI_CALL(GetLongField);
+    COUNT_JNI_CALL(GetDoubleField);
+    COUNT_JNI_CALL(CallObjectMethodV);
+    COUNT_JNI_CALL(CallObjectMethodA);
+    COUNT_JNI_CALL(CallBooleanMethodV);
+    COUNT_JNI_CALL(CallByteMethodV);
+    COUNT_JNI_CALL(CallIntMethodV);
+    COUNT_JNI_CALL(CallLongMethodV);
+    COUNT_JNI_CALL(CallDoubleMethodV);
+    COUNT_JNI_CALL(CallStaticObjectMethodV);
+    COUNT_JNI_CALL(NewObjectV);
+    COUNT_JNI_CALL(NewObjectA);
+
+    // Strings
+    COUNT_JNI_CALL(GetStringLength);
+    COUNT_JNI_CALL(GetStringRegion);
+    COUNT_JNI_CALL(GetStringCritical);
+    COUNT_JNI_CALL(ReleaseStringCritical);
+    COUNT_JNI_CALL(GetStringChars);
+    COUNT_JNI_CALL(ReleaseStringChars);
+    COUNT_JNI_CALL(GetStringUTFLength);
+    COUNT_JNI_CALL(GetStringUTFChars);
+    COUNT_JNI_CALL(ReleaseStringUTFChars);
+    COUNT_JNI_CALL(NewString);
+    COUNT_JNI_CALL(NewStringUTF);
+
+    // Arrays and buffers
+    COUNT_JNI_CALL(GetArrayLength);
+    COUNT_JNI_CALL(GetObjectArrayElement);
+    COUNT_JNI_CALL(SetObjectArrayElement);
+    COUNT_JNI_CALL(NewObjectArray);
+    COUNT_JNI_CALL(NewByteArray);
+    COUNT_JNI_CALL(SetByteArrayRegion);
+    COUNT_JNI_CALL(GetPrimitiveArrayCritical);
+    COUNT_JNI_CALL(ReleasePrimitiveArrayCritical);
+    COUNT_JNI_CALL(GetDirectBufferAddress);
+    COUNT_JNI_CALL(GetDirectBufferCapacity);
+
+    // References and exceptions
+    COUNT_JNI_CALL(NewLocalRef);
+    COUNT_JNI_CALL(DeleteLocalRef);
+    COUNT_JNI_CALL(PushLocalFrame);
+    COUNT_JNI_CALL(PopLocalFrame);
+    COUNT_JNI_CALL(EnsureLocalCapacity);
+    COUNT_JNI_CALL(NewGlobalRef);
+    COUNT_JNI_CALL(DeleteGlobalRef);
+    COUNT_JNI_CALL(IsSameObject);
+    COUNT_JNI_CALL(ExceptionCheck);
+}
+
+#undef COUNT_JNI_CALL
+
+void JNICALL onVmInit(jvmtiEnv* jvmti, JNIEnv* /*env*/, jthread /*thread*/) {
+    jniNativeInterface* table = nullptr;
+    if (jvmti->GetJNIFunctionTable(&table) != JVMTI_ERROR_NONE) {
+        return;
+    }
+    original = *table;
+    countCalls(table);
+    jvmti->SetJNIFunctionTable(table);
+    jvmti->Deallocate(reinterpret_cast<unsigned char*>(table));
+}
+
+} // namespace
+
+JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM* vm, char* /*options*/, void* /*reserved*/) {
+    jvmtiEnv* jvmti = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&jvmti), JVMTI_VERSION_1_2) != JNI_OK || !jvmti) {
+        return JNI_ERR;
+    }
+    // The function table can only be replaced in the live phase
+    jvmtiEventCallbacks callbacks{};
+    callbacks.VMInit = onVmInit;
+    if (jvmti->SetEventCallbacks(&callbacks, sizeof(callbacks)) != JVMTI_ERROR_NONE ||
+        jvmti->SetEventNotificationMode(JVMTI_ENABLE, JVMTI_EVENT_VM_INIT, nullptr) != JVMTI_ERROR_NONE) {
+        return JNI_ERR;
+    }
+    return JNI_OK;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_voidmemories_restaurant_1serializer_bench_JniCallCounter_callsOnThisThread(JNIEnv* /*env*/, jclass /*clazz*/) {
+    return callsOnThisThread;
+}
@@ -0,0 +1,7 @@
+package android.os
+
+/**
+ * Desktop stand-in for the one android.os class ExternalFunctions refers to, so the app sources compile
+ * for the JVM benchmark. Never instantiated there.
+ */
+class ParcelFileDescriptor private constructor(val fd: Int)
@@ -0,0 +1,91 @@
+#ifdef RESTAURANT_INSTRUMENTATION
+
+#include <cstdlib>
+#include <new>
+#include "NativeStats.h"
+
+/**
+ * Heap allocation counting for instrumented builds, so tests can assert that steady-state calls do not allocate.
+ *
+ * Instrumented builds link restaurant-lib with --wrap=malloc (and calloc, realloc, posix_memalign) and, on
+ * Android, with the static libc++ (ANDROID_STL=c++_static; see CMakeLists.txt). Every call to these functions
+ * from the library's own code and from the libc++ code linked into it, e.g. std::string growth in its explicit
+ * instantiations, lands in the __wrap_ functions below. Allocations inside the JVM and other libraries are not
+ * seen. The operator new replacements route every new through malloc, and -Bsymbolic binds the library's calls
+ * to them rather than to another library's operator new. The aligned overloads keep their default definitions,
+ * which allocate through posix_memalign.
+ */
+
+extern "C" {
+
+void* __real_malloc(std::size_t size);
+void* __real_calloc(std::size_t count, std::size_t size);
+void* __real_realloc(void* memory, std::size_t size);
+int __real_posix_memalign(void** memory, std::size_t alignment, std::size_t size);
+
+void* __wrap_malloc(std::size_t size) {
+    nativestats::NativeStats::countHeapAllocation();
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(std::size_t count, std::size_t size) {
+    nativestats::NativeStats::countHeapAllocation();
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* memory, std::size_t size) {
+    nativestats::NativeStats::countHeapAllocation();
+    return __real_realloc(memory, size);
+}
+
+int __wrap_posix_memalign(void** memory, std::size_t alignment, std::size_t size) {
+    nativestats::NativeStats::countHeapAllocation();
+    return __real_posix_memalign(memory, alignment, size);
+}
+
+} // extern "C"
+
+void* operator new(std::size_t size) {
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+#endif // RESTAURANT_INSTRUMENTATION
@@ -0,0 +1,319 @@
+#ifndef ANDROID_SDK_BINARYENCODERS_H
+#define ANDROID_SDK_BINARYENCODERS_H
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "OutputBuffer.h"
+#include "StringDictionary.h"
+#include "Utf16ToUtf8.h"
+
+/**
+ * Compact binary encoders for the model traversal (see ModelTraversal.h): CBOR (RFC 8949) and MessagePack.
+ *
+ * Both write maps and arrays with definite lengths, keys as text strings and doubles as raw
+ * big-endian IEEE-754 binary64, so no decimal formatting happens on the way out.
+ *
+ * Both accept an optional StringDictionary. MessagePack then copies the bytes of repeated strings instead of
+ * transcoding them; CBOR additionally replaces them with back-references (the stringref extension).
+ */
+namespace binary {
+namespace detail {
+
+inline void storeBigEndian(uint64_t value, int bytes, char* out) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+inline uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * Transcodes UTF-16 text to UTF-8 behind a length header whose size depends on the UTF-8 length.
+ * The header is sized for the worst case first and the text is moved down if the real header is shorter.
+ * @param Format Provides static stringHeaderSize(length) and writeStringHeader(length, out).
+ */
+template <typename Format>
+inline void writeUtf16String(OutputBuffer& buffer, const char16_t* text, size_t length) {
+    size_t maxLength = utf16::maxUtf8Length(length, false);
+    size_t reservedHeader = Format::stringHeaderSize(maxLength);
+    char* out = buffer.reserve(reservedHeader + maxLength);
+    size_t written = utf16::transcode<false>(text, length, out + reservedHeader);
+    size_t header = Format::stringHeaderSize(written);
+    if (header < reservedHeader) {
+        std::memmove(out + header, out + reservedHeader, written);
+    }
+    Format::writeStringHeader(written, out);
+    buffer.advance(header + written);
+}
+
+template <typename Format>
+inline void writeUtf8String(OutputBuffer& buffer, const char* text, size_t length) {
+    size_t header = Format::stringHeaderSize(length);
+    char* out = buffer.reserve(header + length);
+    Format::writeStringHeader(length, out);
+    std::memcpy(out + header, text, length);
+    buffer.advance(header + length);
+}
+
+} // namespace detail
+
+/**
+ * @class CborEncoder
+ * @brief RFC 8949 CBOR: definite-length maps/arrays, text strings, float64, null.
+ *
+ * With a StringDictionary, strings are shared through the stringref extension (tags 256 and 25,
+ * http://cbor.schmorp.de/stringref): every literal string long enough to gain from it joins a table,
+ * and later occurrences are written as tag 25 plus the string's index in that table. The caller opens the
+ * namespace once with writeStringRefNamespace() before the top-level value; one dictionary must see every
+ * string of that value, so rawValue() bytes (cache fragments) cannot be mixed in.
+ */
+class CborEncoder {
+public:
+    explicit CborEncoder(OutputBuffer& buffer, StringDictionary* strings = nullptr)
+            : buffer_(buffer), strings_(strings) {}
+
+    /**
+     * Tag 256: the value that follows is a stringref namespace.
+     */
+    static void writeStringRefNamespace(OutputBuffer& buffer) {
+        buffer.append("\xD9\x01\x00", 3);
+    }
+
+    void beginObject(size_t fieldCount) { writeHead(kMajorMap, fieldCount); }
+    void key(std::string_view name) { plainString(name.data(), name.size()); }
+    void endObject() {}
+
+    void beginArray(size_t elementCount) { writeHead(kMajorArray, elementCount); }
+    void endArray() {}
+
+    void string(const char16_t* text, size_t length) {
+        if (!strings_) {
+            detail::writeUtf16String<CborEncoder>(buffer_, text, length);
+            return;
+        }
+        uint32_t entry = strings_->lookup(text, length);
+        if (entry != StringDictionary::kNone) {
+            repeatString(entry);
+            return;
+        }
+        size_t start = buffer_.size();
+        detail::writeUtf16String<CborEncoder>(buffer_, text, length);
+        const char* encoded = buffer_.data() + start;
+        size_t encodedLength = buffer_.size() - start;
+        uint32_t ref = claimRef(encodedLength - literalHeadSize(encoded[0]));
+        strings_->insert(text, length, encoded, encodedLength, ref);
+    }
+
+    void plainString(const char* text, size_t length) {
+        if (!strings_) {
+            detail::writeUtf8String<CborEncoder>(buffer_, text, length);
+            return;
+        }
+        uint32_t& ref = strings_->utf8RefIndex(std::string_view(text, length));
+        if (ref != StringDictionary::kNone) {
+            writeRef(ref);
+            strings_->addBytesSaved(headSize(length) + length - refSize(ref));
+            return;
+        }
+        detail::writeUtf8String<CborEncoder>(buffer_, text, length);
+        ref = claimRef(length);
+    }
+
+    StringDictionary* stringDictionary() const { return strings_; }
+
+    /**
+     * Writes a dictionary entry again: as a reference once it is in the stringref table, else literally.
+     */
+    void repeatString(uint32_t entry) {
+        std::string_view encoded = strings_->encoded(entry);
+        uint32_t ref = strings_->refIndex(entry);
+        if (ref != StringDictionary::kNone) {
+            writeRef(ref);
+            strings_->addBytesSaved(encoded.size() - refSize(ref));
+            return;
+        }
+        buffer_.append(encoded.data(), encoded.size());
+        strings_->setRefIndex(entry, claimRef(encoded.size() - literalHeadSize(encoded[0])));
+    }
+
+    void number(double value) {
+        char* out = buffer_.reserve(9);
+        out[0] = static_cast<char>(0xFB);
+        detail::storeBigEndian(detail::doubleBits(value), 8, out + 1);
+        buffer_.advance(9);
+    }
+
+    void null() { buffer_.append(static_cast<char>(0xF6)); }
+
+    // One complete, already encoded value (e.g. from the serialization cache)
+    void rawValue(const char* bytes, size_t length) { buffer_.append(bytes, length); }
+
+    static size_t stringHeaderSize(size_t length) { return headSize(length); }
+    static void writeStringHeader(size_t length, char* out) { storeHead(kMajorText, length, out); }
+
+private:
+    static constexpr uint8_t kMajorUnsigned = 0;
+    static constexpr uint8_t kMajorText = 3;
+    static constexpr uint8_t kMajorArray = 4;
+    static constexpr uint8_t kMajorMap = 5;
+    static constexpr uint8_t kMajorTag = 6;
+    static constexpr uint64_t kTagStringRef = 25;
+
+    OutputBuffer& buffer_;
+    StringDictionary* strings_;
+
+    static size_t headSize(uint64_t value) {
+        if (value < 24) return 1;
+        if (value <= 0xFF) return 2;
+        if (value <= 0xFFFF) return 3;
+        if (value <= 0xFFFFFFFFu) return 5;
+        return 9;
+    }
+
+    // Initial byte (major type, additional info) plus the big-endian argument
+    static void storeHead(uint8_t major, uint64_t value, char* out) {
+        size_t size = headSize(value);
+        uint8_t additional = size == 1 ? static_cast<uint8_t>(value)
+                           : size == 2 ? 24 : size == 3 ? 25 : size == 5 ? 26 : 27;
+        out[0] = static_cast<char>((major << 5) | additional);
+        if (size > 1) {
+            detail::storeBigEndian(value, static_cast<int>(size - 1), out + 1);
+        }
+    }
+
+    void writeHead(uint8_t major, uint64_t value) {
+        char* out = buffer_.reserve(9);
+        storeHead(major, value, out);
+        buffer_.advance(headSize(value));
+    }
+
+    // Head size of an encoded item, from its initial byte
+    static size_t literalHeadSize(char initial) {
+        uint8_t additional = static_cast<uint8_t>(initial) & 0x1F;
+        return additional < 24 ? 1 : size_t(1) + (size_t(1) << (additional - 24));
+    }
+
+    static size_t refSize(uint32_t ref) {
+        return headSize(kTagStringRef) + headSize(ref);
+    }
+
+    void writeRef(uint32_t ref) {
+        writeHead(kMajorTag, kTagStringRef);
+        writeHead(kMajorUnsigned, ref);
+    }
+
+    /**
+     * The decoder numbers every literal string at least as long as a reference to it would be, so the
+     * encoder must too, even for strings the dictionary does not keep.
+     * @return The table index given to a literal of utf8Length bytes just written, or kNone.
+     */
+    uint32_t claimRef(size_t utf8Length) {
+        uint32_t count = strings_->refCount();
+        size_t minimum = count < 24 ? 3 : count < 256 ? 4 : count < 65536 ? 5 : 7;
+        return utf8Length >= minimum ? strings_->appendRef() : StringDictionary::kNone;
+    }
+};
+
+/**
+ * @class MsgPackEncoder
+ * @brief MessagePack: fix/16/32 maps and arrays, fixstr/str8/16/32, float64, nil.
+ */
+class MsgPackEncoder {
+public:
+    explicit MsgPackEncoder(OutputBuffer& buffer, StringDictionary* strings = nullptr)
+            : buffer_(buffer), strings_(strings) {}
+
+    void beginObject(size_t fieldCount) { writeContainer(0x80, 0xDE, fieldCount); }
+    void key(std::string_view name) { detail::writeUtf8String<MsgPackEncoder>(buffer_, name.data(), name.size()); }
+    void endObject() {}
+
+    void beginArray(size_t elementCount) { writeContainer(0x90, 0xDC, elementCount); }
+    void endArray() {}
+
+    // MessagePack has no standard back-reference, so the dictionary only saves transcoding
+    void string(const char16_t* text, size_t length) {
+        if (strings_) {
+            uint32_t entry = strings_->lookup(text, length);
+            if (entry != StringDictionary::kNone) {
+                repeatString(entry);
+                return;
+            }
+        }
+        size_t start = buffer_.size();
+        detail::writeUtf16String<MsgPackEncoder>(buffer_, text, length);
+        if (strings_) {
+            strings_->insert(text, length, buffer_.data() + start, buffer_.size() - start);
+        }
+    }
+
+    StringDictionary* stringDictionary() const { return strings_; }
+
+    void repeatString(uint32_t entry) {
+        std::string_view encoded = strings_->encoded(entry);
+        buffer_.append(encoded.data(), encoded.size());
+    }
+
+    void plainString(const char* text, size_t length) {
+        detail::writeUtf8String<MsgPackEncoder>(buffer_, text, length);
+    }
+
+    void number(double value) {
+        char* out = buffer_.reserve(9);
+        out[0] = static_cast<char>(0xCB);
+        detail::storeBigEndian(detail::doubleBits(value), 8, out + 1);
+        buffer_.advance(9);
+    }
+
+    void null() { buffer_.append(static_cast<char>(0xC0)); }
+
+    // One complete, already encoded value (e.g. from the serialization cache)
+    void rawValue(const char* bytes, size_t length) { buffer_.append(bytes, length); }
+
+    static size_t stringHeaderSize(size_t length) {
+        if (length < 32) return 1;
+        if (length <= 0xFF) return 2;
+        if (length <= 0xFFFF) return 3;
+        return 5;
+    }
+
+    static void writeStringHeader(size_t length, char* out) {
+        size_t size = stringHeaderSize(length);
+        if (size == 1) {
+            out[0] = static_cast<char>(0xA0 | length);
+            return;
+        }
+        out[0] = static_cast<char>(size == 2 ? 0xD9 : size == 3 ? 0xDA : 0xDB);
+        detail::storeBigEndian(length, static_cast<int>(size - 1), out + 1);
+    }
+
+private:
+    OutputBuffer& buffer_;
+    StringDictionary* strings_;
+
+    // fixmap/fixarray below 16 entries, else the 16-bit form (prefix16) or the 32-bit one after it
+    void writeContainer(uint8_t fixPrefix, uint8_t prefix16, size_t count) {
+        char* out = buffer_.reserve(5);
+        if (count < 16) {
+            out[0] = static_cast<char>(fixPrefix | count);
+            buffer_.advance(1);
+        } else if (count <= 0xFFFF) {
+            out[0] = static_cast<char>(prefix16);
+            detail::storeBigEndian(count, 2, out + 1);
+            buffer_.advance(3);
+        } else {
+            out[0] = static_cast<char>(prefix16 + 1);
+            detail::storeBigEndian(count, 4, out + 1);
+            buffer_.advance(5);
+        }
+    }
+};
+
+} // namespace binary
+
+#endif // ANDROID_SDK_BINARYENCODERS_H
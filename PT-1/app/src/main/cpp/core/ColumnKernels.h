@@ -0,0 +1,259 @@
+#ifndef ANDROID_SDK_COLUMNKERNELS_H
+#define ANDROID_SDK_COLUMNKERNELS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define COLUMN_KERNEL_SSE2 1
+#elif defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define COLUMN_KERNEL_NEON 1 // Double lanes need AArch64; 32-bit ARM takes the scalar path
+#endif
+
+/**
+ * Predicate and aggregate kernels over the columns of a RestaurantColumns store.
+ *
+ * Predicates write a selection bitmap: bit i of word i / 64 is set when row i matches. Bitmaps of different
+ * predicates over the same rows combine with andBitmaps, and bits past the last row are always clear. Blocks of
+ * 64 rows are compared with SSE2 on x86 or NEON on AArch64; tails and other targets take the scalar path.
+ * NaN never satisfies a comparison, so a NaN value matches no range.
+ */
+namespace columns {
+
+constexpr size_t bitmapWords(size_t rows) {
+    return (rows + 63) / 64;
+}
+
+/**
+ * Sets bit i of out for every values[i] in [from, until), clearing the others.
+ * @param out bitmapWords(rows) words.
+ */
+inline void selectRange(const double* values, size_t rows, double from, double until, uint64_t* out) {
+    size_t row = 0;
+    for (; row + 64 <= rows; row += 64) {
+        const double* block = values + row;
+        uint64_t bits = 0;
+#if defined(COLUMN_KERNEL_SSE2)
+        const __m128d lo = _mm_set1_pd(from);
+        const __m128d hi = _mm_set1_pd(until);
+        for (size_t j = 0; j < 64; j += 2) {
+            __m128d v = _mm_loadu_pd(block + j);
+            __m128d inside = _mm_and_pd(_mm_cmpge_pd(v, lo), _mm_cmplt_pd(v, hi));
+            bits |= static_cast<uint64_t>(_mm_movemask_pd(inside)) << j;
+        }
+#elif defined(COLUMN_KERNEL_NEON)
+        const float64x2_t lo = vdupq_n_f64(from);
+        const float64x2_t hi = vdupq_n_f64(until);
+        for (size_t j = 0; j < 64; j += 2) {
+            float64x2_t v = vld1q_f64(block + j);
+            uint64x2_t inside = vandq_u64(vcgeq_f64(v, lo), vcltq_f64(v, hi));
+            bits |= (vgetq_lane_u64(inside, 0) & 1) << j;
+            bits |= (vgetq_lane_u64(inside, 1) & 1) << (j + 1);
+        }
+#else
+        for (size_t j = 0; j < 64; j++) {
+            bits |= static_cast<uint64_t>(block[j] >= from && block[j] < until) << j;
+        }
+#endif
+        out[row / 64] = bits;
+    }
+    if (row < rows) {
+        uint64_t bits = 0;
+        for (size_t j = 0; row + j < rows; j++) {
+            bits |= static_cast<uint64_t>(values[row + j] >= from && values[row + j] < until) << j;
+        }
+        out[row / 64] = bits;
+    }
+}
+
+/**
+ * Sets bit i of out for every codes[i] == code, clearing the others.
+ */
+inline void selectEqual(const uint32_t* codes, size_t rows, uint32_t code, uint64_t* out) {
+    size_t row = 0;
+    for (; row + 64 <= rows; row += 64) {
+        const uint32_t* block = codes + row;
+        uint64_t bits = 0;
+#if defined(COLUMN_KERNEL_SSE2)
+        const __m128i wanted = _mm_set1_epi32(static_cast<int>(code));
+        for (size_t j = 0; j < 64; j += 4) {
+            __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + j)), wanted);
+            bits |= static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(equal))) << j;
+        }
+#elif defined(COLUMN_KERNEL_NEON)
+        const uint32x4_t wanted = vdupq_n_u32(code);
+        const uint32_t laneBits[4] = {1, 2, 4, 8};
+        const uint32x4_t weights = vld1q_u32(laneBits);
+        for (size_t j = 0; j < 64; j += 4) {
+            uint32x4_t equal = vceqq_u32(vld1q_u32(block + j), wanted);
+            bits |= static_cast<uint64_t>(vaddvq_u32(vandq_u32(equal, weights))) << j;
+        }
+#else
+        for (size_t j = 0; j < 64; j++) {
+            bits |= static_cast<uint64_t>(block[j] == code) << j;
+        }
+#endif
+        out[row / 64] = bits;
+    }
+    if (row < rows) {
+        uint64_t bits = 0;
+        for (size_t j = 0; row + j < rows; j++) {
+            bits |= static_cast<uint64_t>(codes[row + j] == code) << j;
+        }
+        out[row / 64] = bits;
+    }
+}
+
+/**
+ * Sets bit i of out for every masks[i] sharing a bit with mask, clearing the others.
+ */
+inline void selectAnyBit(const uint64_t* masks, size_t rows, uint64_t mask, uint64_t* out) {
+    for (size_t row = 0; row < rows; row += 64) {
+        size_t count = std::min<size_t>(64, rows - row);
+        uint64_t bits = 0;
+        for (size_t j = 0; j < count; j++) {
+            bits |= static_cast<uint64_t>((masks[row + j] & mask) != 0) << j;
+        }
+        out[row / 64] = bits;
+    }
+}
+
+/**
+ * Sets the first rows bits of out and clears the rest of its last word.
+ */
+inline void selectAll(size_t rows, uint64_t* out) {
+    std::fill(out, out + rows / 64, ~uint64_t(0));
+    if (rows % 64) {
+        out[rows / 64] = (uint64_t(1) << (rows % 64)) - 1;
+    }
+}
+
+inline void andBitmaps(uint64_t* target, const uint64_t* other, size_t words) {
+    for (size_t i = 0; i < words; i++) {
+        target[i] &= other[i];
+    }
+}
+
+/**
+ * @return Whether any bit in [begin, end) is set.
+ */
+inline bool anyInRange(const uint64_t* bitmap, size_t begin, size_t end) {
+    if (begin >= end) {
+        return false;
+    }
+    size_t first = begin / 64;
+    size_t last = (end - 1) / 64;
+    uint64_t headMask = ~uint64_t(0) << (begin % 64);
+    uint64_t tailMask = ~uint64_t(0) >> (63 - (end - 1) % 64);
+    if (first == last) {
+        return (bitmap[first] & headMask & tailMask) != 0;
+    }
+    if (bitmap[first] & headMask) {
+        return true;
+    }
+    for (size_t word = first + 1; word < last; word++) {
+        if (bitmap[word]) return true;
+    }
+    return (bitmap[last] & tailMask) != 0;
+}
+
+inline size_t countSelected(const uint64_t* bitmap, size_t words) {
+    size_t count = 0;
+    for (size_t i = 0; i < words; i++) {
+        count += static_cast<size_t>(__builtin_popcountll(bitmap[i]));
+    }
+    return count;
+}
+
+/**
+ * Calls visit(row) for every set bit, in ascending order.
+ */
+template <typename Visit>
+inline void forEachSelected(const uint64_t* bitmap, size_t words, Visit&& visit) {
+    for (size_t word = 0; word < words; word++) {
+        for (uint64_t bits = bitmap[word]; bits; bits &= bits - 1) {
+            visit(word * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+        }
+    }
+}
+
+struct Summary {
+    size_t count = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0;
+};
+
+/**
+ * Count, min, max and sum of the selected values. Fully selected blocks of 64 run vectorised.
+ */
+inline Summary summarizeSelected(const double* values, const uint64_t* bitmap, size_t rows) {
+    Summary summary;
+    size_t words = bitmapWords(rows);
+    for (size_t word = 0; word < words; word++) {
+        uint64_t bits = bitmap[word];
+        const double* block = values + word * 64;
+#if defined(COLUMN_KERNEL_SSE2) || defined(COLUMN_KERNEL_NEON)
+        if (bits == ~uint64_t(0)) {
+#if defined(COLUMN_KERNEL_SSE2)
+            __m128d lo = _mm_set1_pd(summary.min), hi = _mm_set1_pd(summary.max), sum = _mm_setzero_pd();
+            for (size_t j = 0; j < 64; j += 2) {
+                __m128d v = _mm_loadu_pd(block + j);
+                lo = _mm_min_pd(lo, v);
+                hi = _mm_max_pd(hi, v);
+                sum = _mm_add_pd(sum, v);
+            }
+            double lanes[2];
+            _mm_storeu_pd(lanes, lo);
+            summary.min = std::min(lanes[0], lanes[1]);
+            _mm_storeu_pd(lanes, hi);
+            summary.max = std::max(lanes[0], lanes[1]);
+            _mm_storeu_pd(lanes, sum);
+            summary.sum += lanes[0] + lanes[1];
+#else
+            float64x2_t lo = vdupq_n_f64(summary.min), hi = vdupq_n_f64(summary.max), sum = vdupq_n_f64(0);
+            for (size_t j = 0; j < 64; j += 2) {
+                float64x2_t v = vld1q_f64(block + j);
+                lo = vminq_f64(lo, v);
+                hi = vmaxq_f64(hi, v);
+                sum = vaddq_f64(sum, v);
+            }
+            summary.min = vminvq_f64(lo);
+            summary.max = vmaxvq_f64(hi);
+            summary.sum += vaddvq_f64(sum);
+#endif
+            summary.count += 64;
+            continue;
+        }
+#endif
+        for (; bits; bits &= bits - 1) {
+            double v = block[__builtin_ctzll(bits)];
+            summary.min = std::min(summary.min, v);
+            summary.max = std::max(summary.max, v);
+            summary.sum += v;
+            summary.count++;
+        }
+    }
+    return summary;
+}
+
+/**
+ * Adds the selected values to buckets equal-width buckets over [from, to]; to itself falls in the last one.
+ */
+inline void histogramSelected(const double* values, const uint64_t* bitmap, size_t rows, double from, double to,
+                              uint64_t* buckets, size_t bucketCount) {
+    double scale = to > from ? static_cast<double>(bucketCount) / (to - from) : 0.0;
+    forEachSelected(bitmap, bitmapWords(rows), [&](size_t row) {
+        double position = (values[row] - from) * scale;
+        size_t bucket = position > 0 ? static_cast<size_t>(position) : 0;
+        buckets[std::min(bucket, bucketCount - 1)]++;
+    });
+}
+
+} // namespace columns
+
+#endif // ANDROID_SDK_COLUMNKERNELS_H
@@ -0,0 +1,169 @@
+#ifndef ANDROID_SDK_EVENTTAPE_H
+#define ANDROID_SDK_EVENTTAPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+/**
+ * @class EventTape
+ * @brief Encoder (see ModelTraversal.h) that records the traversal so it can be replayed later, off the JVM.
+ *
+ * Recording copies out everything the traversal read from Java (UTF-16 string contents, doubles, formatted
+ * days and times), so a tape is a JVM-independent snapshot of the model: replay() feeds it to any other
+ * Encoder on any thread, without a JNIEnv and without the original objects.
+ *
+ * Usage:
+ *   EventTape tape;
+ *   modelwalk::encodeModel(env, shadow, tape);   // JVM thread
+ *   JsonEncoder encoder(writer);
+ *   tape.replay(0, tape.size(), encoder);       // any thread
+ *
+ * Keys are stored as pointers: they are the model descriptors' property names, which have static storage.
+ * Every event starts at an even offset and is laid out the same wherever it starts, so equal values record to
+ * equal bytes: bytes() of a recorded value serve as its content fingerprint input (see SerializationCache).
+ */
+class EventTape {
+public:
+    void beginObject(size_t fieldCount) { op(Op::BeginObject, fieldCount); }
+
+    void key(std::string_view name) {
+        const char* text = name.data();
+        std::memcpy(op(Op::Key, name.size(), sizeof(text)), &text, sizeof(text));
+    }
+
+    void endObject() { op(Op::EndObject, 0); }
+
+    void beginArray(size_t elementCount) { op(Op::BeginArray, elementCount); }
+
+    void endArray() { op(Op::EndArray, 0); }
+
+    void string(const char16_t* text, size_t length) {
+        // Events start 2-byte aligned, so replay can hand out a char16_t pointer into the tape
+        std::memcpy(op(Op::String, length, length * sizeof(char16_t)), text, length * sizeof(char16_t));
+    }
+
+    void plainString(const char* text, size_t length) {
+        std::memcpy(op(Op::PlainString, length, padded(length)), text, length);
+    }
+
+    void number(double value) {
+        std::memcpy(op(Op::Number, 0, sizeof(value)), &value, sizeof(value));
+    }
+
+    void null() { op(Op::Null, 0); }
+
+    /**
+     * Offset of the next event; marks boundaries between recorded values.
+     */
+    size_t size() const { return size_; }
+
+    void clear() { size_ = 0; }
+
+    /**
+     * The recorded bytes from offset begin; [begin, end) of two event boundaries holds whole values.
+     */
+    const uint8_t* bytes(size_t begin) const { return bytes_.get() + begin; }
+
+    /**
+     * Replays the events recorded in [begin, end) into encoder; both must be event boundaries.
+     */
+    template <typename Encoder>
+    void replay(size_t begin, size_t end, Encoder& encoder) const {
+        const uint8_t* base = bytes_.get();
+        size_t at = begin;
+        while (at < end) {
+            auto kind = static_cast<Op>(base[at]);
+            uint32_t size;
+            std::memcpy(&size, base + at + 2, sizeof(size));
+            at += kOpSize;
+            switch (kind) {
+                case Op::BeginObject:
+                    encoder.beginObject(size);
+                    break;
+                case Op::Key: {
+                    const char* name;
+                    std::memcpy(&name, base + at, sizeof(name));
+                    at += sizeof(name);
+                    encoder.key(std::string_view(name, size));
+                    break;
+                }
+                case Op::EndObject:
+                    encoder.endObject();
+                    break;
+                case Op::BeginArray:
+                    encoder.beginArray(size);
+                    break;
+                case Op::EndArray:
+                    encoder.endArray();
+                    break;
+                case Op::String:
+                    encoder.string(reinterpret_cast<const char16_t*>(base + at), size);
+                    at += size * sizeof(char16_t);
+                    break;
+                case Op::PlainString:
+                    encoder.plainString(reinterpret_cast<const char*>(base + at), size);
+                    at += padded(size);
+                    break;
+                case Op::Number: {
+                    double value;
+                    std::memcpy(&value, base + at, sizeof(value));
+                    at += sizeof(value);
+                    encoder.number(value);
+                    break;
+                }
+                case Op::Null:
+                    encoder.null();
+                    break;
+            }
+        }
+    }
+
+private:
+    enum class Op : uint8_t { BeginObject, Key, EndObject, BeginArray, EndArray, String, PlainString, Number, Null };
+
+    // One tag byte, a zero byte and a 32-bit count or length
+    static constexpr size_t kOpSize = 2 + sizeof(uint32_t);
+
+    static constexpr size_t kInitialCapacity = 4096;
+
+    std::unique_ptr<uint8_t[]> bytes_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+
+    static size_t padded(size_t length) { return length + (length & 1); }
+
+    // Appends the event's header and room for payload bytes. The last payload byte is zeroed first, so a
+    // padding byte records the same every time.
+    uint8_t* op(Op kind, size_t size, size_t payload = 0) {
+        size_t length = kOpSize + payload;
+        if (size_ + length > capacity_) {
+            grow(length);
+        }
+        auto size32 = static_cast<uint32_t>(size);
+        uint8_t* out = bytes_.get() + size_;
+        out[length - 1] = 0;
+        out[0] = static_cast<uint8_t>(kind);
+        out[1] = 0;
+        std::memcpy(out + 2, &size32, sizeof(size32));
+        size_ += length;
+        return out + kOpSize;
+    }
+
+    void grow(size_t extra) {
+        size_t capacity = capacity_ ? capacity_ * 2 : kInitialCapacity;
+        while (capacity < size_ + extra) {
+            capacity *= 2;
+        }
+        std::unique_ptr<uint8_t[]> grown(new uint8_t[capacity]);
+        if (size_) {
+            std::memcpy(grown.get(), bytes_.get(), size_);
+        }
+        bytes_ = std::move(grown);
+        capacity_ = capacity;
+    }
+};
+
+#endif // ANDROID_SDK_EVENTTAPE_H
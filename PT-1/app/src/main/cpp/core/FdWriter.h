@@ -0,0 +1,285 @@
+#ifndef ANDROID_SDK_FDWRITER_H
+#define ANDROID_SDK_FDWRITER_H
+
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JsonWriter.h"
+#include "NativeStats.h"
+
+/**
+ * A write to the file descriptor failed; what() carries strerror(errno).
+ */
+class IoError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @class ScopedFd
+ * @brief Owns a file descriptor and closes it when it goes out of scope, so no exception path leaks it.
+ */
+class ScopedFd {
+public:
+    explicit ScopedFd(int fd) : fd_(fd) {}
+
+    ScopedFd(const ScopedFd&) = delete;
+    ScopedFd& operator=(const ScopedFd&) = delete;
+
+    ~ScopedFd() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    int get() const {
+        return fd_;
+    }
+
+    /**
+     * Closes the descriptor now, for callers that report close() failures.
+     * @return close()'s result; errno is set when it is -1.
+     */
+    int close() {
+        int fd = fd_;
+        fd_ = -1;
+        return ::close(fd);
+    }
+
+private:
+    int fd_;
+};
+
+/**
+ * @class FdWriter
+ * @brief Streams records to a file descriptor through a fixed set of reusable segments.
+ *
+ * The producer encodes each record into current() and calls endRecord(). Once a segment holds kSegmentBytes it
+ * is queued and the producer moves on to a free one. Queued segments are written together with one writev()
+ * and then recycled, so native memory stays at kSegmentCount segments no matter how much is streamed (a single
+ * record larger than a segment grows it; it is shrunk back after the write).
+ *
+ * With overlapIo a background thread does the writes, so encoding continues while earlier segments are
+ * written; the producer only waits when every segment is full. Without it the producer writes inline
+ * whenever it runs out of free segments.
+ *
+ * Usage:
+ *   FdWriter out(fd, true);
+ *   for (...) { encode(out.current()); out.endRecord(); }
+ *   size_t written = out.finish();
+ */
+class FdWriter {
+public:
+    static constexpr size_t kSegmentBytes = 64 * 1024;
+    static constexpr size_t kSegmentCount = 8;
+
+    FdWriter(int fd, bool overlapIo) : fd_(fd), segments_(kSegmentCount) {
+        for (size_t i = 0; i < kSegmentCount; i++) {
+            segments_[i] = std::make_unique<JsonWriter>(kSegmentBytes);
+            free_.push_back(i);
+        }
+        current_ = takeFree();
+        if (overlapIo) {
+            flusher_ = std::thread([this] { flushLoop(); });
+        }
+    }
+
+    FdWriter(const FdWriter&) = delete;
+    FdWriter& operator=(const FdWriter&) = delete;
+
+    /**
+     * Stops the background writer; anything not yet passed to finish() is dropped.
+     */
+    ~FdWriter() {
+        stopFlusher();
+    }
+
+    /**
+     * The segment to encode the next record into.
+     */
+    JsonWriter& current() {
+        return *segments_[current_];
+    }
+
+    /**
+     * Marks the end of a record; queues the current segment once it is full.
+     * @throws IoError if an earlier write failed.
+     */
+    void endRecord() {
+        if (segments_[current_]->size() >= kSegmentBytes) {
+            queueCurrent();
+        }
+    }
+
+    /**
+     * Writes everything still buffered and stops the background writer.
+     * @return Total bytes written.
+     * @throws IoError
+     */
+    size_t finish() {
+        if (segments_[current_]->size() > 0) {
+            queueCurrent();
+        }
+        if (flusher_.joinable()) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&] { return (full_.empty() && !writing_) || error_; });
+        } else if (!full_.empty()) {
+            writeQueued();
+        }
+        stopFlusher();
+        if (error_) {
+            throw IoError(std::strerror(error_));
+        }
+        return written_;
+    }
+
+private:
+    int fd_;
+    std::vector<std::unique_ptr<JsonWriter>> segments_;
+    std::vector<size_t> free_;
+    std::vector<size_t> full_; // In write order
+    size_t current_;
+    size_t written_ = 0;
+    int error_ = 0;
+
+    std::thread flusher_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool writing_ = false;
+    bool stopping_ = false;
+
+    size_t takeFree() {
+        size_t index = free_.back();
+        free_.pop_back();
+        return index;
+    }
+
+    void queueCurrent() {
+        if (!flusher_.joinable()) {
+            full_.push_back(current_);
+            if (free_.empty()) {
+                writeQueued();
+            }
+            if (error_) {
+                throw IoError(std::strerror(error_));
+            }
+            current_ = takeFree();
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        full_.push_back(current_);
+        changed_.notify_all();
+        changed_.wait(lock, [&] { return !free_.empty() || error_; });
+        if (error_) {
+            throw IoError(std::strerror(error_));
+        }
+        current_ = takeFree();
+    }
+
+    /**
+     * Inline mode: writes and recycles every queued segment.
+     */
+    void writeQueued() {
+        std::vector<size_t> batch;
+        batch.swap(full_);
+        int error = writeAll(batch);
+        recycle(batch);
+        if (error && !error_) {
+            error_ = error;
+        }
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            changed_.wait(lock, [&] { return !full_.empty() || stopping_; });
+            if (full_.empty()) {
+                return;
+            }
+            std::vector<size_t> batch;
+            batch.swap(full_);
+            writing_ = true;
+            lock.unlock();
+            // After an error the remaining segments are only recycled, so the producer never blocks for good
+            int error = error_ ? error_ : writeAll(batch);
+            lock.lock();
+            recycle(batch);
+            writing_ = false;
+            if (error && !error_) {
+                error_ = error;
+            }
+            changed_.notify_all();
+        }
+    }
+
+    void stopFlusher() {
+        if (!flusher_.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            full_.clear(); // Unwritten segments are dropped, see the destructor
+        }
+        changed_.notify_all();
+        flusher_.join();
+    }
+
+    /**
+     * writev()s the segments in order, resuming after partial writes and EINTR.
+     * @return 0 or an errno value.
+     */
+    int writeAll(const std::vector<size_t>& batch) {
+        NATIVE_STATS_PHASE(FdWrite);
+        iovec parts[kSegmentCount];
+        size_t count = 0;
+        for (size_t index : batch) {
+            if (segments_[index]->size() == 0) continue;
+            parts[count].iov_base = const_cast<char*>(segments_[index]->data());
+            parts[count].iov_len = segments_[index]->size();
+            count++;
+        }
+        iovec* next = parts;
+        while (count > 0) {
+            ssize_t result = ::writev(fd_, next, static_cast<int>(count));
+            if (result < 0) {
+                if (errno == EINTR) continue;
+                return errno;
+            }
+            written_ += static_cast<size_t>(result);
+            auto remaining = static_cast<size_t>(result);
+            while (count > 0 && remaining >= next->iov_len) {
+                remaining -= next->iov_len;
+                next++;
+                count--;
+            }
+            if (count > 0) {
+                next->iov_base = static_cast<char*>(next->iov_base) + remaining;
+                next->iov_len -= remaining;
+            }
+        }
+        return 0;
+    }
+
+    void recycle(const std::vector<size_t>& batch) {
+        for (size_t index : batch) {
+            if (segments_[index]->capacity() > kSegmentBytes * 4) {
+                segments_[index] = std::make_unique<JsonWriter>(kSegmentBytes); // Drop an oversized record's growth
+            } else {
+                segments_[index]->clear();
+            }
+            free_.push_back(index);
+        }
+    }
+};
+
+#endif // ANDROID_SDK_FDWRITER_H
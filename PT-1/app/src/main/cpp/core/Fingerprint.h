@@ -0,0 +1,144 @@
+#ifndef ANDROID_SDK_FINGERPRINT_H
+#define ANDROID_SDK_FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Content fingerprints for the serialization cache (see SerializationCache.h).
+ */
+namespace fingerprint {
+
+/**
+ * @class XxHash64
+ * @brief Streaming XXH64: fast, non-cryptographic, 64-bit.
+ *
+ * Usage:
+ *   XxHash64 hash;
+ *   hash.update(data, length);
+ *   uint64_t value = hash.digest();
+ */
+class XxHash64 {
+public:
+    explicit XxHash64(uint64_t seed = 0)
+            : v1_(seed + kPrime1 + kPrime2), v2_(seed + kPrime2), v3_(seed), v4_(seed - kPrime1),
+              seed_(seed), totalLength_(0), buffered_(0) {}
+
+    void update(const void* data, size_t length) {
+        auto p = static_cast<const uint8_t*>(data);
+        totalLength_ += length;
+
+        if (buffered_ + length < 32) {
+            std::memcpy(buffer_ + buffered_, p, length);
+            buffered_ += length;
+            return;
+        }
+        if (buffered_) {
+            size_t fill = 32 - buffered_;
+            std::memcpy(buffer_ + buffered_, p, fill);
+            consumeStripe(buffer_);
+            p += fill;
+            length -= fill;
+            buffered_ = 0;
+        }
+        for (; length >= 32; p += 32, length -= 32) {
+            consumeStripe(p);
+        }
+        std::memcpy(buffer_, p, length);
+        buffered_ = length;
+    }
+
+    template <typename T>
+    void updateValue(const T& value) {
+        update(&value, sizeof(value));
+    }
+
+    uint64_t digest() const {
+        uint64_t hash;
+        if (totalLength_ >= 32) {
+            hash = rotl(v1_, 1) + rotl(v2_, 7) + rotl(v3_, 12) + rotl(v4_, 18);
+            hash = mergeRound(hash, v1_);
+            hash = mergeRound(hash, v2_);
+            hash = mergeRound(hash, v3_);
+            hash = mergeRound(hash, v4_);
+        } else {
+            hash = seed_ + kPrime5;
+        }
+        hash += totalLength_;
+
+        const uint8_t* p = buffer_;
+        size_t remaining = buffered_;
+        for (; remaining >= 8; p += 8, remaining -= 8) {
+            hash ^= round(0, read64(p));
+            hash = rotl(hash, 27) * kPrime1 + kPrime4;
+        }
+        if (remaining >= 4) {
+            hash ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+            hash = rotl(hash, 23) * kPrime2 + kPrime3;
+            p += 4;
+            remaining -= 4;
+        }
+        for (; remaining > 0; p++, remaining--) {
+            hash ^= *p * kPrime5;
+            hash = rotl(hash, 11) * kPrime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+private:
+    static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    uint64_t v1_, v2_, v3_, v4_;
+    uint64_t seed_;
+    uint64_t totalLength_;
+    uint8_t buffer_[32];
+    size_t buffered_;
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    // Little-endian loads; both ABIs we ship (arm64, x86_64) are little-endian
+    static uint64_t read64(const uint8_t* p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+
+    static uint64_t mergeRound(uint64_t acc, uint64_t value) {
+        acc ^= round(0, value);
+        return acc * kPrime1 + kPrime4;
+    }
+
+    void consumeStripe(const uint8_t* p) {
+        v1_ = round(v1_, read64(p));
+        v2_ = round(v2_, read64(p + 8));
+        v3_ = round(v3_, read64(p + 16));
+        v4_ = round(v4_, read64(p + 24));
+    }
+};
+
+} // namespace fingerprint
+
+#endif // ANDROID_SDK_FINGERPRINT_H
@@ -0,0 +1,138 @@
+#ifndef ANDROID_SDK_JSONENCODER_H
+#define ANDROID_SDK_JSONENCODER_H
+
+#include <string_view>
+#include "JsonWriter.h"
+#include "StringDictionary.h"
+
+/**
+ * @class JsonEncoder
+ * @brief JSON text encoder for the model traversal (see ModelTraversal.h).
+ *
+ * Separators are tracked with a single flag: a value or key that follows another value gets a ','.
+ * Element counts passed to beginObject()/beginArray() are ignored; JSON does not need them.
+ *
+ * With a StringDictionary, a string value seen before in the call is copied as its escaped, quoted bytes
+ * instead of being transcoded again; the output is the same byte for byte.
+ */
+class JsonEncoder {
+public:
+    explicit JsonEncoder(JsonWriter& writer, StringDictionary* strings = nullptr)
+            : writer_(writer), strings_(strings), needsComma_(false) {}
+
+    void beginObject(size_t /*fieldCount*/) {
+        separate();
+        writer_.append('{');
+        needsComma_ = false;
+    }
+
+    /**
+     * @param name A model property name; these never need escaping.
+     */
+    void key(std::string_view name) {
+        char* out = writer_.reserve(name.size() + 4);
+        size_t length = 0;
+        if (needsComma_) out[length++] = ',';
+        out[length++] = '"';
+        std::memcpy(out + length, name.data(), name.size());
+        length += name.size();
+        out[length++] = '"';
+        out[length++] = ':';
+        writer_.advance(length);
+        needsComma_ = false;
+    }
+
+    void endObject() {
+        writer_.append('}');
+        needsComma_ = true;
+    }
+
+    void beginArray(size_t /*elementCount*/) {
+        separate();
+        writer_.append('[');
+        needsComma_ = false;
+    }
+
+    void endArray() {
+        writer_.append(']');
+        needsComma_ = true;
+    }
+
+    void string(const char16_t* text, size_t length) {
+        if (strings_) {
+            uint32_t entry = strings_->lookup(text, length);
+            if (entry != StringDictionary::kNone) {
+                repeatString(entry);
+                return;
+            }
+        }
+        separate();
+        size_t start = writer_.size();
+        writer_.quotedUtf16(text, length);
+        if (strings_) {
+            strings_->insert(text, length, writer_.data() + start, writer_.size() - start);
+        }
+        needsComma_ = true;
+    }
+
+    StringDictionary* stringDictionary() const {
+        return strings_;
+    }
+
+    /**
+     * Writes a dictionary entry again, without looking at its text.
+     */
+    void repeatString(uint32_t entry) {
+        std::string_view encoded = strings_->encoded(entry);
+        rawValue(encoded.data(), encoded.size());
+    }
+
+    /**
+     * @param text UTF-8 text that needs no escaping (day names, formatted times).
+     */
+    void plainString(const char* text, size_t length) {
+        char* out = writer_.reserve(length + 3);
+        size_t written = 0;
+        if (needsComma_) out[written++] = ',';
+        out[written++] = '"';
+        std::memcpy(out + written, text, length);
+        written += length;
+        out[written++] = '"';
+        writer_.advance(written);
+        needsComma_ = true;
+    }
+
+    void number(double value) {
+        separate();
+        writer_.number(value);
+        needsComma_ = true;
+    }
+
+    void null() {
+        separate();
+        writer_.literal("null");
+        needsComma_ = true;
+    }
+
+    /**
+     * Appends one complete, already encoded value (e.g. from the serialization cache).
+     */
+    void rawValue(const char* bytes, size_t length) {
+        separate();
+        writer_.append(bytes, length);
+        needsComma_ = true;
+    }
+
+private:
+    JsonWriter& writer_;
+    StringDictionary* strings_;
+    bool needsComma_;
+
+    void separate() {
+        if (needsComma_) {
+            writer_.append(',');
+        }
+    }
+};
+
+#endif // ANDROID_SDK_JSONENCODER_H
@@ -0,0 +1,526 @@
+#ifndef ANDROID_SDK_JSONREADER_H
+#define ANDROID_SDK_JSONREADER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "Utf16ToUtf8.h"
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+/**
+ * Thrown by JsonReader on malformed input; offset is the byte position of the problem.
+ */
+class JsonParseError : public std::runtime_error {
+public:
+    JsonParseError(const std::string& message, size_t offset)
+            : std::runtime_error(message + " at offset " + std::to_string(offset)), offset(offset) {}
+
+    const size_t offset;
+};
+
+namespace jsonread {
+namespace detail {
+
+inline bool isStringSpecial(char c) {
+    return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+/**
+ * @return The first '"', '\\' or control character (U+0000 to U+001F, never allowed unescaped) in [p, end),
+ * or end.
+ */
+inline const char* findStringSpecial(const char* p, const char* end) {
+#if defined(UTF16_KERNEL_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lastControl = _mm_set1_epi8(0x1F);
+    for (; p + 16 <= end; p += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // Unsigned bytes <= 0x1F are the ones min() leaves unchanged
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(bytes, lastControl), bytes);
+        int mask = _mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)), control));
+        if (mask) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#elif defined(UTF16_KERNEL_NEON)
+    for (; p + 16 <= end; p += 16) {
+        uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('"')), vceqq_u8(bytes, vdupq_n_u8('\\'))),
+                                   vcltq_u8(bytes, vdupq_n_u8(0x20)));
+        uint64x2_t lanes = vreinterpretq_u64_u8(hits);
+        if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) {
+            break; // The scalar loop below finds it within these 16 bytes
+        }
+    }
+#endif
+    for (; p < end; p++) {
+        if (isStringSpecial(*p)) return p;
+    }
+    return end;
+}
+
+/**
+ * Widens leading plain-ASCII bytes (no '\\') of src[0..length) to UTF-16, 16 at a time.
+ * @return How many bytes were widened (a multiple of 16).
+ */
+inline size_t widenAsciiRun(const char* src, size_t length, char16_t* out) {
+    size_t i = 0;
+#if defined(UTF16_KERNEL_SSE2)
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(bytes) | _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash))) break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+    }
+#elif defined(UTF16_KERNEL_NEON)
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16_t special = vorrq_u8(vcgeq_u8(bytes, vdupq_n_u8(0x80)), vceqq_u8(bytes, vdupq_n_u8('\\')));
+        uint64x2_t lanes = vreinterpretq_u64_u8(special);
+        if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) break;
+        vst1q_u16(reinterpret_cast<uint16_t*>(out + i), vmovl_u8(vget_low_u8(bytes)));
+        vst1q_u16(reinterpret_cast<uint16_t*>(out + i + 8), vmovl_u8(vget_high_u8(bytes)));
+    }
+#else
+    (void)src;
+    (void)length;
+    (void)out;
+#endif
+    return i;
+}
+
+inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace detail
+} // namespace jsonread
+
+/**
+ * @class JsonReader
+ * @brief Pull parser over UTF-8 JSON text, for decoding straight into Java objects (see ModelDecoding.h).
+ *
+ * There is no intermediate document: callers ask for the value they expect next. String scanning,
+ * which is most of the work, finds the closing quote and widens ASCII runs to UTF-16 16 bytes at a time
+ * (SSE2 on x86, NEON on ARM). Strings decode to UTF-16 for NewString; surrogate code points encoded as
+ * 3-byte sequences (modified UTF-8) pass through unchanged, so both standard and modified UTF-8 work.
+ *
+ * All methods throw JsonParseError on malformed input, including raw control characters in strings and, for
+ * skipped values, anything the typed reads would reject.
+ */
+class JsonReader {
+public:
+    JsonReader(const char* data, size_t size) : begin_(data), p_(data), end_(data + size) {}
+
+    /**
+     * @return The next non-whitespace character without consuming it, 0 at the end of the input.
+     */
+    char peek() {
+        skipWhitespace();
+        return p_ < end_ ? *p_ : 0;
+    }
+
+    /**
+     * Consumes c if it is the next non-whitespace character.
+     */
+    bool consume(char c) {
+        if (peek() == c) {
+            p_++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            fail(std::string("Expected '") + c + "'");
+        }
+    }
+
+    /**
+     * Consumes a null literal if it is next.
+     */
+    bool consumeNull() {
+        if (peek() != 'n') {
+            return false;
+        }
+        if (end_ - p_ < 4 || std::memcmp(p_, "null", 4) != 0) {
+            fail("Invalid literal");
+        }
+        p_ += 4;
+        return true;
+    }
+
+    /**
+     * Reads an object key. Keys without escapes are returned as a view into the input,
+     * others are decoded into scratch (as UTF-8).
+     */
+    std::string_view readKey(std::string& scratch) {
+        expect('"');
+        const char* start = p_;
+        const char* stop = jsonread::detail::findStringSpecial(p_, end_);
+        if (stop < end_ && *stop == '"') {
+            p_ = stop + 1;
+            return std::string_view(start, static_cast<size_t>(stop - start));
+        }
+        p_ = start - 1;
+        std::u16string wide;
+        readString(wide);
+        scratch.assign(utf16::maxUtf8Length(wide.size(), false), '\0');
+        scratch.resize(utf16::transcode<false>(wide.data(), wide.size(), &scratch[0]));
+        return scratch;
+    }
+
+    /**
+     * Reads a string value, replacing out's contents with its UTF-16 code units.
+     */
+    void readString(std::u16string& out) {
+        expect('"');
+        const char* start = p_;
+        const char* stop = findStringEnd(p_);
+        // Never more code units than bytes
+        if (out.size() < static_cast<size_t>(stop - start)) {
+            out.resize(static_cast<size_t>(stop - start));
+        }
+        size_t length = decode(start, stop, &out[0]);
+        out.resize(length);
+        p_ = stop + 1;
+    }
+
+    double readNumber() {
+        const char* start = skipNumber();
+        double value = 0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        auto result = std::from_chars(start, p_, value);
+        if (result.ec != std::errc() || result.ptr != p_) {
+            fail("Invalid number");
+        }
+#else
+        // strtod needs a terminated copy; numbers too long for the stack buffer (many digits are valid JSON)
+        // take a heap one
+        size_t length = static_cast<size_t>(p_ - start);
+        char buffer[65];
+        std::string longToken;
+        char* token = buffer;
+        if (length >= sizeof(buffer)) {
+            longToken.assign(start, length);
+            token = &longToken[0];
+        } else {
+            std::memcpy(buffer, start, length);
+            buffer[length] = '\0';
+        }
+        char* parsedEnd = nullptr;
+        value = std::strtod(token, &parsedEnd);
+        if (parsedEnd != token + length) {
+            fail("Invalid number");
+        }
+#endif
+        return value;
+    }
+
+    /**
+     * Skips the next value of any type, checking it against the JSON grammar like the typed reads do.
+     */
+    void skipValue() {
+        skipValue(0);
+    }
+
+    /**
+     * Containers nested deeper than this inside a skipped value fail rather than recurse further.
+     */
+    static constexpr int kMaxSkipDepth = 512;
+
+    /**
+     * Counts the elements of the array that starts at the next non-whitespace character, without consuming it.
+     * Lets callers size a Java array before decoding into it.
+     */
+    size_t countArrayElements() {
+        if (peek() != '[') {
+            fail("Expected '['");
+        }
+        const char* saved = p_;
+        p_++;
+        size_t count = 0;
+        if (peek() != ']') {
+            do {
+                skipValue();
+                count++;
+            } while (consume(','));
+        }
+        expect(']');
+        p_ = saved;
+        return count;
+    }
+
+    /**
+     * Fails unless only whitespace is left.
+     */
+    void expectEnd() {
+        if (peek() != 0) {
+            fail("Unexpected trailing data");
+        }
+    }
+
+    size_t offset() const {
+        return static_cast<size_t>(p_ - begin_);
+    }
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw JsonParseError(message, offset());
+    }
+
+private:
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+
+    static bool isNumberChar(char c) {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    static bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // Advances p past a run of one or more digits; false if there is none
+    static bool skipDigits(const char*& p, const char* end) {
+        if (p == end || !isDigit(*p)) {
+            return false;
+        }
+        while (p < end && isDigit(*p)) {
+            p++;
+        }
+        return true;
+    }
+
+    // RFC 8259: -? (0 | [1-9][0-9]*) (. [0-9]+)? ([eE] [+-]? [0-9]+)?
+    static bool isJsonNumber(const char* p, const char* end) {
+        if (p < end && *p == '-') {
+            p++;
+        }
+        if (p < end && *p == '0') {
+            p++;
+        } else if (!skipDigits(p, end)) {
+            return false;
+        }
+        if (p < end && *p == '.' && !skipDigits(++p, end)) {
+            return false;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            p++;
+            if (p < end && (*p == '+' || *p == '-')) {
+                p++;
+            }
+            if (!skipDigits(p, end)) {
+                return false;
+            }
+        }
+        return p == end;
+    }
+
+    // Consumes a number token and checks its grammar; returns where it starts
+    const char* skipNumber() {
+        skipWhitespace();
+        const char* start = p_;
+        while (p_ < end_ && isNumberChar(*p_)) {
+            p_++;
+        }
+        if (p_ == start) {
+            fail("Expected a number");
+        }
+        // Neither from_chars nor strtod checks the JSON grammar: both take "1." and "01", strtod also "+1"
+        if (!isJsonNumber(start, p_)) {
+            fail("Invalid number");
+        }
+        return start;
+    }
+
+    void skipWhitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            p_++;
+        }
+    }
+
+    void skipValue(int depth) {
+        char c = peek();
+        if (c == '"') {
+            skipString();
+        } else if (c == '{' || c == '[') {
+            if (depth == kMaxSkipDepth) {
+                fail("Nesting too deep");
+            }
+            p_++;
+            char close = c == '{' ? '}' : ']';
+            if (consume(close)) {
+                return;
+            }
+            do {
+                if (c == '{') {
+                    if (peek() != '"') {
+                        fail("Expected '\"'");
+                    }
+                    skipString();
+                    expect(':');
+                }
+                skipValue(depth + 1);
+            } while (consume(','));
+            expect(close);
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            const char* literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+            size_t length = std::strlen(literal);
+            if (static_cast<size_t>(end_ - p_) < length || std::memcmp(p_, literal, length) != 0) {
+                fail("Invalid literal");
+            }
+            p_ += length;
+        } else {
+            skipNumber();
+        }
+    }
+
+    // At the opening quote. Checks the escapes as decode() does, without writing the string anywhere
+    void skipString() {
+        const char* p = ++p_;
+        while (true) {
+            p = jsonread::detail::findStringSpecial(p, end_);
+            if (p >= end_) {
+                fail("Unterminated string");
+            }
+            if (*p == '"') {
+                p_ = p + 1;
+                return;
+            }
+            if (*p != '\\') {
+                p_ = p;
+                fail("Unescaped control character in string");
+            }
+            char16_t unit;
+            char16_t* out = &unit;
+            p = decodeEscape(p, end_, out);
+        }
+    }
+
+    /**
+     * @param from Just past the opening quote.
+     * @return The closing quote.
+     */
+    const char* findStringEnd(const char* from) {
+        const char* p = from;
+        while (true) {
+            p = jsonread::detail::findStringSpecial(p, end_);
+            if (p >= end_) {
+                p_ = from;
+                fail("Unterminated string");
+            }
+            if (*p == '"') return p;
+            if (*p != '\\') {
+                p_ = p;
+                fail("Unescaped control character in string");
+            }
+            p += 2; // Skip the escaped character
+        }
+    }
+
+    /**
+     * Decodes the string body [src, stop) into out; stop is the closing quote.
+     * @return The number of UTF-16 code units written.
+     */
+    size_t decode(const char* src, const char* stop, char16_t* out) {
+        char16_t* start = out;
+        while (src < stop) {
+            size_t run = jsonread::detail::widenAsciiRun(src, static_cast<size_t>(stop - src), out);
+            src += run;
+            out += run;
+            if (src >= stop) break;
+
+            auto c = static_cast<unsigned char>(*src);
+            if (c == '\\') {
+                src = decodeEscape(src, stop, out);
+            } else if (c < 0x80) {
+                *out++ = c;
+                src++;
+            } else {
+                src = decodeMultiByte(src, stop, out);
+            }
+        }
+        return static_cast<size_t>(out - start);
+    }
+
+    const char* decodeEscape(const char* src, const char* stop, char16_t*& out) {
+        if (src + 1 >= stop) {
+            p_ = src;
+            fail("Invalid escape");
+        }
+        char escaped = src[1];
+        switch (escaped) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                // Surrogate pairs arrive as two \u escapes and stay two code units
+                int value = 0;
+                for (int i = 2; i < 6; i++) {
+                    int digit = src + i < stop ? jsonread::detail::hexValue(src[i]) : -1;
+                    if (digit < 0) {
+                        p_ = src;
+                        fail("Invalid \\u escape");
+                    }
+                    value = value * 16 + digit;
+                }
+                *out++ = static_cast<char16_t>(value);
+                return src + 6;
+            }
+            default:
+                p_ = src;
+                fail("Invalid escape");
+        }
+        return src + 2;
+    }
+
+    // Invalid or truncated sequences decode to U+FFFD, like the encoder does for unpaired surrogates
+    static const char* decodeMultiByte(const char* src, const char* stop, char16_t*& out) {
+        auto byte = [&](int i) { return static_cast<unsigned char>(src[i]); };
+        auto continuation = [&](int i) { return src + i < stop && (byte(i) & 0xC0) == 0x80; };
+        unsigned char lead = byte(0);
+
+        if (lead >= 0xC2 && lead < 0xE0 && continuation(1)) {
+            *out++ = static_cast<char16_t>(((lead & 0x1F) << 6) | (byte(1) & 0x3F));
+            return src + 2;
+        }
+        if (lead >= 0xE0 && lead < 0xF0 && continuation(1) && continuation(2)) {
+            *out++ = static_cast<char16_t>(((lead & 0x0F) << 12) | ((byte(1) & 0x3F) << 6) | (byte(2) & 0x3F));
+            return src + 3;
+        }
+        if (lead >= 0xF0 && lead < 0xF5 && continuation(1) && continuation(2) && continuation(3)) {
+            uint32_t codePoint = ((lead & 0x07) << 18) | ((byte(1) & 0x3F) << 12) |
+                                 ((byte(2) & 0x3F) << 6) | (byte(3) & 0x3F);
+            if (codePoint >= 0x10000 && codePoint <= 0x10FFFF) {
+                codePoint -= 0x10000;
+                *out++ = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+                *out++ = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+                return src + 4;
+            }
+        }
+        *out++ = 0xFFFD;
+        return src + 1;
+    }
+};
+
+#endif // ANDROID_SDK_JSONREADER_H
@@ -0,0 +1,111 @@
+#ifndef ANDROID_SDK_JSONWRITER_H
+#define ANDROID_SDK_JSONWRITER_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "OutputBuffer.h"
+#include "Utf16ToUtf8.h"
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+/**
+ * @class JsonWriter
+ * @brief OutputBuffer with the JSON text primitives used by the serializer.
+ *
+ * Replaces std::ostringstream: no locale, no virtual stream calls, and the buffer grows geometrically.
+ *
+ * Usage:
+ *   JsonWriter writer;
+ *   writer.literal(R"({"rating":)");
+ *   writer.number(4.5);
+ *   writer.literal("}");
+ *   env->NewStringUTF(writer.c_str());
+ */
+class JsonWriter : public OutputBuffer {
+public:
+    using OutputBuffer::OutputBuffer;
+
+    /**
+     * Appends a string literal; its length is a compile-time constant.
+     */
+    template <size_t N>
+    void literal(const char (&text)[N]) {
+        append(text, N - 1);
+    }
+
+    /**
+     * Appends UTF-8 text as a JSON string: quoted, with '"', '\\' and control characters escaped.
+     */
+    void quoted(const std::string& text) {
+        ensure(text.size() * 6 + 2);
+        data_[size_++] = '"';
+        size_ += utf16::escapeUtf8(text.data(), text.size(), data_ + size_);
+        data_[size_++] = '"';
+    }
+
+    /**
+     * Appends UTF-16 text (e.g. a Java String's chars) as a JSON string, transcoding to UTF-8
+     * and escaping in a single pass straight into the output buffer.
+     */
+    void quotedUtf16(const char16_t* text, size_t length) {
+        ensure(utf16::maxUtf8Length(length, true) + 2);
+        data_[size_++] = '"';
+        size_ += utf16::transcode<true>(text, length, data_ + size_);
+        data_[size_++] = '"';
+    }
+
+    /**
+     * Appends the shortest decimal form that parses back to exactly the same double.
+     * JSON has no NaN/Infinity, so those are written as null.
+     */
+    void number(double value) {
+        if (!std::isfinite(value)) {
+            literal("null");
+            return;
+        }
+        ensure(kMaxDoubleChars);
+        size_ += formatDouble(value, data_ + size_);
+    }
+
+private:
+    // Longest shortest-round-trip form, e.g. "-2.2250738585072014e-308"
+    static constexpr size_t kMaxDoubleChars = 32;
+
+    static size_t formatDouble(double value, char* out) {
+        // Integral values (the common case for prices like 5.0) skip the general algorithm
+        if (value == std::trunc(value) && std::fabs(value) < 1e15) {
+            auto integral = static_cast<long long>(value);
+            char digits[20];
+            size_t count = 0;
+            unsigned long long magnitude = integral < 0 ? 0ULL - static_cast<unsigned long long>(integral)
+                                                        : static_cast<unsigned long long>(integral);
+            do {
+                digits[count++] = static_cast<char>('0' + magnitude % 10);
+                magnitude /= 10;
+            } while (magnitude);
+            size_t length = 0;
+            if (std::signbit(value)) out[length++] = '-';
+            while (count) out[length++] = digits[--count];
+            return length;
+        }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        auto result = std::to_chars(out, out + kMaxDoubleChars, value);
+        return static_cast<size_t>(result.ptr - out);
+#else
+        // No floating-point to_chars in this standard library: take the fewest %g digits that round-trip
+        int length = 0;
+        for (int precision = 15; precision <= 17; precision++) {
+            length = std::snprintf(out, kMaxDoubleChars, "%.*g", precision, value);
+            if (std::strtod(out, nullptr) == value) break;
+        }
+        return static_cast<size_t>(length);
+#endif
+    }
+};
+
+#endif // ANDROID_SDK_JSONWRITER_H
@@ -0,0 +1,227 @@
+#ifndef ANDROID_SDK_MODELDECODING_H
+#define ANDROID_SDK_MODELDECODING_H
+
+#include <jni.h>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "../jni/JavaCollections.h"
+#include "../jni/JavaTime.h"
+#include "../jni/shadowClasses/ModelShadow.h"
+#include "JsonReader.h"
+#include "TemporalFormat.h"
+
+/**
+ * Decoding of JSON straight into Kotlin model objects, the inverse of ModelTraversal.h.
+ *
+ * Each object's properties are decoded into a jvalue array in descriptor order and passed to the
+ * primary constructor resolved in ModelShadow::init(). Lists are sized first (JsonReader::countArrayElements),
+ * filled into one Java array and wrapped with Arrays.asList, so building a list costs two JNI calls plus one
+ * SetObjectArrayElement per element. DayOfWeek values are the cached enum constants, LocalTimes come from
+ * LocalTime.of.
+ *
+ * Accepts everything the serializer emits: keys in any order (declaration order is the fast path), unknown
+ * keys are skipped, "" decodes to a null DayOfWeek/LocalTime, and null is accepted for any reference property.
+ * A missing or null value for a non-null Kotlin property surfaces as the constructor's NullPointerException.
+ *
+ * Errors are thrown (JsonParseError, PendingJavaException) straight out of the native call, which releases every
+ * local reference created so far, so the decoders do not clean up on those paths.
+ */
+namespace modelread {
+
+/**
+ * Thrown when a JNI call left a Java exception pending; the native entry point returns and lets it propagate.
+ */
+class PendingJavaException : public std::exception {
+public:
+    const char* what() const noexcept override {
+        return "Java exception pending";
+    }
+};
+
+/**
+ * Scratch buffers reused across every string of one decode call.
+ */
+struct DecodeScratch {
+    std::u16string text;
+    std::string key;
+};
+
+inline void checkJavaException(JNIEnv* env) {
+    if (env->ExceptionCheck()) {
+        throw PendingJavaException();
+    }
+}
+
+/**
+ * Copies text to out as single bytes.
+ * @return false if text is longer than capacity or not all ASCII.
+ */
+inline bool narrowAscii(const std::u16string& text, char* out, size_t capacity) {
+    if (text.size() > capacity) return false;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] >= 0x80) return false;
+        out[i] = static_cast<char>(text[i]);
+    }
+    return true;
+}
+
+inline jobject decodeDayOfWeek(JsonReader& reader, DecodeScratch& scratch) {
+    reader.readString(scratch.text);
+    if (scratch.text.empty()) {
+        return nullptr;
+    }
+    char name[16];
+    int ordinal = narrowAscii(scratch.text, name, sizeof(name)) ? temporal::parseDayOfWeek(name, scratch.text.size()) : -1;
+    if (ordinal < 0) {
+        reader.fail("Invalid DayOfWeek");
+    }
+    return JavaTime::dayOfWeek(ordinal);
+}
+
+inline jobject decodeLocalTime(JNIEnv* env, JsonReader& reader, DecodeScratch& scratch) {
+    reader.readString(scratch.text);
+    if (scratch.text.empty()) {
+        return nullptr;
+    }
+    char text[temporal::kMaxLocalTimeLength];
+    temporal::LocalTimeParts time;
+    if (!narrowAscii(scratch.text, text, sizeof(text)) || !temporal::parseLocalTime(text, scratch.text.size(), time)) {
+        reader.fail("Invalid LocalTime");
+    }
+    jobject localTime = JavaTime::newLocalTime(env, time);
+    checkJavaException(env);
+    return localTime;
+}
+
+inline jstring decodeString(JNIEnv* env, JsonReader& reader, DecodeScratch& scratch) {
+    reader.readString(scratch.text);
+    jstring javaStr = env->NewString(reinterpret_cast<const jchar*>(scratch.text.data()),
+                                     static_cast<jsize>(scratch.text.size()));
+    checkJavaException(env);
+    return javaStr;
+}
+
+template <typename Model>
+jobject decodeModel(JNIEnv* env, JsonReader& reader, DecodeScratch& scratch);
+
+/**
+ * Decodes a JSON array into Arrays.asList(elements), decoding each element with decodeElement.
+ */
+template <typename DecodeElement>
+jobject decodeList(JNIEnv* env, JsonReader& reader, jclass elementClass, DecodeElement&& decodeElement) {
+    auto count = static_cast<jsize>(reader.countArrayElements());
+    jobjectArray elements = env->NewObjectArray(count, elementClass, nullptr);
+    checkJavaException(env);
+
+    reader.expect('[');
+    for (jsize i = 0; i < count; i++) {
+        if (i > 0) {
+            reader.expect(',');
+        }
+        jobject element = reader.consumeNull() ? nullptr : decodeElement();
+        if (element) {
+            env->SetObjectArrayElement(elements, i, element);
+            env->DeleteLocalRef(element);
+        }
+    }
+    reader.expect(']');
+
+    jobject list = JavaCollections::newList(env, elements);
+    env->DeleteLocalRef(elements);
+    checkJavaException(env);
+    return list;
+}
+
+/**
+ * Decodes the value of field I into arg.
+ * @return true if arg holds a local reference the caller must delete.
+ */
+template <typename Model, size_t I>
+bool decodeField(JNIEnv* env, JsonReader& reader, DecodeScratch& scratch, jvalue& arg) {
+    using Field = typename ModelShadow<Model>::template FieldAt<I>;
+
+    if constexpr (Field::kind == FieldKind::Double) {
+        // The encoder writes non-finite doubles as null
+        arg.d = reader.consumeNull() ? std::numeric_limits<double>::quiet_NaN() : reader.readNumber();
+        return false;
+    } else {
+        if (reader.consumeNull()) {
+            arg.l = nullptr;
+            return false;
+        }
+        if constexpr (Field::kind == FieldKind::String) {
+            arg.l = decodeString(env, reader, scratch);
+        } else if constexpr (Field::kind == FieldKind::DayOfWeek) {
+            arg.l = decodeDayOfWeek(reader, scratch);
+            return false; // Cached global reference
+        } else if constexpr (Field::kind == FieldKind::LocalTime) {
+            arg.l = decodeLocalTime(env, reader, scratch);
+        } else if constexpr (Field::kind == FieldKind::Object) {
+            arg.l = decodeModel<typename Field::Model>(env, reader, scratch);
+        } else if constexpr (Field::kind == FieldKind::StringList) {
+            arg.l = decodeList(env, reader, JavaCollections::javaStringClass(),
+                               [&] { return decodeString(env, reader, scratch); });
+        } else if constexpr (Field::kind == FieldKind::ObjectList) {
+            using Nested = typename Field::Model;
+            arg.l = decodeList(env, reader, ModelShadow<Nested>::javaClass(),
+                               [&] { return decodeModel<Nested>(env, reader, scratch); });
+        }
+        return arg.l != nullptr;
+    }
+}
+
+/**
+ * Decodes one JSON object into a new instance of Model (a new local reference).
+ */
+template <typename Model>
+jobject decodeModel(JNIEnv* env, JsonReader& reader, DecodeScratch& scratch) {
+    using Shadow = ModelShadow<Model>;
+    constexpr size_t kFieldCount = Shadow::kFieldCount;
+
+    if (!Shadow::constructor()) {
+        throw std::runtime_error(std::string("No primary constructor for ") + Model::className);
+    }
+
+    jvalue args[kFieldCount] = {};
+    bool ownsRef[kFieldCount] = {};
+
+    reader.expect('{');
+    if (!reader.consume('}')) {
+        size_t expected = 0;
+        do {
+            std::string_view key = reader.readKey(scratch.key);
+            reader.expect(':');
+            size_t index = Shadow::fieldIndex(key, expected);
+            if (index == kFieldCount) {
+                reader.skipValue();
+                continue;
+            }
+            if (ownsRef[index]) { // Duplicate key: the last one wins
+                env->DeleteLocalRef(args[index].l);
+            }
+            Shadow::forEachField([&](auto i) {
+                constexpr size_t I = decltype(i)::value;
+                if (I == index) {
+                    ownsRef[I] = decodeField<Model, I>(env, reader, scratch, args[I]);
+                }
+            });
+            expected = index + 1;
+        } while (reader.consume(','));
+        reader.expect('}');
+    }
+
+    jobject result = env->NewObjectA(Shadow::javaClass(), Shadow::constructor(), args);
+    for (size_t i = 0; i < kFieldCount; i++) {
+        if (ownsRef[i]) {
+            env->DeleteLocalRef(args[i].l);
+        }
+    }
+    checkJavaException(env);
+    return result;
+}
+
+} // namespace modelread
+
+#endif // ANDROID_SDK_MODELDECODING_H
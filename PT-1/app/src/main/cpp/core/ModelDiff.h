@@ -0,0 +1,373 @@
+#ifndef ANDROID_SDK_MODELDIFF_H
+#define ANDROID_SDK_MODELDIFF_H
+
+#include <jni.h>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../jni/JavaCollections.h"
+#include "../jni/JavaStrings.h"
+#include "../jni/LocalFrame.h"
+#include "../jni/shadowClasses/ModelShadow.h"
+#include "JsonEncoder.h"
+#include "JsonWriter.h"
+#include "ModelTraversal.h"
+
+/**
+ * RFC 6902 JSON Patch between two versions of a model, computed by walking both object graphs in parallel.
+ *
+ * The patch applies to the serializer's JSON output (same keys, same value encoding). Changed scalars
+ * become "replace" operations; nested objects are diffed recursively. Lists of models with a keyField
+ * (menu items by id, opening hours by dayOfWeek) are matched by key: missing elements are removed,
+ * reordered ones moved, new ones added, matched ones diffed in place. Other lists, and keyed lists with
+ * duplicate keys, are diffed by position.
+ *
+ * Reference-equal subtrees (IsSameObject) are skipped without reading them, so an unchanged list that
+ * was carried over by copy() costs one JNI call.
+ */
+namespace modeldiff {
+
+/**
+ * @class JsonPatchWriter
+ * @brief Writes the operations array of a JSON Patch.
+ */
+class JsonPatchWriter {
+public:
+    explicit JsonPatchWriter(JsonWriter& writer) : writer_(writer), count_(0) {
+        writer_.append('[');
+    }
+
+    void finish() {
+        writer_.append(']');
+    }
+
+    /**
+     * Starts an add/replace operation; encode the value with the returned encoder, then call endOp().
+     */
+    JsonEncoder beginValueOp(const char* op, const std::string& path) {
+        beginOp(op, path);
+        writer_.literal(R"(,"value":)");
+        return JsonEncoder(writer_);
+    }
+
+    void endOp() {
+        writer_.append('}');
+    }
+
+    void remove(const std::string& path) {
+        beginOp("remove", path);
+        endOp();
+    }
+
+    void move(const std::string& from, const std::string& path) {
+        beginOp("move", path);
+        writer_.literal(R"(,"from":)");
+        writer_.quoted(from);
+        endOp();
+    }
+
+    size_t count() const {
+        return count_;
+    }
+
+private:
+    JsonWriter& writer_;
+    size_t count_;
+
+    void beginOp(const char* op, const std::string& path) {
+        if (count_++ > 0) {
+            writer_.append(',');
+        }
+        writer_.literal(R"({"op":")");
+        writer_.append(op, std::strlen(op));
+        writer_.literal(R"(","path":)");
+        writer_.quoted(path);
+    }
+};
+
+/**
+ * Appends "/segment" to a JSON Pointer and removes it again when it goes out of scope.
+ * Model property names never contain '~' or '/', so no escaping is needed.
+ */
+class PathSegment {
+public:
+    PathSegment(std::string& path, std::string_view segment) : path_(path), mark_(path.size()) {
+        path_ += '/';
+        path_.append(segment.data(), segment.size());
+    }
+
+    PathSegment(std::string& path, size_t index) : PathSegment(path, std::to_string(index)) {}
+
+    ~PathSegment() {
+        path_.resize(mark_);
+    }
+
+private:
+    std::string& path_;
+    size_t mark_;
+};
+
+inline std::string indexPath(const std::string& listPath, size_t index) {
+    return listPath + "/" + std::to_string(index);
+}
+
+/**
+ * Content equality of two jstrings as the serializer sees them: null equals "", since both are written as "".
+ * Never holds a critical section across JNI calls.
+ */
+inline bool equalStrings(JNIEnv* env, jstring a, jstring b) {
+    if (env->IsSameObject(a, b)) return true;
+    if (!a || !b) return env->GetStringLength(a ? a : b) == 0;
+    jsize length = env->GetStringLength(a);
+    if (length != env->GetStringLength(b)) return false;
+
+    std::u16string copy(static_cast<size_t>(length), u'\0');
+    env->GetStringRegion(b, 0, length, reinterpret_cast<jchar*>(&copy[0]));
+    JavaStringChars chars(env, a);
+    return std::memcmp(chars.data(), copy.data(), copy.size() * sizeof(char16_t)) == 0;
+}
+
+// Bitwise first, so NaN equals NaN and 0.0 differs from -0.0 (they encode differently)
+inline bool equalDoubles(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+template <typename Model>
+void diffModel(JNIEnv* env, const ModelShadow<Model>& before, const ModelShadow<Model>& after,
+               std::string& path, JsonPatchWriter& patch);
+
+/**
+ * The element's keyField value as a string (UTF-8 for String keys, the ordinal for DayOfWeek keys).
+ */
+template <typename Model>
+std::string elementKey(JNIEnv* env, const ModelShadow<Model>& element) {
+    constexpr size_t K = ModelShadow<Model>::field(Model::keyField);
+    using KeyField = typename ModelShadow<Model>::template FieldAt<K>;
+    static_assert(KeyField::kind == FieldKind::String || KeyField::kind == FieldKind::DayOfWeek,
+                  "keyField must be a String or DayOfWeek property");
+    if constexpr (KeyField::kind == FieldKind::String) {
+        return std::string(element.template readString<K>(env));
+    } else {
+        return std::to_string(element.template readDayOfWeekOrdinal<K>(env));
+    }
+}
+
+/**
+ * List element operations; Model is void for List<String>.
+ */
+template <typename Model>
+struct ListElements {
+    static void diff(JNIEnv* env, jobject before, jobject after, std::string& path, JsonPatchWriter& patch) {
+        if (env->IsSameObject(before, after)) return;
+        if constexpr (std::is_void_v<Model>) {
+            if (!equalStrings(env, (jstring)before, (jstring)after)) {
+                JsonEncoder encoder = patch.beginValueOp("replace", path);
+                encode(env, after, encoder);
+                patch.endOp();
+            }
+        } else if (!before || !after) {
+            JsonEncoder encoder = patch.beginValueOp("replace", path);
+            encode(env, after, encoder);
+            patch.endOp();
+        } else {
+            ModelShadow<Model> beforeShadow(env, before);
+            ModelShadow<Model> afterShadow(env, after);
+            diffModel(env, beforeShadow, afterShadow, path, patch);
+        }
+    }
+
+    static void encode(JNIEnv* env, jobject element, JsonEncoder& encoder) {
+        if constexpr (std::is_void_v<Model>) {
+            JavaStringChars chars(env, (jstring)element);
+            encoder.string(chars.data(), chars.size());
+        } else if (!element) {
+            encoder.null();
+        } else {
+            ModelShadow<Model> shadow(env, element);
+            modelwalk::encodeModel(env, shadow, encoder);
+        }
+    }
+
+    static void add(JNIEnv* env, jobject element, const std::string& path, JsonPatchWriter& patch) {
+        JsonEncoder encoder = patch.beginValueOp("add", path);
+        encode(env, element, encoder);
+        patch.endOp();
+    }
+};
+
+/**
+ * Diffs two lists position by position, then removes or appends the tail.
+ */
+template <typename Model>
+void diffListByPosition(JNIEnv* env, const JavaObjectList& before, const JavaObjectList& after,
+                        std::string& path, JsonPatchWriter& patch) {
+    jint common = before.size() < after.size() ? before.size() : after.size();
+    LocalFrameChunker frames(env);
+    for (jint i = 0; i < common; i++) {
+        frames.next();
+        PathSegment segment(path, static_cast<size_t>(i));
+        ListElements<Model>::diff(env, before.get(env, i), after.get(env, i), path, patch);
+    }
+    // Highest index first, so the remaining indices stay valid
+    for (jint i = before.size() - 1; i >= common; i--) {
+        patch.remove(indexPath(path, static_cast<size_t>(i)));
+    }
+    for (jint i = common; i < after.size(); i++) {
+        frames.next();
+        ListElements<Model>::add(env, after.get(env, i), indexPath(path, static_cast<size_t>(i)), patch);
+    }
+}
+
+/**
+ * Reads the keys of all elements; false if a key repeats (or an element is null).
+ */
+template <typename Model>
+bool readUniqueKeys(JNIEnv* env, const JavaObjectList& list, std::vector<std::string>& keys,
+                    std::unordered_map<std::string, jint>& positions) {
+    keys.reserve(static_cast<size_t>(list.size()));
+    LocalFrameChunker frames(env);
+    for (jint i = 0; i < list.size(); i++) {
+        frames.next();
+        jobject element = list.get(env, i);
+        if (!element) return false;
+        ModelShadow<Model> shadow(env, element);
+        keys.push_back(elementKey(env, shadow));
+        if (!positions.emplace(keys.back(), i).second) return false;
+    }
+    return true;
+}
+
+/**
+ * Diffs two lists whose elements are matched by Model::keyField.
+ * Operations are emitted in the order they must be applied: removals (highest index first), then one
+ * pass over the new order that moves, adds or diffs in place the element at each position.
+ */
+template <typename Model>
+void diffListByKey(JNIEnv* env, const JavaObjectList& before, const JavaObjectList& after,
+                   std::string& path, JsonPatchWriter& patch) {
+    std::vector<std::string> beforeKeys, afterKeys;
+    std::unordered_map<std::string, jint> beforePositions, afterPositions;
+    if (!readUniqueKeys<Model>(env, before, beforeKeys, beforePositions) ||
+        !readUniqueKeys<Model>(env, after, afterKeys, afterPositions)) {
+        diffListByPosition<Model>(env, before, after, path, patch);
+        return;
+    }
+
+    for (jint i = before.size() - 1; i >= 0; i--) {
+        if (afterPositions.find(beforeKeys[i]) == afterPositions.end()) {
+            patch.remove(indexPath(path, static_cast<size_t>(i)));
+        }
+    }
+
+    // The list as it is after the operations so far: indices into before, -1 for added elements
+    std::vector<jint> current;
+    current.reserve(static_cast<size_t>(after.size()));
+    for (jint i = 0; i < before.size(); i++) {
+        if (afterPositions.find(beforeKeys[i]) != afterPositions.end()) {
+            current.push_back(i);
+        }
+    }
+
+    LocalFrameChunker frames(env);
+    for (jint j = 0; j < after.size(); j++) {
+        frames.next();
+        auto position = static_cast<size_t>(j);
+        auto matched = beforePositions.find(afterKeys[j]);
+        if (matched == beforePositions.end()) {
+            ListElements<Model>::add(env, after.get(env, j), indexPath(path, position), patch);
+            current.insert(current.begin() + j, -1);
+            continue;
+        }
+        if (current[position] != matched->second) {
+            // Positions before j hold other keys, so the element can only be further down
+            size_t from = position + 1;
+            while (current[from] != matched->second) from++;
+            patch.move(indexPath(path, from), indexPath(path, position));
+            current.erase(current.begin() + static_cast<std::ptrdiff_t>(from));
+            current.insert(current.begin() + j, matched->second);
+        }
+        PathSegment segment(path, position);
+        ListElements<Model>::diff(env, before.get(env, matched->second), after.get(env, j), path, patch);
+    }
+}
+
+/**
+ * Diffs field I, reading each side at most once; reference-typed fields short-circuit on IsSameObject.
+ */
+template <typename Model, size_t I>
+void diffField(JNIEnv* env, const ModelShadow<Model>& before, const ModelShadow<Model>& after,
+               std::string& path, JsonPatchWriter& patch) {
+    using Field = typename ModelShadow<Model>::template FieldAt<I>;
+    PathSegment segment(path, ModelShadow<Model>::template fieldName<I>());
+    auto replace = [&] {
+        JsonEncoder encoder = patch.beginValueOp("replace", path);
+        modelwalk::encodeModelField<Model, I>(env, after, encoder);
+        patch.endOp();
+    };
+
+    if constexpr (Field::kind == FieldKind::Double) {
+        if (!equalDoubles(before.template readDouble<I>(env), after.template readDouble<I>(env))) replace();
+    } else if constexpr (Field::kind == FieldKind::DayOfWeek) {
+        if (before.template readDayOfWeekOrdinal<I>(env) != after.template readDayOfWeekOrdinal<I>(env)) replace();
+    } else if constexpr (Field::kind == FieldKind::LocalTime) {
+        temporal::LocalTimeParts a, b;
+        bool hasA = before.template readLocalTime<I>(env, a);
+        bool hasB = after.template readLocalTime<I>(env, b);
+        if (hasA != hasB || (hasA && (a.hour != b.hour || a.minute != b.minute || a.second != b.second ||
+                                      a.nano != b.nano))) {
+            replace();
+        }
+    } else {
+        jobject a = before.template readObject<I>(env);
+        jobject b = after.template readObject<I>(env);
+        if (!env->IsSameObject(a, b)) {
+            if constexpr (Field::kind == FieldKind::String) {
+                if (!equalStrings(env, (jstring)a, (jstring)b)) replace();
+            } else if constexpr (Field::kind == FieldKind::Object) {
+                if (!a || !b) {
+                    replace();
+                } else {
+                    ModelShadow<typename Field::Model> nestedBefore(env, a);
+                    ModelShadow<typename Field::Model> nestedAfter(env, b);
+                    diffModel(env, nestedBefore, nestedAfter, path, patch);
+                }
+            } else if constexpr (Field::kind == FieldKind::StringList || Field::kind == FieldKind::ObjectList) {
+                using Element = std::conditional_t<Field::kind == FieldKind::StringList, void, typename Field::Model>;
+                JavaObjectList beforeList(env, a);
+                JavaObjectList afterList(env, b);
+                if constexpr (!std::is_void_v<Element> && HasKeyField<Element>::value) {
+                    diffListByKey<Element>(env, beforeList, afterList, path, patch);
+                } else {
+                    diffListByPosition<Element>(env, beforeList, afterList, path, patch);
+                }
+            }
+        }
+        if (a) {
+            env->DeleteLocalRef(a);
+            NATIVE_STATS_LOCAL_REF_DELETED();
+        }
+        if (b) {
+            env->DeleteLocalRef(b);
+            NATIVE_STATS_LOCAL_REF_DELETED();
+        }
+    }
+}
+
+/**
+ * Appends the operations that turn before's JSON into after's JSON; path is the pointer to the model.
+ */
+template <typename Model>
+void diffModel(JNIEnv* env, const ModelShadow<Model>& before, const ModelShadow<Model>& after,
+               std::string& path, JsonPatchWriter& patch) {
+    if (env->IsSameObject(before.object(), after.object())) {
+        return;
+    }
+    ModelShadow<Model>::forEachField([&](auto i) {
+        diffField<Model, decltype(i)::value>(env, before, after, path, patch);
+    });
+}
+
+} // namespace modeldiff
+
+#endif // ANDROID_SDK_MODELDIFF_H
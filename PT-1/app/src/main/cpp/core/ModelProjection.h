@@ -0,0 +1,162 @@
+#ifndef ANDROID_SDK_MODELPROJECTION_H
+#define ANDROID_SDK_MODELPROJECTION_H
+
+#include <jni.h>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../jni/shadowClasses/ModelShadow.h"
+#include "ModelTraversal.h"
+#include "NativeStats.h"
+
+/**
+ * Field projection: encodes only a selected subset of a model's fields, and reads only those.
+ *
+ * A projection is compiled once from dotted field paths ("id", "address.city", "menu.price") into a Selection
+ * tree and can then be used for any number of objects, from any thread. Unselected fields cost nothing: no
+ * JNI read, no transcoding, and an unselected list is never fetched. Selecting an object or list field by
+ * itself ("menu") includes it whole; a path into it ("menu.price") narrows its elements to the named fields.
+ *
+ * Selected keys keep descriptor order, whatever the order of the paths, so a projection of the full field
+ * set encodes exactly like encodeModel. Null handling is the same as in ModelTraversal.h.
+ */
+namespace projection {
+
+/**
+ * A field path does not name a field of the model.
+ */
+class ProjectionError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @class Selection
+ * @brief The selected fields of one model, with narrower selections for some of its nested models.
+ */
+class Selection {
+public:
+    bool selects(size_t field) const {
+        return (fields_ >> field) & 1;
+    }
+
+    size_t count() const {
+        return static_cast<size_t>(__builtin_popcountll(fields_));
+    }
+
+    /**
+     * @return The selection applied to the nested model(s) of field, or null when the field is selected whole.
+     */
+    const Selection* narrowed(size_t field) const {
+        return field < nested_.size() ? nested_[field].get() : nullptr;
+    }
+
+    /**
+     * Adds the dotted path to this selection of Model.
+     * @throws ProjectionError for an unknown field, or a path into a field that has no fields of its own.
+     */
+    template <typename Model>
+    void add(std::string_view path) {
+        using Shadow = ModelShadow<Model>;
+        static_assert(Shadow::kFieldCount <= 64, "the selection is a 64-bit mask");
+
+        size_t dot = path.find('.');
+        std::string_view name = path.substr(0, dot);
+        size_t index = Shadow::fieldIndex(name, 0);
+        if (index == Shadow::kFieldCount) {
+            throw ProjectionError("Unknown field \"" + std::string(name) + "\" in " + Model::className);
+        }
+        bool wasWhole = selects(index) && !narrowed(index);
+        fields_ |= uint64_t(1) << index;
+        if (dot == std::string_view::npos) {
+            if (index < nested_.size()) {
+                nested_[index].reset(); // Whole field wins over any earlier narrower path
+            }
+            return;
+        }
+        Shadow::forEachField([&](auto i) {
+            constexpr size_t I = decltype(i)::value;
+            if (I != index) return;
+            using Field = typename Shadow::template FieldAt<I>;
+            if constexpr (Field::kind == FieldKind::Object || Field::kind == FieldKind::ObjectList) {
+                if (wasWhole) {
+                    Selection().add<typename Field::Model>(path.substr(dot + 1)); // Validated, but the field stays whole
+                    return;
+                }
+                nested_.resize(Shadow::kFieldCount);
+                if (!nested_[I]) {
+                    nested_[I] = std::make_unique<Selection>();
+                }
+                nested_[I]->template add<typename Field::Model>(path.substr(dot + 1));
+            } else {
+                throw ProjectionError("Field \"" + std::string(name) + "\" has no fields to select");
+            }
+        });
+    }
+
+private:
+    uint64_t fields_ = 0;
+    std::vector<std::unique_ptr<Selection>> nested_; // Indexed by field; empty until a path narrows a field
+};
+
+/**
+ * Compiles field paths against Model.
+ * @throws ProjectionError
+ */
+template <typename Model>
+std::unique_ptr<Selection> compile(const std::vector<std::string>& paths) {
+    auto selection = std::make_unique<Selection>();
+    for (const std::string& path : paths) {
+        selection->add<Model>(path);
+    }
+    return selection;
+}
+
+/**
+ * Encodes the selected fields of the model behind shadow as one object.
+ */
+template <typename Model, typename Encoder>
+void encodeProjected(JNIEnv* env, const ModelShadow<Model>& shadow, const Selection& selection, Encoder& encoder) {
+    using Shadow = ModelShadow<Model>;
+    encoder.beginObject(selection.count());
+    Shadow::forEachField([&](auto i) {
+        constexpr size_t I = decltype(i)::value;
+        if (!selection.selects(I)) return;
+        using Field = typename Shadow::template FieldAt<I>;
+        encoder.key(Shadow::template fieldName<I>());
+
+        const Selection* nested = selection.narrowed(I);
+        if constexpr (Field::kind == FieldKind::Object) {
+            if (nested) {
+                jobject obj = shadow.template readObject<I>(env);
+                modelwalk::encodeNestedObject<typename Field::Model>(env, obj, encoder, [&](const auto& nestedShadow) {
+                    encodeProjected(env, nestedShadow, *nested, encoder);
+                });
+                if (obj) {
+                    NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+                    env->DeleteLocalRef(obj);
+                    NATIVE_STATS_LOCAL_REF_DELETED();
+                }
+                return;
+            }
+        } else if constexpr (Field::kind == FieldKind::ObjectList) {
+            if (nested) {
+                modelwalk::encodeJavaList(env, shadow.template readObject<I>(env), encoder, [&](jobject elem) {
+                    modelwalk::encodeNestedObject<typename Field::Model>(env, elem, encoder, [&](const auto& elemShadow) {
+                        encodeProjected(env, elemShadow, *nested, encoder);
+                    });
+                });
+                return;
+            }
+        }
+        modelwalk::encodeModelField<Model, I>(env, shadow, encoder);
+    });
+    encoder.endObject();
+}
+
+} // namespace projection
+
+#endif // ANDROID_SDK_MODELPROJECTION_H
@@ -0,0 +1,203 @@
+#ifndef ANDROID_SDK_MODELTRAVERSAL_H
+#define ANDROID_SDK_MODELTRAVERSAL_H
+
+#include <jni.h>
+#include <type_traits>
+#include "../jni/JavaCollections.h"
+#include "../jni/JavaStrings.h"
+#include "../jni/LocalFrame.h"
+#include "../jni/shadowClasses/ModelShadow.h"
+#include "NativeStats.h"
+#include "StringDictionary.h"
+#include "TemporalFormat.h"
+
+/**
+ * Format-neutral traversal of any model described to ModelShadow.
+ *
+ * The traversal reads the Java objects and reports what it finds to an Encoder, which decides the bytes.
+ * An Encoder is any class with:
+ *
+ *   void beginObject(size_t fieldCount);  void key(std::string_view name);  void endObject();
+ *   void beginArray(size_t elementCount); void endArray();
+ *   void string(const char16_t* text, size_t length);     // a Java String's UTF-16 chars
+ *   void plainString(const char* text, size_t length);    // ASCII that needs no escaping
+ *   void number(double value);
+ *   void null();
+ *
+ * See JsonEncoder.h and BinaryEncoders.h. Both the field and the encoder are template parameters, so every
+ * field is written by its own instantiation of encodeModelField, chosen with if constexpr on the descriptor's
+ * FieldKind: no virtual calls and no lookups by name. Keys are emitted in descriptor (Kotlin declaration) order.
+ *
+ * Encoders may also offer StringDictionary* stringDictionary() and void repeatString(uint32_t entry); when
+ * the dictionary is set, a string field whose object is the same as last time is written without reading it.
+ *
+ * Null strings are encoded as "", null nested objects as null and null lists as empty arrays.
+ */
+namespace modelwalk {
+
+/**
+ * Encodes DayOfWeek.name() for ordinal ("" when out of range, e.g. null).
+ */
+template <typename Encoder>
+void encodeDayOfWeek(Encoder& encoder, jint ordinal) {
+    if (ordinal >= 0 && ordinal < 7) {
+        const temporal::DayName& day = temporal::kDayOfWeekNames[ordinal];
+        encoder.plainString(day.text, day.length);
+    } else {
+        encoder.plainString("", 0);
+    }
+}
+
+/**
+ * Encodes time exactly like LocalTime.toString() ("" for null).
+ */
+template <typename Encoder>
+void encodeLocalTime(Encoder& encoder, const temporal::LocalTimeParts* time) {
+    char buffer[temporal::kMaxLocalTimeLength];
+    size_t length = time ? temporal::formatLocalTime(*time, buffer) : 0;
+    encoder.plainString(buffer, length);
+}
+
+template <typename Encoder, typename = void>
+struct HasStringDictionary : std::false_type {};
+
+template <typename Encoder>
+struct HasStringDictionary<Encoder, std::void_t<decltype(std::declval<Encoder&>().stringDictionary())>>
+        : std::true_type {};
+
+/**
+ * Encodes javaStr ("" for null) and deletes its local reference.
+ * @param site Identifies the field javaStr was read from, for the encoder's StringDictionary; null for none.
+ */
+template <typename Encoder>
+void encodeJavaString(JNIEnv* env, Encoder& encoder, jstring javaStr, const void* site = nullptr) {
+    StringDictionary* strings = nullptr;
+    if constexpr (HasStringDictionary<Encoder>::value) {
+        strings = site && javaStr ? encoder.stringDictionary() : nullptr;
+    }
+    uint32_t entry = StringDictionary::kNone;
+    if (strings) {
+        entry = strings->findSameObject(site, [&](const void* last) {
+            NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+            return env->IsSameObject(javaStr, static_cast<jobject>(const_cast<void*>(last)));
+        });
+    }
+    if (entry != StringDictionary::kNone) {
+        if constexpr (HasStringDictionary<Encoder>::value) {
+            encoder.repeatString(entry);
+        }
+    } else {
+        {
+            JavaStringChars chars(env, javaStr);
+            NATIVE_STATS_PHASE(Transcode);
+            encoder.string(chars.data(), chars.size());
+        }
+        if (strings) {
+            strings->rememberObject(site, [&]() -> const void* {
+                NATIVE_STATS_GLOBAL_REF();
+                return env->NewGlobalRef(javaStr);
+            }, [&](const void* object) {
+                env->DeleteGlobalRef(static_cast<jobject>(const_cast<void*>(object)));
+            });
+        }
+    }
+    if (javaStr) {
+        NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+        env->DeleteLocalRef(javaStr);
+        NATIVE_STATS_LOCAL_REF_DELETED();
+    }
+}
+
+template <typename Model, typename Encoder>
+void encodeModel(JNIEnv* env, const ModelShadow<Model>& shadow, Encoder& encoder);
+
+/**
+ * Encodes the Nested model object obj (null as null) through encodeNested(shadow); obj's reference is left to the caller.
+ */
+template <typename Nested, typename Encoder, typename EncodeNested>
+void encodeNestedObject(JNIEnv* env, jobject obj, Encoder& encoder, EncodeNested&& encodeNested) {
+    if (!obj) {
+        encoder.null();
+        return;
+    }
+    ModelShadow<Nested> nestedShadow(env, obj);
+    encodeNested(nestedShadow);
+}
+
+/**
+ * Encodes a java.util collection (null as []) as an array, each element through encodeElement(jobject), then
+ * deletes the collection's local reference. Element references are released in chunks (LocalFrameChunker).
+ */
+template <typename Encoder, typename EncodeElement>
+void encodeJavaList(JNIEnv* env, jobject collection, Encoder& encoder, EncodeElement&& encodeElement) {
+    {
+        JavaObjectList elements(env, collection);
+        jint count = elements.size();
+        encoder.beginArray(static_cast<size_t>(count));
+        LocalFrameChunker frames(env);
+        for (jint i = 0; i < count; i++) {
+            frames.next();
+            encodeElement(elements.get(env, i));
+        }
+        encoder.endArray();
+    }
+    if (collection) {
+        NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+        env->DeleteLocalRef(collection);
+        NATIVE_STATS_LOCAL_REF_DELETED();
+    }
+}
+
+template <typename Model, size_t I, typename Encoder>
+void encodeModelField(JNIEnv* env, const ModelShadow<Model>& shadow, Encoder& encoder) {
+    using Field = typename ModelShadow<Model>::template FieldAt<I>;
+
+    if constexpr (Field::kind == FieldKind::String) {
+        encodeJavaString(env, encoder, shadow.template readJString<I>(env), &ModelShadow<Model>::template property<I>());
+    } else if constexpr (Field::kind == FieldKind::Double) {
+        encoder.number(shadow.template readDouble<I>(env));
+    } else if constexpr (Field::kind == FieldKind::DayOfWeek) {
+        encodeDayOfWeek(encoder, shadow.template readDayOfWeekOrdinal<I>(env));
+    } else if constexpr (Field::kind == FieldKind::LocalTime) {
+        temporal::LocalTimeParts time;
+        encodeLocalTime(encoder, shadow.template readLocalTime<I>(env, time) ? &time : nullptr);
+    } else if constexpr (Field::kind == FieldKind::Object) {
+        jobject nested = shadow.template readObject<I>(env);
+        encodeNestedObject<typename Field::Model>(env, nested, encoder, [&](const auto& nestedShadow) {
+            encodeModel(env, nestedShadow, encoder);
+        });
+        if (nested) {
+            NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+            env->DeleteLocalRef(nested);
+            NATIVE_STATS_LOCAL_REF_DELETED();
+        }
+    } else if constexpr (Field::kind == FieldKind::StringList) {
+        encodeJavaList(env, shadow.template readObject<I>(env), encoder, [&](jobject elem) {
+            encodeJavaString(env, encoder, (jstring)elem, &ModelShadow<Model>::template property<I>());
+        });
+    } else if constexpr (Field::kind == FieldKind::ObjectList) {
+        encodeJavaList(env, shadow.template readObject<I>(env), encoder, [&](jobject elem) {
+            encodeNestedObject<typename Field::Model>(env, elem, encoder, [&](const auto& elemShadow) {
+                encodeModel(env, elemShadow, encoder);
+            });
+        });
+    }
+}
+
+/**
+ * Encodes the model behind shadow as one object (map) with a key per descriptor field.
+ */
+template <typename Model, typename Encoder>
+void encodeModel(JNIEnv* env, const ModelShadow<Model>& shadow, Encoder& encoder) {
+    encoder.beginObject(ModelShadow<Model>::kFieldCount);
+    ModelShadow<Model>::forEachField([&](auto i) {
+        constexpr size_t I = decltype(i)::value;
+        encoder.key(ModelShadow<Model>::template fieldName<I>());
+        encodeModelField<Model, I>(env, shadow, encoder);
+    });
+    encoder.endObject();
+}
+
+} // namespace modelwalk
+
+#endif // ANDROID_SDK_MODELTRAVERSAL_H
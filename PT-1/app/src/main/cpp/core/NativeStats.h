@@ -0,0 +1,381 @@
+#ifndef ANDROID_SDK_NATIVESTATS_H
+#define ANDROID_SDK_NATIVESTATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "JsonWriter.h"
+
+/**
+ * Opt-in instrumentation of the native layer, compiled in only when RESTAURANT_INSTRUMENTATION is defined
+ * (the CMake option of the same name, e.g. arguments += "-DRESTAURANT_INSTRUMENTATION=ON" in Gradle's
+ * externalNativeBuild.cmake block). Without it every NATIVE_STATS_* macro expands to nothing.
+ *
+ * Counted per thread, and summed over all threads (including exited ones) by NativeStats::snapshot():
+ *  - JNI calls by JniCall kind, as made by the shadow classes and the string and collection helpers
+ *  - local and global references created by them, and the peak number of those local references alive at once on
+ *    one thread (a local frame pop or the end of a native call releases everything created inside it)
+ *  - bytes of encoded output produced by the native entry points
+ *  - heap allocations made by the library and the libc++ linked into it (AllocationCounter.cpp wraps malloc)
+ *  - per Phase: how many scopes ran, their total time and a log2 histogram of their durations (bucket b counts
+ *    durations in [2^b, 2^(b+1)) ns). Phases nest and are timed inclusively, e.g. Transcode is part of Encode,
+ *    which is part of Call.
+ *
+ * The fine-grained phases (FieldRead, StringRead, Transcode) read the clock twice per property, which inflates
+ * Call and Encode; compare instrumented builds with instrumented builds only.
+ *
+ * While a trace runs (startTrace), the coarse phases (Call, ResultString, BatchChunk, FdWrite) are also recorded
+ * as spans, exported in the Chrome trace event format for chrome://tracing or Perfetto.
+ */
+namespace nativestats {
+
+enum class JniCall : size_t {
+    FieldRead,      // Get<Type>Field on a model property
+    GetterCall,     // Call<Type>Method on a model property's getter
+    StringRead,     // GetStringLength, GetStringRegion, Get/ReleaseStringCritical
+    ListRead,       // Collection backing array and element reads
+    StringCreation, // Building the result String
+    Reference,      // Local frames, DeleteLocalRef, NewGlobalRef
+    kCount
+};
+
+enum class Phase : size_t {
+    Call,         // A native entry point, end to end
+    Encode,       // Traversal of one restaurant into an encoder or tape
+    FieldRead,    // One property read
+    StringRead,   // Copying or pinning one Java String's chars
+    Transcode,    // Encoding one string's UTF-16 chars
+    ResultString, // Creating the result String from UTF-8
+    BatchChunk,   // A pool worker encoding one chunk of a batch
+    FdWrite,      // One writev() of an export
+    kCount
+};
+
+constexpr size_t kJniCallKinds = static_cast<size_t>(JniCall::kCount);
+constexpr size_t kPhases = static_cast<size_t>(Phase::kCount);
+constexpr size_t kHistogramBuckets = 32;
+
+// Counter slots: one per JniCall kind, then the reference, byte and heap allocation totals and the local reference
+// peak, then count, total ns and histogram per phase
+constexpr size_t kLocalRefsSlot = kJniCallKinds;
+constexpr size_t kGlobalRefsSlot = kLocalRefsSlot + 1;
+constexpr size_t kBytesSlot = kGlobalRefsSlot + 1;
+constexpr size_t kHeapAllocationsSlot = kBytesSlot + 1;
+constexpr size_t kLocalRefsPeakSlot = kHeapAllocationsSlot + 1; // A maximum over threads, not a sum
+constexpr size_t kFirstPhaseSlot = kLocalRefsPeakSlot + 1;
+constexpr size_t kSlotsPerPhase = 2 + kHistogramBuckets;
+constexpr size_t kSlotCount = kFirstPhaseSlot + kPhases * kSlotsPerPhase;
+
+#ifdef RESTAURANT_INSTRUMENTATION
+constexpr bool kEnabled = true;
+#else
+constexpr bool kEnabled = false;
+#endif
+
+inline const char* phaseName(Phase phase) {
+    static const char* const kNames[] = {"call", "encode", "fieldRead", "stringRead",
+                                         "transcode", "resultString", "batchChunk", "fdWrite"};
+    return kNames[static_cast<size_t>(phase)];
+}
+
+inline int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @class NativeStats
+ * @brief Registry of every thread's counters, plus the trace buffer.
+ *
+ * Each thread only ever adds to its own counters (relaxed atomics, no sharing); snapshot() and reset() walk
+ * all registered threads under the registry lock.
+ */
+class NativeStats {
+public:
+    static void countJni(JniCall kind, uint64_t calls) {
+        add(static_cast<size_t>(kind), calls);
+    }
+
+    static void countLocalRef(bool created) {
+        if (!created) {
+            return;
+        }
+        ThreadCounters& counters = threadCounters();
+        counters.slots[kLocalRefsSlot].fetch_add(1, std::memory_order_relaxed);
+        auto live = static_cast<uint64_t>(++counters.liveLocalRefs > 0 ? counters.liveLocalRefs : 0);
+        if (live > counters.slots[kLocalRefsPeakSlot].load(std::memory_order_relaxed)) {
+            counters.slots[kLocalRefsPeakSlot].store(live, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * A DeleteLocalRef of a reference counted by countLocalRef.
+     */
+    static void countLocalRefDeleted() {
+        threadCounters().liveLocalRefs--;
+    }
+
+    /**
+     * The counted local references alive on this thread; restoreLiveLocalRefs(mark) when a local frame pushed at
+     * mark is popped, or a native call that started at mark returns.
+     */
+    static int64_t liveLocalRefs() {
+        return threadCounters().liveLocalRefs;
+    }
+
+    static void restoreLiveLocalRefs(int64_t mark) {
+        threadCounters().liveLocalRefs = mark;
+    }
+
+    static void countGlobalRef() {
+        add(kGlobalRefsSlot, 1);
+    }
+
+    static void countBytes(size_t bytes) {
+        add(kBytesSlot, bytes);
+    }
+
+    /**
+     * Called from the wrapped malloc, so it must not allocate: one process-wide counter instead of the thread's slots,
+     * whose first use allocates.
+     */
+    static void countHeapAllocation() {
+        heapAllocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void recordPhase(Phase phase, int64_t nanos) {
+        size_t slot = kFirstPhaseSlot + static_cast<size_t>(phase) * kSlotsPerPhase;
+        auto duration = static_cast<uint64_t>(nanos > 0 ? nanos : 0);
+        size_t bucket = duration > 1 ? 63 - static_cast<size_t>(__builtin_clzll(duration)) : 0;
+        add(slot, 1);
+        add(slot + 1, duration);
+        add(slot + 2 + (bucket < kHistogramBuckets ? bucket : kHistogramBuckets - 1), 1);
+    }
+
+    /**
+     * @return Every slot summed over all threads, kSlotCount values.
+     */
+    static std::vector<int64_t> snapshot() {
+        auto heapAllocations = static_cast<int64_t>(heapAllocations_.load(std::memory_order_relaxed)); // Before our own
+        Registry& registry = Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        std::vector<int64_t> totals(registry.retired.begin(), registry.retired.end());
+        for (const ThreadCounters* counters : registry.threads) {
+            for (size_t i = 0; i < kSlotCount; i++) {
+                auto value = static_cast<int64_t>(counters->slots[i].load(std::memory_order_relaxed));
+                totals[i] = i == kLocalRefsPeakSlot ? std::max(totals[i], value) : totals[i] + value;
+            }
+        }
+        totals[kHeapAllocationsSlot] += heapAllocations;
+        return totals;
+    }
+
+    /**
+     * Zeroes all counters; increments racing with the reset may survive it.
+     */
+    static void reset() {
+        Registry& registry = Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.retired.assign(kSlotCount, 0);
+        heapAllocations_.store(0, std::memory_order_relaxed);
+        for (ThreadCounters* counters : registry.threads) {
+            for (auto& slot : counters->slots) {
+                slot.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Starts recording spans of the coarse phases, discarding any previous trace; spans beyond maxEvents are dropped.
+     */
+    static void startTrace(size_t maxEvents) {
+        Registry& registry = Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.traceEvents.clear();
+        registry.traceEvents.reserve(maxEvents);
+        registry.traceCapacity = maxEvents;
+        registry.droppedEvents = 0;
+        registry.traceOrigin = nowNanos();
+        registry.tracing.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * Stops the trace and writes it as a Chrome trace JSON object; timestamps are microseconds since startTrace.
+     */
+    static void stopTrace(JsonWriter& out) {
+        Registry& registry = Registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.tracing.store(false, std::memory_order_relaxed);
+        out.literal("{\"traceEvents\":[");
+        bool first = true;
+        for (const TraceEvent& event : registry.traceEvents) {
+            if (!first) out.append(',');
+            first = false;
+            out.literal("{\"name\":");
+            out.quoted(event.name);
+            out.literal(",\"cat\":");
+            out.quoted(phaseName(event.phase));
+            out.literal(",\"ph\":\"X\",\"pid\":1,\"tid\":");
+            out.number(event.threadId);
+            out.literal(",\"ts\":");
+            out.number(static_cast<double>(event.start - registry.traceOrigin) / 1000.0);
+            out.literal(",\"dur\":");
+            out.number(static_cast<double>(event.duration) / 1000.0);
+            out.append('}');
+        }
+        out.literal("],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":");
+        out.number(static_cast<double>(registry.droppedEvents));
+        out.literal("}}");
+        registry.traceEvents.clear();
+        registry.traceEvents.shrink_to_fit();
+    }
+
+    static bool isTraced(Phase phase) {
+        return phase == Phase::Call || phase == Phase::ResultString || phase == Phase::BatchChunk ||
+               phase == Phase::FdWrite;
+    }
+
+    static void traceSpan(Phase phase, const char* name, int64_t start, int64_t duration) {
+        Registry& registry = Registry::instance();
+        if (!registry.tracing.load(std::memory_order_relaxed)) {
+            return;
+        }
+        uint32_t threadId = threadCounters().threadId;
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (registry.traceEvents.size() < registry.traceCapacity) {
+            registry.traceEvents.push_back(TraceEvent{phase, name ? name : phaseName(phase), threadId, start, duration});
+        } else {
+            registry.droppedEvents++;
+        }
+    }
+
+private:
+    struct ThreadCounters;
+
+    inline static std::atomic<uint64_t> heapAllocations_{0};
+
+    struct TraceEvent {
+        Phase phase;
+        const char* name;
+        uint32_t threadId;
+        int64_t start;
+        int64_t duration;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadCounters*> threads;
+        std::vector<uint64_t> retired = std::vector<uint64_t>(kSlotCount); // Totals of exited threads
+        uint32_t nextThreadId = 1;
+
+        std::atomic<bool> tracing{false};
+        std::vector<TraceEvent> traceEvents;
+        size_t traceCapacity = 0;
+        int64_t droppedEvents = 0;
+        int64_t traceOrigin = 0;
+
+        // Never destroyed: detached threads may still count while static destructors run
+        static Registry& instance() {
+            static auto* registry = new Registry();
+            return *registry;
+        }
+    };
+
+    struct ThreadCounters {
+        std::atomic<uint64_t> slots[kSlotCount]{};
+        uint32_t threadId;
+        int64_t liveLocalRefs = 0; // Only ever touched by its own thread
+
+        ThreadCounters() {
+            Registry& registry = Registry::instance();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            threadId = registry.nextThreadId++;
+            registry.threads.push_back(this);
+        }
+
+        ~ThreadCounters() {
+            Registry& registry = Registry::instance();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            for (size_t i = 0; i < kSlotCount; i++) {
+                uint64_t value = slots[i].load(std::memory_order_relaxed);
+                registry.retired[i] = i == kLocalRefsPeakSlot ? std::max(registry.retired[i], value)
+                                                              : registry.retired[i] + value;
+            }
+            for (size_t i = 0; i < registry.threads.size(); i++) {
+                if (registry.threads[i] == this) {
+                    registry.threads[i] = registry.threads.back();
+                    registry.threads.pop_back();
+                    break;
+                }
+            }
+        }
+    };
+
+    static ThreadCounters& threadCounters() {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+
+    static void add(size_t slot, uint64_t value) {
+        threadCounters().slots[slot].fetch_add(value, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Times its own lifetime as one occurrence of phase; name labels the span in a trace (default: the phase name).
+ */
+class PhaseScope {
+public:
+    explicit PhaseScope(Phase phase, const char* name = nullptr)
+            : phase_(phase), name_(name), start_(nowNanos()),
+              liveLocalRefs_(phase == Phase::Call ? NativeStats::liveLocalRefs() : 0) {}
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+    ~PhaseScope() {
+        int64_t duration = nowNanos() - start_;
+        if (phase_ == Phase::Call) {
+            NativeStats::restoreLiveLocalRefs(liveLocalRefs_); // Returning to Java releases the call's references
+        }
+        NativeStats::recordPhase(phase_, duration);
+        if (NativeStats::isTraced(phase_)) {
+            NativeStats::traceSpan(phase_, name_, start_, duration);
+        }
+    }
+
+private:
+    Phase phase_;
+    const char* name_;
+    int64_t start_;
+    int64_t liveLocalRefs_;
+};
+
+} // namespace nativestats
+
+#ifdef RESTAURANT_INSTRUMENTATION
+#define NATIVE_STATS_JNI(kind, calls) ::nativestats::NativeStats::countJni(kind, calls)
+#define NATIVE_STATS_LOCAL_REF(ref) ::nativestats::NativeStats::countLocalRef((ref) != nullptr)
+#define NATIVE_STATS_LOCAL_REF_DELETED() ::nativestats::NativeStats::countLocalRefDeleted()
+#define NATIVE_STATS_LOCAL_FRAME_PUSHED(mark) ((mark) = ::nativestats::NativeStats::liveLocalRefs())
+#define NATIVE_STATS_LOCAL_FRAME_POPPED(mark) ::nativestats::NativeStats::restoreLiveLocalRefs(mark)
+#define NATIVE_STATS_GLOBAL_REF() ::nativestats::NativeStats::countGlobalRef()
+#define NATIVE_STATS_BYTES(bytes) ::nativestats::NativeStats::countBytes(bytes)
+#define NATIVE_STATS_PHASE(phase) ::nativestats::PhaseScope nativeStatsPhase_(::nativestats::Phase::phase)
+#define NATIVE_STATS_CALL(name) ::nativestats::PhaseScope nativeStatsCall_(::nativestats::Phase::Call, name)
+#else
+#define NATIVE_STATS_JNI(kind, calls) ((void)0)
+#define NATIVE_STATS_LOCAL_REF(ref) ((void)0)
+#define NATIVE_STATS_LOCAL_REF_DELETED() ((void)0)
+#define NATIVE_STATS_LOCAL_FRAME_PUSHED(mark) ((void)(mark))
+#define NATIVE_STATS_LOCAL_FRAME_POPPED(mark) ((void)(mark))
+#define NATIVE_STATS_GLOBAL_REF() ((void)0)
+#define NATIVE_STATS_BYTES(bytes) ((void)0)
+#define NATIVE_STATS_PHASE(phase) ((void)0)
+#define NATIVE_STATS_CALL(name) ((void)0)
+#endif
+
+#endif // ANDROID_SDK_NATIVESTATS_H
@@ -0,0 +1,249 @@
+#ifndef ANDROID_SDK_OPENINGHOURSINDEX_H
+#define ANDROID_SDK_OPENINGHOURSINDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hours {
+
+constexpr uint32_t kMinutesPerDay = 24 * 60;
+constexpr uint32_t kMinutesPerWeek = 7 * kMinutesPerDay;
+constexpr size_t kWordsPerWeek = (kMinutesPerWeek + 63) / 64;
+
+/**
+ * @return The minute of the week (MONDAY 00:00 = 0) of a DayOfWeek ordinal and minute of the day.
+ */
+constexpr uint32_t weekMinute(uint32_t dayOrdinal, uint32_t minuteOfDay) {
+    return dayOrdinal * kMinutesPerDay + minuteOfDay;
+}
+
+/**
+ * @class OpeningHoursIndex
+ * @brief Weekly opening hours of many restaurants, each compiled to a 7 x 1440 bit minute bitmap.
+ *
+ * Bit m of a restaurant's week is set when it is open during minute m of the week (MONDAY 00:00 = 0). The
+ * week is circular: an interval that closes at or before it opens runs past midnight into the next day, and
+ * Sunday's runs on into Monday. Each restaurant takes kWordsPerWeek consecutive words, 1.2 KB, so a query
+ * on one restaurant tests or scans whole words: "open now" is one bit test, "open for the next hour" a masked
+ * compare of two or three words, and "next opening" a find-first-set over at most a week of words.
+ *
+ * finish() then transposes the bitmaps into one row per minute of the week, a bitset over all restaurants,
+ * which doubles the memory. The batch queries scan rows: openAt reads one contiguous row, and openThroughout
+ * ANDs the rows of its window together, 64 restaurants per word.
+ *
+ * A finished index is immutable and may be queried from any number of threads at once.
+ */
+class OpeningHoursIndex {
+public:
+    static constexpr int32_t kNever = -1;
+
+    /**
+     * Starts the next restaurant, closed all week until addInterval opens it.
+     */
+    void addRestaurant() {
+        bits_.resize(bits_.size() + kWordsPerWeek, 0);
+        count_++;
+    }
+
+    /**
+     * Opens the last restaurant from openMinute to closeMinute of day (minutes of the day, close exclusive, up to
+     * kMinutesPerDay). closeMinute <= openMinute runs past midnight into the next day; equal minutes mean open
+     * around the clock.
+     */
+    void addInterval(uint32_t dayOrdinal, uint32_t openMinute, uint32_t closeMinute) {
+        uint64_t* week = &bits_[(count_ - 1) * kWordsPerWeek];
+        uint32_t begin = weekMinute(dayOrdinal, openMinute);
+        uint32_t length = closeMinute > openMinute ? closeMinute - openMinute
+                                                   : kMinutesPerDay - openMinute + closeMinute;
+        if (begin + length <= kMinutesPerWeek) {
+            setRange(week, begin, begin + length);
+        } else {
+            setRange(week, begin, kMinutesPerWeek);
+            setRange(week, 0, begin + length - kMinutesPerWeek);
+        }
+    }
+
+    size_t restaurantCount() const {
+        return count_;
+    }
+
+    bool isOpenAt(size_t restaurant, uint32_t minute) const {
+        minute %= kMinutesPerWeek;
+        return (week(restaurant)[minute / 64] >> (minute % 64)) & 1;
+    }
+
+    /**
+     * Whether the restaurant stays open for the whole of [minute, minute + duration), wrapping past Sunday.
+     * A duration of 0 asks the same as isOpenAt.
+     */
+    bool isOpenThroughout(size_t restaurant, uint32_t minute, uint32_t duration) const {
+        duration = std::max<uint32_t>(duration, 1);
+        if (duration >= kMinutesPerWeek) {
+            return allSet(week(restaurant), 0, kMinutesPerWeek);
+        }
+        minute %= kMinutesPerWeek;
+        const uint64_t* bits = week(restaurant);
+        if (minute + duration <= kMinutesPerWeek) {
+            return allSet(bits, minute, minute + duration);
+        }
+        return allSet(bits, minute, kMinutesPerWeek) && allSet(bits, 0, minute + duration - kMinutesPerWeek);
+    }
+
+    /**
+     * @return Minutes from minute until the restaurant next opens: 0 when it is open at minute, kNever when
+     *         it never opens.
+     */
+    int32_t minutesUntilOpen(size_t restaurant, uint32_t minute) const {
+        minute %= kMinutesPerWeek;
+        const uint64_t* bits = week(restaurant);
+        uint32_t found = findSet(bits, minute, kMinutesPerWeek);
+        if (found != kMinutesPerWeek) {
+            return static_cast<int32_t>(found - minute);
+        }
+        found = findSet(bits, 0, minute);
+        return found != minute ? static_cast<int32_t>(kMinutesPerWeek - minute + found) : kNever;
+    }
+
+    /**
+     * Builds the per-minute rows of openAt and openThroughout from the restaurant bitmaps, 64 x 64 bits at a
+     * time. Call it once every restaurant has been added.
+     */
+    void finish() {
+        rowWords_ = (count_ + 63) / 64;
+        byMinute_.assign(kMinutesPerWeek * rowWords_, 0);
+        uint64_t block[64];
+        for (size_t column = 0; column < rowWords_; column++) {
+            size_t first = column * 64;
+            size_t restaurants = std::min<size_t>(64, count_ - first);
+            for (size_t word = 0; word < kWordsPerWeek; word++) {
+                for (size_t j = 0; j < 64; j++) {
+                    block[j] = j < restaurants ? bits_[(first + j) * kWordsPerWeek + word] : 0;
+                }
+                transpose(block);
+                size_t minutes = std::min<size_t>(64, kMinutesPerWeek - word * 64);
+                for (size_t k = 0; k < minutes; k++) {
+                    byMinute_[(word * 64 + k) * rowWords_ + column] = block[k];
+                }
+            }
+        }
+    }
+
+    /**
+     * @return The restaurants open at minute, ascending.
+     */
+    std::vector<uint32_t> openAt(uint32_t minute) const {
+        std::vector<uint32_t> open;
+        appendSetBits(row(minute % kMinutesPerWeek), open);
+        return open;
+    }
+
+    /**
+     * @return The restaurants open for the whole of [minute, minute + duration), ascending.
+     */
+    std::vector<uint32_t> openThroughout(uint32_t minute, uint32_t duration) const {
+        duration = std::clamp<uint32_t>(duration, 1, kMinutesPerWeek);
+        minute %= kMinutesPerWeek;
+        std::vector<uint64_t> open(row(minute), row(minute) + rowWords_);
+        for (uint32_t offset = 1; offset < duration; offset++) {
+            const uint64_t* next = row((minute + offset) % kMinutesPerWeek);
+            for (size_t word = 0; word < rowWords_; word++) {
+                open[word] &= next[word];
+            }
+        }
+        std::vector<uint32_t> restaurants;
+        appendSetBits(open.data(), restaurants);
+        return restaurants;
+    }
+
+    /**
+     * minutesUntilOpen for every restaurant, in restaurant order.
+     */
+    std::vector<int32_t> minutesUntilOpen(uint32_t minute) const {
+        std::vector<int32_t> minutes(count_);
+        for (size_t restaurant = 0; restaurant < count_; restaurant++) {
+            minutes[restaurant] = minutesUntilOpen(restaurant, minute);
+        }
+        return minutes;
+    }
+
+    size_t memoryBytes() const {
+        return (bits_.capacity() + byMinute_.capacity()) * sizeof(uint64_t);
+    }
+
+private:
+    std::vector<uint64_t> bits_; // kWordsPerWeek words per restaurant; bits past kMinutesPerWeek stay clear
+    size_t count_ = 0;
+    std::vector<uint64_t> byMinute_; // rowWords_ words per minute of the week, bit r for restaurant r
+    size_t rowWords_ = 0;
+
+    const uint64_t* week(size_t restaurant) const {
+        return &bits_[restaurant * kWordsPerWeek];
+    }
+
+    const uint64_t* row(uint32_t minute) const {
+        return byMinute_.data() + minute * rowWords_;
+    }
+
+    void appendSetBits(const uint64_t* bits, std::vector<uint32_t>& out) const {
+        for (size_t word = 0; word < rowWords_; word++) {
+            for (uint64_t set = bits[word]; set; set &= set - 1) {
+                out.push_back(static_cast<uint32_t>(word * 64 + __builtin_ctzll(set)));
+            }
+        }
+    }
+
+    // Transposes a 64 x 64 bit matrix in place: bit j of word k swaps with bit k of word j
+    static void transpose(uint64_t* a) {
+        uint64_t mask = 0x00000000FFFFFFFFull;
+        for (unsigned width = 32; width != 0; width >>= 1, mask ^= mask << width) {
+            for (unsigned k = 0; k < 64; k = ((k | width) + 1) & ~width) {
+                uint64_t swap = ((a[k] >> width) ^ a[k | width]) & mask;
+                a[k | width] ^= swap;
+                a[k] ^= swap << width;
+            }
+        }
+    }
+
+    // Mask of bits [from, to) of one word, 0 <= from < to <= 64
+    static uint64_t wordMask(unsigned from, unsigned to) {
+        uint64_t upTo = to == 64 ? ~uint64_t(0) : (uint64_t(1) << to) - 1;
+        return upTo & (~uint64_t(0) << from);
+    }
+
+    static void setRange(uint64_t* bits, uint32_t begin, uint32_t end) {
+        for (uint32_t word = begin / 64; begin < end; word++) {
+            unsigned to = static_cast<unsigned>(std::min<uint32_t>(end - word * 64, 64));
+            bits[word] |= wordMask(begin % 64, to);
+            begin = (word + 1) * 64;
+        }
+    }
+
+    static bool allSet(const uint64_t* bits, uint32_t begin, uint32_t end) {
+        for (uint32_t word = begin / 64; begin < end; word++) {
+            unsigned to = static_cast<unsigned>(std::min<uint32_t>(end - word * 64, 64));
+            uint64_t mask = wordMask(begin % 64, to);
+            if ((bits[word] & mask) != mask) return false;
+            begin = (word + 1) * 64;
+        }
+        return true;
+    }
+
+    // First set bit in [begin, end), or end
+    static uint32_t findSet(const uint64_t* bits, uint32_t begin, uint32_t end) {
+        for (uint32_t word = begin / 64; begin < end; word++) {
+            unsigned to = static_cast<unsigned>(std::min<uint32_t>(end - word * 64, 64));
+            uint64_t set = bits[word] & wordMask(begin % 64, to);
+            if (set) {
+                return word * 64 + static_cast<uint32_t>(__builtin_ctzll(set));
+            }
+            begin = (word + 1) * 64;
+        }
+        return end;
+    }
+};
+
+} // namespace hours
+
+#endif // ANDROID_SDK_OPENINGHOURSINDEX_H
@@ -0,0 +1,150 @@
+#ifndef ANDROID_SDK_OUTPUTBUFFER_H
+#define ANDROID_SDK_OUTPUTBUFFER_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+/**
+ * @class OutputBuffer
+ * @brief Append-only byte buffer shared by every output format (see JsonWriter, CborEncoder, MsgPackEncoder).
+ *
+ * The buffer grows geometrically. It can start on caller-owned storage (e.g. a direct ByteBuffer); if the
+ * output outgrows that storage it moves to its own heap buffer and keeps going, so the full size is always known.
+ * A buffer built with kThreadScratch reuses the storage of the thread's previous such buffer instead of allocating.
+ */
+class OutputBuffer {
+public:
+    static constexpr size_t kDefaultCapacity = 4096;
+    static constexpr size_t kMaxRecycledCapacity = 4 * 1024 * 1024;
+
+    struct ThreadScratch {};
+    static constexpr ThreadScratch kThreadScratch{};
+
+    explicit OutputBuffer(size_t initialCapacity = kDefaultCapacity)
+            : owned_(new char[initialCapacity + 1]), data_(owned_.get()), size_(0), capacity_(initialCapacity) {}
+
+    /**
+     * Writes into external storage until it is full, then continues on the heap.
+     * @param external Caller-owned storage; never written past capacity.
+     */
+    OutputBuffer(char* external, size_t capacity)
+            : data_(external), size_(0), capacity_(capacity) {}
+
+    /**
+     * Starts on the storage the calling thread's last kThreadScratch buffer left behind, and leaves its own
+     * (possibly grown) storage behind when destroyed, so a thread's calls stop allocating once the storage fits
+     * their output. Storage beyond kMaxRecycledCapacity is freed rather than kept.
+     */
+    explicit OutputBuffer(ThreadScratch) : data_(nullptr), size_(0), capacity_(0), recycles_(true) {
+        Spare& spare = threadSpare();
+        if (spare.storage) {
+            owned_ = std::move(spare.storage);
+            capacity_ = spare.capacity;
+            spare.capacity = 0;
+        } else {
+            owned_.reset(new char[kDefaultCapacity + 1]);
+            capacity_ = kDefaultCapacity;
+        }
+        data_ = owned_.get();
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    ~OutputBuffer() {
+        if (recycles_ && owned_ && capacity_ <= kMaxRecycledCapacity) {
+            Spare& spare = threadSpare();
+            if (capacity_ > spare.capacity) {
+                spare.storage = std::move(owned_);
+                spare.capacity = capacity_;
+            }
+        }
+    }
+
+    void append(const char* bytes, size_t length) {
+        ensure(length);
+        std::memcpy(data_ + size_, bytes, length);
+        size_ += length;
+    }
+
+    void append(char c) {
+        ensure(1);
+        data_[size_++] = c;
+    }
+
+    /**
+     * @return Room for at least extra bytes at the end of the output; finish with advance().
+     */
+    char* reserve(size_t extra) {
+        ensure(extra);
+        return data_ + size_;
+    }
+
+    /**
+     * Commits length bytes written into the space returned by reserve().
+     */
+    void advance(size_t length) {
+        size_ += length;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @return A NUL-terminated view of the output, e.g. for NewStringUTF.
+     */
+    const char* c_str() {
+        if (!owned_) {
+            ensure(1); // Owned buffers always have the spare byte
+        }
+        data_[size_] = '\0';
+        return data_;
+    }
+
+    /**
+     * @return true while all output still lives in the storage passed to the constructor.
+     */
+    bool usesExternalStorage() const { return !owned_; }
+
+    void clear() { size_ = 0; }
+
+protected:
+    std::unique_ptr<char[]> owned_;
+    char* data_;
+    size_t size_;
+    size_t capacity_;
+
+    void ensure(size_t extra) {
+        if (size_ + extra > capacity_) {
+            grow(size_ + extra);
+        }
+    }
+
+private:
+    // Storage kept between kThreadScratch buffers; capacity excludes the spare terminator byte
+    struct Spare {
+        std::unique_ptr<char[]> storage;
+        size_t capacity = 0;
+    };
+
+    bool recycles_ = false;
+
+    static Spare& threadSpare() {
+        thread_local Spare spare;
+        return spare;
+    }
+
+    void grow(size_t needed) {
+        size_t newCapacity = capacity_ * 2 > needed ? capacity_ * 2 : needed;
+        // One spare byte past capacity for c_str()'s terminator
+        std::unique_ptr<char[]> bigger(new char[newCapacity + 1]);
+        std::memcpy(bigger.get(), data_, size_);
+        owned_ = std::move(bigger);
+        data_ = owned_.get();
+        capacity_ = newCapacity;
+    }
+};
+
+#endif // ANDROID_SDK_OUTPUTBUFFER_H
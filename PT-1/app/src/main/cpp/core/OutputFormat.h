@@ -0,0 +1,19 @@
+#ifndef ANDROID_SDK_OUTPUTFORMAT_H
+#define ANDROID_SDK_OUTPUTFORMAT_H
+
+#include <jni.h>
+
+/**
+ * Output formats of the serializer; the values are SerializationFormat.ordinal on the Kotlin side.
+ */
+enum class OutputFormat : jint {
+    Json = 0,
+    Cbor = 1,
+    MessagePack = 2
+};
+
+inline bool isValidOutputFormat(jint format) {
+    return format >= static_cast<jint>(OutputFormat::Json) && format <= static_cast<jint>(OutputFormat::MessagePack);
+}
+
+#endif // ANDROID_SDK_OUTPUTFORMAT_H
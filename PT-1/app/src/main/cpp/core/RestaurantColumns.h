@@ -0,0 +1,320 @@
+#ifndef ANDROID_SDK_RESTAURANTCOLUMNS_H
+#define ANDROID_SDK_RESTAURANTCOLUMNS_H
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ColumnKernels.h"
+
+namespace columns {
+
+/**
+ * @class StringCodes
+ * @brief Dictionary encoding of a string column: each distinct string gets the next dense code.
+ */
+class StringCodes {
+public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    /**
+     * @return The code of text, adding it when new.
+     */
+    uint32_t encode(std::string_view text) {
+        auto found = codes_.find(text);
+        if (found != codes_.end()) {
+            return found->second;
+        }
+        texts_.emplace_back(text);
+        auto code = static_cast<uint32_t>(texts_.size() - 1);
+        codes_.emplace(texts_.back(), code);
+        return code;
+    }
+
+    /**
+     * @return The code of text, or kNone when no row holds it.
+     */
+    uint32_t find(std::string_view text) const {
+        auto found = codes_.find(text);
+        return found != codes_.end() ? found->second : kNone;
+    }
+
+    const std::string& text(uint32_t code) const {
+        return texts_[code];
+    }
+
+    size_t size() const {
+        return texts_.size();
+    }
+
+private:
+    std::deque<std::string> texts_; // Owns the keys of codes_; a deque never moves its elements
+    std::unordered_map<std::string_view, uint32_t> codes_;
+};
+
+/**
+ * Menu item predicate: price in [minPrice, priceBelow) and, when set, exactly this category.
+ * The default bounds select every price, NaN included.
+ */
+struct MenuItemFilter {
+    double minPrice = -std::numeric_limits<double>::infinity();
+    double priceBelow = std::numeric_limits<double>::infinity();
+    std::optional<std::string_view> category;
+};
+
+/**
+ * Restaurant predicate: rating in [minRating, ratingBelow), serving cuisine when set, and with at least one
+ * menu item matching menuItem when set. The default bounds select every rating, NaN included.
+ */
+struct RestaurantFilter {
+    double minRating = -std::numeric_limits<double>::infinity();
+    double ratingBelow = std::numeric_limits<double>::infinity();
+    std::optional<std::string_view> cuisine;
+    std::optional<MenuItemFilter> menuItem;
+};
+
+struct PriceSummary {
+    size_t count = 0;
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    std::vector<uint64_t> histogram; // Equal-width buckets over [min, max]
+};
+
+/**
+ * @class RestaurantColumns
+ * @brief Read-only, structure-of-arrays copy of a restaurant list for filter and aggregate queries.
+ *
+ * Restaurants are rows 0..restaurantCount() in list order (a null element is a row that never matches), and the
+ * menu items of all restaurants are rows 0..menuItemCount() of the menu columns, restaurant by restaurant:
+ *
+ *   ratings_        double per restaurant
+ *   cuisineMasks_   per restaurant, bit (code % 64) of each cuisine; exact while there are at most 64 cuisines
+ *   cuisineOffsets_ cuisineCodes_[cuisineOffsets_[r], cuisineOffsets_[r + 1]) are the cuisines of restaurant r
+ *   menuOffsets_    menu rows [menuOffsets_[r], menuOffsets_[r + 1]) belong to restaurant r
+ *   prices_         double per menu item
+ *   categories_     category code per menu item, StringCodes::kNone for null
+ *
+ * Queries run the kernels of ColumnKernels.h over whole columns. A built store is immutable, so any number
+ * of threads may query it at once.
+ */
+class RestaurantColumns {
+public:
+    RestaurantColumns() : cuisineOffsets_{0}, menuOffsets_{0} {}
+
+    RestaurantColumns(const RestaurantColumns&) = delete;
+    RestaurantColumns& operator=(const RestaurantColumns&) = delete;
+
+    /**
+     * Starts the next restaurant row; addCuisine and addMenuItem then fill it.
+     */
+    void addRestaurant(double rating) {
+        ratings_.push_back(rating);
+        cuisineMasks_.push_back(0);
+        cuisineOffsets_.push_back(cuisineOffsets_.back());
+        menuOffsets_.push_back(menuOffsets_.back());
+        present_.resize(bitmapWords(ratings_.size()));
+        present_[(ratings_.size() - 1) / 64] |= uint64_t(1) << ((ratings_.size() - 1) % 64);
+    }
+
+    /**
+     * Adds a row for a null list element.
+     */
+    void addMissingRestaurant() {
+        addRestaurant(std::numeric_limits<double>::quiet_NaN());
+        present_[(ratings_.size() - 1) / 64] &= ~(uint64_t(1) << ((ratings_.size() - 1) % 64));
+    }
+
+    void addCuisine(std::string_view cuisine) {
+        uint32_t code = cuisines_.encode(cuisine);
+        cuisineCodes_.push_back(code);
+        cuisineOffsets_.back()++;
+        cuisineMasks_.back() |= uint64_t(1) << (code % 64);
+    }
+
+    void addMenuItem(double price, std::optional<std::string_view> category) {
+        prices_.push_back(price);
+        categories_.push_back(category ? categoryCodes_.encode(*category) : StringCodes::kNone);
+        menuOffsets_.back()++;
+    }
+
+    size_t restaurantCount() const {
+        return ratings_.size();
+    }
+
+    size_t menuItemCount() const {
+        return prices_.size();
+    }
+
+    /**
+     * @return The first menu row of restaurant (menuItemCount() for restaurantCount()).
+     */
+    uint32_t menuOffset(size_t restaurant) const {
+        return menuOffsets_[restaurant];
+    }
+
+    /**
+     * Bytes held by the columns and dictionaries, roughly.
+     */
+    size_t memoryBytes() const {
+        size_t bytes = ratings_.capacity() * sizeof(double) + cuisineMasks_.capacity() * sizeof(uint64_t) +
+                       (cuisineOffsets_.capacity() + cuisineCodes_.capacity() + menuOffsets_.capacity() +
+                        categories_.capacity()) * sizeof(uint32_t) +
+                       prices_.capacity() * sizeof(double) + present_.capacity() * sizeof(uint64_t);
+        for (size_t code = 0; code < cuisines_.size(); code++) bytes += cuisines_.text(code).size();
+        for (size_t code = 0; code < categoryCodes_.size(); code++) bytes += categoryCodes_.text(code).size();
+        return bytes;
+    }
+
+    /**
+     * @return The selection bitmap of the menu rows matching filter.
+     */
+    std::vector<uint64_t> selectMenuItems(const MenuItemFilter& filter) const {
+        size_t rows = prices_.size();
+        std::vector<uint64_t> selected(bitmapWords(rows));
+        if (isUnbounded(filter.minPrice, filter.priceBelow)) {
+            selectAll(rows, selected.data());
+        } else {
+            selectRange(prices_.data(), rows, filter.minPrice, filter.priceBelow, selected.data());
+        }
+        if (filter.category) {
+            uint32_t code = categoryCodes_.find(*filter.category);
+            if (code == StringCodes::kNone) {
+                return std::vector<uint64_t>(selected.size()); // No row has this category
+            }
+            std::vector<uint64_t> equal(selected.size());
+            selectEqual(categories_.data(), rows, code, equal.data());
+            andBitmaps(selected.data(), equal.data(), selected.size());
+        }
+        return selected;
+    }
+
+    /**
+     * @return The selection bitmap of the restaurant rows matching filter.
+     */
+    std::vector<uint64_t> selectRestaurants(const RestaurantFilter& filter) const {
+        size_t rows = ratings_.size();
+        std::vector<uint64_t> selected = present_;
+        if (!isUnbounded(filter.minRating, filter.ratingBelow)) {
+            std::vector<uint64_t> inRange(selected.size());
+            selectRange(ratings_.data(), rows, filter.minRating, filter.ratingBelow, inRange.data());
+            andBitmaps(selected.data(), inRange.data(), selected.size());
+        }
+        if (filter.cuisine) {
+            uint32_t code = cuisines_.find(*filter.cuisine);
+            if (code == StringCodes::kNone) {
+                return std::vector<uint64_t>(selected.size());
+            }
+            std::vector<uint64_t> serving(selected.size());
+            selectAnyBit(cuisineMasks_.data(), rows, uint64_t(1) << (code % 64), serving.data());
+            andBitmaps(selected.data(), serving.data(), selected.size());
+            if (cuisines_.size() > 64) {
+                // The mask bit is shared by every 64th cuisine: confirm the candidates against their codes
+                forEachSelected(serving.data(), serving.size(), [&](size_t row) {
+                    if (!servesCuisine(row, code)) {
+                        selected[row / 64] &= ~(uint64_t(1) << (row % 64));
+                    }
+                });
+            }
+        }
+        if (filter.menuItem) {
+            std::vector<uint64_t> items = selectMenuItems(*filter.menuItem);
+            forEachSelected(selected.data(), selected.size(), [&](size_t row) {
+                if (!anyInRange(items.data(), menuOffsets_[row], menuOffsets_[row + 1])) {
+                    selected[row / 64] &= ~(uint64_t(1) << (row % 64));
+                }
+            });
+        }
+        return selected;
+    }
+
+    /**
+     * @return The indices of the matching restaurants, ascending.
+     */
+    std::vector<uint32_t> filterRestaurants(const RestaurantFilter& filter) const {
+        std::vector<uint64_t> selected = selectRestaurants(filter);
+        std::vector<uint32_t> rows;
+        rows.reserve(countSelected(selected.data(), selected.size()));
+        forEachSelected(selected.data(), selected.size(), [&](size_t row) {
+            rows.push_back(static_cast<uint32_t>(row));
+        });
+        return rows;
+    }
+
+    /**
+     * @return (restaurant index, index in its menu) of every matching menu item, flattened into pairs, ascending.
+     */
+    std::vector<uint32_t> filterMenuItems(const MenuItemFilter& filter) const {
+        std::vector<uint64_t> selected = selectMenuItems(filter);
+        std::vector<uint32_t> pairs;
+        pairs.reserve(2 * countSelected(selected.data(), selected.size()));
+        size_t restaurant = 0;
+        forEachSelected(selected.data(), selected.size(), [&](size_t row) {
+            while (menuOffsets_[restaurant + 1] <= row) {
+                restaurant++; // Rows ascend, so the owning restaurant only moves forward
+            }
+            pairs.push_back(static_cast<uint32_t>(restaurant));
+            pairs.push_back(static_cast<uint32_t>(row - menuOffsets_[restaurant]));
+        });
+        return pairs;
+    }
+
+    /**
+     * Count, min, max, mean and a histogram of bucketCount buckets of the prices of the menu items matching filter.
+     * NaN and infinite prices are left out, whatever the filter.
+     */
+    PriceSummary summarizePrices(const MenuItemFilter& filter, size_t bucketCount) const {
+        std::vector<uint64_t> selected = selectMenuItems(filter);
+        std::vector<uint64_t> finite(selected.size());
+        selectRange(prices_.data(), prices_.size(), std::numeric_limits<double>::lowest(),
+                    std::numeric_limits<double>::infinity(), finite.data());
+        andBitmaps(selected.data(), finite.data(), selected.size());
+        Summary summary = summarizeSelected(prices_.data(), selected.data(), prices_.size());
+        PriceSummary result;
+        result.histogram.assign(bucketCount, 0);
+        if (summary.count == 0) {
+            return result;
+        }
+        result.count = summary.count;
+        result.min = summary.min;
+        result.max = summary.max;
+        result.mean = summary.sum / static_cast<double>(summary.count);
+        if (bucketCount > 0) {
+            histogramSelected(prices_.data(), selected.data(), prices_.size(), summary.min, summary.max,
+                              result.histogram.data(), bucketCount);
+        }
+        return result;
+    }
+
+private:
+    std::vector<double> ratings_;
+    std::vector<uint64_t> cuisineMasks_;
+    std::vector<uint32_t> cuisineOffsets_;
+    std::vector<uint32_t> cuisineCodes_;
+    std::vector<uint32_t> menuOffsets_;
+    std::vector<double> prices_;
+    std::vector<uint32_t> categories_;
+    std::vector<uint64_t> present_; // Bitmap of the rows that are not null elements
+    StringCodes cuisines_;
+    StringCodes categoryCodes_;
+
+    static bool isUnbounded(double from, double until) {
+        return std::isinf(from) && from < 0 && std::isinf(until) && until > 0;
+    }
+
+    bool servesCuisine(size_t restaurant, uint32_t code) const {
+        for (uint32_t i = cuisineOffsets_[restaurant]; i < cuisineOffsets_[restaurant + 1]; i++) {
+            if (cuisineCodes_[i] == code) return true;
+        }
+        return false;
+    }
+};
+
+} // namespace columns
+
+#endif // ANDROID_SDK_RESTAURANTCOLUMNS_H
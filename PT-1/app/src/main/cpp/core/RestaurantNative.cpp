@@ -1,129 +1,674 @@
 #include "../jni/shadowClasses/RestaurantShadow.h"
-#include "../jni/shadowClasses/AddressShadow.h"
-#include "../jni/jniString.h"
-#include "../jni/shadowClasses/OpeningHourShadow.h"
-#include "../jni/shadowClasses/MenuItemShadow.h"
+#include "../jni/JavaCollections.h"
+#include "../jni/JavaStrings.h"
+#include "../jni/LocalFrame.h"
+#include "BinaryEncoders.h"
+#include "EventTape.h"
+#include "FdWriter.h"
+#include "Fingerprint.h"
+#include "JsonEncoder.h"
+#include "JsonReader.h"
+#include "JsonWriter.h"
+#include "ModelDecoding.h"
+#include "ModelDiff.h"
+#include "ModelProjection.h"
+#include "ModelTraversal.h"
+#include "NativeStats.h"
+#include "OpeningHoursIndex.h"
+#include "OutputFormat.h"
+#include "RestaurantColumns.h"
+#include "SerializationCache.h"
+#include "StringDictionary.h"
+#include "TrigramIndex.h"
+#include "WorkStealingPool.h"
 
 #include <jni.h>
+#include <array>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
-#include <sstream>
-
-/**
- * Utility to get size of a java.util.List
- */
-static int getListSize(JNIEnv* env, jobject listObj) {
-    if (!listObj) return 0;
-    jclass listClass = env->FindClass("java/util/List");
-    jmethodID sizeMethod = env->GetMethodID(listClass, "size", "()I");
-    return env->CallIntMethod(listObj, sizeMethod);
-}
-
-/**
- * Utility to retrieve an element from a java.util.List by index
- */
-static jobject getListElement(JNIEnv* env, jobject listObj, int index) {
-    jclass listClass = env->FindClass("java/util/List");
-    jmethodID getMethod = env->GetMethodID(listClass, "get", "(I)Ljava/lang/Object;");
-    return env->CallObjectMethod(listObj, getMethod, index);
-}
-
-/**
- * Build a simple JSON from the RestaurantShadow's fields.
- * In real projects, you'd likely use a JSON library (cJSON, nlohmann/json, RapidJSON, etc.).
- */
-std::string buildJsonFromRestaurant(JNIEnv* env, RestaurantShadow& restShadow) {
-    // Basic fields
-    std::string id = restShadow.getId(env);
-    std::string name = restShadow.getName(env);
-    double rating = restShadow.getRating(env);
-    std::string phone = restShadow.getPhoneNumber(env);
-    std::string website = restShadow.getWebsite(env);
-
-    // Address
-    jobject addressObj = restShadow.getAddress(env);
-    AddressShadow addrShadow(env, addressObj);
-
-    // Cuisines
-    jobject cuisinesList = restShadow.getCuisines(env);
-    int cuisinesCount = getListSize(env, cuisinesList);
-
-    // OpeningHours
-    jobject openHoursList = restShadow.getOpeningHours(env);
-    int openHoursCount = getListSize(env, openHoursList);
-
-    // Menu
-    jobject menuList = restShadow.getMenu(env);
-    int menuCount = getListSize(env, menuList);
-
-    // Manual JSON building
-    std::ostringstream oss;
-    oss << "{";
-    oss << R"("id":")" << id << "\",";
-    oss << R"("name":")" << name << "\",";
-    oss << "\"rating\":" << rating << ",";
-    oss << R"("phoneNumber":")" << phone << "\",";
-    oss << R"("website":")" << website << "\",";
-
-    // Address
-    oss << "\"address\":{";
-    oss << R"("street":")" << addrShadow.getStreet(env) << "\",";
-    oss << R"("city":")" << addrShadow.getCity(env) << "\",";
-    oss << R"("state":")" << addrShadow.getState(env) << "\",";
-    oss << R"("zipCode":")" << addrShadow.getZipCode(env) << "\",";
-    oss << R"("country":")" << addrShadow.getCountry(env) << "\"";
-    oss << "},";
-
-    // Cuisines array
-    oss << "\"cuisines\":[";
-    for (int i = 0; i < cuisinesCount; i++) {
-        jobject elem = getListElement(env, cuisinesList, i);
-        auto jStr = (jstring)elem; // Because it's List<String>
-        if (!jStr) continue;
-        JNIString cStr(env, jStr);
-        oss << "\"" << cStr.c_str() << "\"";
-        if (i < cuisinesCount - 1) {
-            oss << ",";
+#include <vector>
+
+/**
+ * Write a JSON object from the RestaurantShadow's fields into writer.
+ * The field list and order come from RestaurantModel (see ModelTraversal.h).
+ */
+void writeJsonFromRestaurant(JNIEnv* env, RestaurantShadow& restShadow, JsonWriter& writer) {
+    NATIVE_STATS_PHASE(Encode);
+    JsonEncoder encoder(writer);
+    modelwalk::encodeModel(env, restShadow, encoder);
+}
+
+/**
+ * Snapshot the restaurant on the calling thread, for encoding elsewhere without JNI (see EventTape).
+ */
+void captureRestaurant(JNIEnv* env, RestaurantShadow& restShadow, EventTape& tape) {
+    NATIVE_STATS_PHASE(Encode);
+    modelwalk::encodeModel(env, restShadow, tape);
+}
+
+/**
+ * Write the JSON of a restaurant captured by captureRestaurant; safe on any thread.
+ */
+void writeJsonFromCapture(const EventTape& tape, JsonWriter& writer) {
+    NATIVE_STATS_PHASE(Encode);
+    JsonEncoder encoder(writer);
+    tape.replay(0, tape.size(), encoder);
+}
+
+static std::string restaurantCacheKey(OutputFormat format, std::string_view id) {
+    return "R" + std::to_string(static_cast<jint>(format)) + ":" + std::string(id);
+}
+
+static std::string fragmentCacheKey(OutputFormat format, size_t field, uint64_t fingerprint) {
+    char key[48];
+    std::snprintf(key, sizeof(key), "F%d:%zu:%016llx", static_cast<int>(format), field,
+                  static_cast<unsigned long long>(fingerprint));
+    return key;
+}
+
+/**
+ * Encodes through the SerializationCache.
+ *
+ * One traversal records the restaurant onto a per-thread EventTape, so every Java value is read once, and each
+ * field's fingerprint is the XXH64 of its recorded bytes. If the restaurant's entry still matches, its bytes are
+ * appended to out straight from the cache. Otherwise the tape is replayed into the encoder field by field, and list
+ * fields (menu, openingHours) whose fingerprint is cached are spliced in from their fragment instead, so an
+ * unchanged menu is not re-encoded even when another field of the restaurant changed.
+ */
+template <typename Encoder>
+static void encodeRestaurantCached(JNIEnv* env, RestaurantShadow& restShadow, OutputFormat format,
+                                   Encoder& encoder, OutputBuffer& out) {
+    // Kept between calls so a miss does not allocate; a huge menu's tape is freed rather than kept
+    static constexpr size_t kKeptTapeBytes = 1 << 20;
+    thread_local EventTape tape;
+    tape.clear();
+    std::array<size_t, RestaurantShadow::kFieldCount + 1> fieldStarts{};
+    std::array<uint64_t, RestaurantShadow::kFieldCount> fieldFingerprints{};
+    RestaurantShadow::forEachField([&](auto i) {
+        constexpr size_t I = decltype(i)::value;
+        size_t fieldStart = tape.size();
+        fieldStarts[I] = fieldStart;
+        modelwalk::encodeModelField<RestaurantModel, I>(env, restShadow, tape);
+        fingerprint::XxHash64 fieldHash;
+        fieldHash.update(tape.bytes(fieldStart), tape.size() - fieldStart);
+        fieldFingerprints[I] = fieldHash.digest();
+    });
+    fieldStarts[RestaurantShadow::kFieldCount] = tape.size();
+    fingerprint::XxHash64 restaurantHash;
+    restaurantHash.update(fieldFingerprints.data(), sizeof(fieldFingerprints));
+    uint64_t restaurantFingerprint = restaurantHash.digest();
+
+    std::string key = restaurantCacheKey(format, restShadow.getId(env));
+    auto appendCached = [&out](const char* bytes, size_t length) { out.append(bytes, length); };
+    if (!SerializationCache::lookup(key, restaurantFingerprint, appendCached)) {
+        size_t start = out.size();
+        encoder.beginObject(RestaurantShadow::kFieldCount);
+        RestaurantShadow::forEachField([&](auto i) {
+            constexpr size_t I = decltype(i)::value;
+            encoder.key(RestaurantShadow::fieldName<I>());
+            if constexpr (RestaurantShadow::FieldAt<I>::kind == FieldKind::ObjectList) {
+                std::string fragmentKey = fragmentCacheKey(format, I, fieldFingerprints[I]);
+                auto spliceCached = [&encoder](const char* bytes, size_t length) { encoder.rawValue(bytes, length); };
+                if (SerializationCache::lookup(fragmentKey, fieldFingerprints[I], spliceCached, true)) {
+                    return;
+                }
+                size_t fragmentStart = out.size();
+                tape.replay(fieldStarts[I], fieldStarts[I + 1], encoder);
+                SerializationCache::store(fragmentKey, fieldFingerprints[I],
+                                          out.data() + fragmentStart, out.size() - fragmentStart);
+            } else {
+                tape.replay(fieldStarts[I], fieldStarts[I + 1], encoder);
+            }
+        });
+        encoder.endObject();
+        SerializationCache::store(key, restaurantFingerprint, out.data() + start, out.size() - start);
+    }
+    if (tape.size() > kKeptTapeBytes) {
+        tape = EventTape();
+    }
+}
+
+/**
+ * The StringDictionary of one native call; releases the string references it kept for identity checks.
+ */
+class CallStringDictionary {
+public:
+    explicit CallStringDictionary(JNIEnv* env) : env_(env) {}
+
+    CallStringDictionary(const CallStringDictionary&) = delete;
+    CallStringDictionary& operator=(const CallStringDictionary&) = delete;
+
+    ~CallStringDictionary() {
+        strings_.releaseObjects([this](const void* object) {
+            env_->DeleteGlobalRef(static_cast<jobject>(const_cast<void*>(object)));
+        });
+    }
+
+    StringDictionary* get() {
+        return &strings_;
+    }
+
+private:
+    JNIEnv* env_;
+    StringDictionary strings_;
+};
+
+/**
+ * Opens a StringDictionary for the call when deduplication is on, and the CBOR stringref namespace with it.
+ * The SerializationCache splices in bytes encoded by earlier calls, which a dictionary never saw, so the two
+ * do not mix: the cache wins.
+ * @return The dictionary, or null.
+ */
+static StringDictionary* beginStringDictionary(JNIEnv* env, OutputFormat format, JsonWriter& out,
+                                               std::optional<CallStringDictionary>& strings) {
+    if (!StringDictionary::enabled || SerializationCache::enabled()) {
+        return nullptr;
+    }
+    strings.emplace(env);
+    if (format == OutputFormat::Cbor) {
+        binary::CborEncoder::writeStringRefNamespace(out);
+    }
+    return strings->get();
+}
+
+template <typename Encoder>
+static void encodeRestaurantWith(JNIEnv* env, RestaurantShadow& restShadow, OutputFormat format, JsonWriter& out,
+                                 StringDictionary* strings) {
+    NATIVE_STATS_PHASE(Encode);
+    Encoder encoder(out, strings);
+    if (!strings && SerializationCache::enabled()) {
+        encodeRestaurantCached(env, restShadow, format, encoder, out);
+    } else {
+        modelwalk::encodeModel(env, restShadow, encoder);
+    }
+}
+
+static void encodeRestaurantAs(JNIEnv* env, RestaurantShadow& restShadow, OutputFormat format, JsonWriter& out,
+                               StringDictionary* strings) {
+    switch (format) {
+        case OutputFormat::Json:
+            encodeRestaurantWith<JsonEncoder>(env, restShadow, format, out, strings);
+            break;
+        case OutputFormat::Cbor:
+            encodeRestaurantWith<binary::CborEncoder>(env, restShadow, format, out, strings);
+            break;
+        case OutputFormat::MessagePack:
+            encodeRestaurantWith<binary::MsgPackEncoder>(env, restShadow, format, out, strings);
+            break;
+    }
+}
+
+/**
+ * Encode the restaurant in any OutputFormat, through the SerializationCache when it is enabled.
+ * JsonWriter is an OutputBuffer, so one buffer type serves every format; the binary encoders only
+ * use its byte-level interface.
+ */
+void encodeRestaurant(JNIEnv* env, RestaurantShadow& restShadow, OutputFormat format, JsonWriter& out) {
+    std::optional<CallStringDictionary> strings;
+    encodeRestaurantAs(env, restShadow, format, out, beginStringDictionary(env, format, out, strings));
+}
+
+/**
+ * Drop the cached encodings of the restaurant with this id, in every format.
+ * List fragments are content-addressed and are left to LRU eviction.
+ */
+void invalidateCachedRestaurant(const std::string& id) {
+    for (auto format : {OutputFormat::Json, OutputFormat::Cbor, OutputFormat::MessagePack}) {
+        SerializationCache::remove(restaurantCacheKey(format, id));
+    }
+}
+
+// Encoding threads for batch serialization; null (the default) keeps all work on the calling thread
+static std::mutex batchPoolMutex;
+static std::shared_ptr<WorkStealingPool> batchPool;
+
+/**
+ * Resize the batch encoding pool; 0 or 1 thread turns it off.
+ * A batch still running on the old pool keeps it alive until it finishes.
+ */
+void setBatchThreadCount(size_t threads) {
+    std::shared_ptr<WorkStealingPool> replaced; // Joined after the lock is released
+    std::lock_guard<std::mutex> lock(batchPoolMutex);
+    size_t current = batchPool ? batchPool->threadCount() : 1;
+    if (current == (threads > 1 ? threads : 1)) {
+        return;
+    }
+    replaced = std::move(batchPool);
+    batchPool = threads > 1 ? std::make_shared<WorkStealingPool>(threads) : nullptr;
+}
+
+static std::shared_ptr<WorkStealingPool> currentBatchPool() {
+    std::lock_guard<std::mutex> lock(batchPoolMutex);
+    return batchPool;
+}
+
+/**
+ * A run of consecutive restaurants, extracted on the JVM thread and encoded on the pool.
+ */
+struct BatchChunk {
+    EventTape tape;
+    std::vector<size_t> ends; // Tape offset after each restaurant
+    JsonWriter out;
+};
+
+// Chunks close at whichever limit comes first, so a few huge menus still spread across threads
+static constexpr size_t kChunkRestaurants = 64;
+static constexpr size_t kChunkTapeBytes = 256 * 1024;
+
+// Each chunk has its own StringDictionary when deduplicating: tapes hold no Java objects, so it matches by content
+static void encodeBatchChunk(BatchChunk& chunk, bool ndjson, bool deduplicate) {
+    NATIVE_STATS_PHASE(BatchChunk);
+    std::optional<StringDictionary> strings;
+    if (deduplicate) {
+        strings.emplace();
+    }
+    size_t begin = 0;
+    for (size_t end : chunk.ends) {
+        if (!ndjson && begin > 0) {
+            chunk.out.append(',');
+        }
+        JsonEncoder encoder(chunk.out, strings ? &*strings : nullptr);
+        chunk.tape.replay(begin, end, encoder);
+        if (ndjson) {
+            chunk.out.append('\n');
+        }
+        begin = end;
+    }
+    chunk.tape = EventTape(); // Free the snapshot as soon as it is encoded
+}
+
+/**
+ * Two-stage batch serialization. The calling thread walks the Java objects (all JNI happens here) and
+ * records each chunk of restaurants onto an EventTape; every finished chunk is queued on the pool right away,
+ * so encoding overlaps extraction. When the caller gets too far ahead it encodes queued chunks itself, which
+ * bounds the tapes held in memory. The chunks' outputs are then concatenated in input order.
+ */
+static void writeJsonFromRestaurantListParallel(JNIEnv* env, const JavaObjectList& restaurants, bool ndjson,
+                                                WorkStealingPool& pool, JsonWriter& writer) {
+    std::vector<std::unique_ptr<BatchChunk>> chunks;
+    TaskGroup group;
+    size_t maxQueued = pool.threadCount() * 4;
+    bool deduplicate = StringDictionary::enabled;
+    auto submit = [&] {
+        BatchChunk* chunk = chunks.back().get();
+        pool.submit(group, [chunk, ndjson, deduplicate] { encodeBatchChunk(*chunk, ndjson, deduplicate); });
+        while (group.pending() > maxQueued && pool.helpOne()) {}
+    };
+
+    try {
+        chunks.push_back(std::make_unique<BatchChunk>());
+        LocalFrameChunker frames(env, 16, 32);
+        for (jint i = 0; i < restaurants.size(); i++) {
+            frames.next();
+            jobject elem = restaurants.get(env, i);
+            if (!elem) continue;
+            RestaurantShadow restShadow(env, elem);
+            BatchChunk& chunk = *chunks.back();
+            captureRestaurant(env, restShadow, chunk.tape);
+            chunk.ends.push_back(chunk.tape.size());
+            if (chunk.ends.size() == kChunkRestaurants || chunk.tape.size() >= kChunkTapeBytes) {
+                submit();
+                chunks.push_back(std::make_unique<BatchChunk>());
+            }
+        }
+        if (!chunks.back()->ends.empty()) {
+            submit();
+        }
+    } catch (...) {
+        // Queued tasks still point into chunks. The extraction error is the one reported, not a task's
+        try {
+            pool.wait(group);
+        } catch (...) {
+        }
+        throw;
+    }
+    pool.wait(group); // Rethrows an encoding task's exception here, on the JVM thread
+
+    size_t total = 2;
+    for (const auto& chunk : chunks) {
+        total += chunk->out.size() + 1;
+    }
+    writer.reserve(total);
+    if (!ndjson) {
+        writer.append('[');
+    }
+    bool first = true;
+    for (const auto& chunk : chunks) {
+        if (chunk->ends.empty()) continue;
+        if (!ndjson && !first) {
+            writer.append(',');
+        }
+        writer.append(chunk->out.data(), chunk->out.size());
+        first = false;
+    }
+    if (!ndjson) {
+        writer.append(']');
+    }
+}
+
+/**
+ * Writes the list's restaurants on the calling thread, each through encodeOne(shadow), as a JSON array or NDJSON.
+ */
+template <typename EncodeOne>
+static void writeRestaurantsSequential(JNIEnv* env, const JavaObjectList& restaurants, bool ndjson, JsonWriter& writer,
+                                       EncodeOne&& encodeOne) {
+    jint count = restaurants.size();
+    if (!ndjson) {
+        writer.append('[');
+    }
+    // Each restaurant leaves its address and list references behind; release them in chunks
+    LocalFrameChunker frames(env, 16, 32);
+    bool first = true;
+    for (jint i = 0; i < count; i++) {
+        frames.next();
+        jobject elem = restaurants.get(env, i);
+        if (!elem) continue; // Skipped, as the parallel path does
+        if (!ndjson && !first) {
+            writer.append(',');
+        }
+        first = false;
+        RestaurantShadow restShadow(env, elem);
+        encodeOne(restShadow);
+        if (ndjson) {
+            writer.append('\n');
+        }
+    }
+    if (!ndjson) {
+        writer.append(']');
+    }
+}
+
+/**
+ * Serialize every Restaurant of a java.util.List into one writer.
+ * Large lists are encoded on the batch pool when one is configured (setBatchThreadCount) and the
+ * SerializationCache is off; the cache needs the Java objects, so it keeps to the calling thread.
+ * @param ndjson true for newline-delimited JSON, false for a single JSON array.
+ */
+void writeJsonFromRestaurantList(JNIEnv* env, jobject restaurantList, bool ndjson, JsonWriter& writer) {
+    JavaObjectList restaurants(env, restaurantList);
+    int count = restaurants.size();
+    std::shared_ptr<WorkStealingPool> pool = currentBatchPool();
+    if (pool && static_cast<size_t>(count) > kChunkRestaurants && !SerializationCache::enabled()) {
+        writeJsonFromRestaurantListParallel(env, restaurants, ndjson, *pool, writer);
+        return;
+    }
+
+    std::optional<CallStringDictionary> strings;
+    StringDictionary* dictionary = beginStringDictionary(env, OutputFormat::Json, writer, strings);
+    writeRestaurantsSequential(env, restaurants, ndjson, writer, [&](RestaurantShadow& restShadow) {
+        encodeRestaurantWith<JsonEncoder>(env, restShadow, OutputFormat::Json, writer, dictionary);
+    });
+}
+
+template <typename Encoder>
+static void encodeRestaurantArray(JNIEnv* env, const JavaObjectList& restaurants, OutputFormat format, JsonWriter& out,
+                                  StringDictionary* strings) {
+    Encoder encoder(out, strings);
+    encoder.beginArray(static_cast<size_t>(restaurants.size()));
+    LocalFrameChunker frames(env, 16, 32);
+    for (jint i = 0; i < restaurants.size(); i++) {
+        frames.next();
+        jobject elem = restaurants.get(env, i);
+        if (!elem) {
+            encoder.null();
+            continue;
+        }
+        RestaurantShadow restShadow(env, elem);
+        encodeRestaurantWith<Encoder>(env, restShadow, format, out, strings);
+    }
+    encoder.endArray();
+}
+
+/**
+ * Serialize every Restaurant of a java.util.List as one array in any OutputFormat.
+ * JSON is writeJsonFromRestaurantList; the binary formats are encoded on the calling thread and, since
+ * their array length is written first, keep null elements as null.
+ */
+void encodeRestaurantList(JNIEnv* env, jobject restaurantList, OutputFormat format, JsonWriter& out) {
+    if (format == OutputFormat::Json) {
+        writeJsonFromRestaurantList(env, restaurantList, false, out);
+        return;
+    }
+    JavaObjectList restaurants(env, restaurantList);
+    std::optional<CallStringDictionary> strings;
+    StringDictionary* dictionary = beginStringDictionary(env, format, out, strings);
+    if (format == OutputFormat::Cbor) {
+        encodeRestaurantArray<binary::CborEncoder>(env, restaurants, format, out, dictionary);
+    } else {
+        encodeRestaurantArray<binary::MsgPackEncoder>(env, restaurants, format, out, dictionary);
+    }
+}
+
+/**
+ * Stream every Restaurant of a java.util.List to fd as NDJSON, in constant native memory (see FdWriter).
+ * @return Bytes written.
+ * @throws IoError if a write fails.
+ */
+size_t exportRestaurantList(JNIEnv* env, jobject restaurantList, int fd, bool overlapIo) {
+    FdWriter out(fd, overlapIo);
+    JavaObjectList restaurants(env, restaurantList);
+    modelread::checkJavaException(env); // e.g. a custom List whose toArray() threw
+    std::optional<CallStringDictionary> strings;
+    StringDictionary* dictionary = beginStringDictionary(env, OutputFormat::Json, out.current(), strings);
+    LocalFrameChunker frames(env, 16, 32);
+    for (jint i = 0; i < restaurants.size(); i++) {
+        frames.next();
+        jobject elem = restaurants.get(env, i);
+        if (!elem) continue;
+        RestaurantShadow restShadow(env, elem);
+        encodeRestaurantWith<JsonEncoder>(env, restShadow, OutputFormat::Json, out.current(), dictionary);
+        modelread::checkJavaException(env); // Stop before anything encoded after a failed JNI call is written
+        out.current().append('\n');
+        out.endRecord();
+    }
+    return out.finish();
+}
+
+/**
+ * Decode one Restaurant from UTF-8 (or modified UTF-8) JSON.
+ * @return A new local reference.
+ * @throws JsonParseError on malformed input, modelread::PendingJavaException if a JNI call threw.
+ */
+jobject readRestaurantFromJson(JNIEnv* env, const char* json, size_t length) {
+    JsonReader reader(json, length);
+    thread_local modelread::DecodeScratch scratch; // Keeps its capacity from call to call
+    jobject restaurant = modelread::decodeModel<RestaurantModel>(env, reader, scratch);
+    reader.expectEnd();
+    return restaurant;
+}
+
+/**
+ * Write the RFC 6902 JSON Patch that turns before's JSON into after's JSON.
+ */
+void writeRestaurantPatch(JNIEnv* env, RestaurantShadow& before, RestaurantShadow& after, JsonWriter& writer) {
+    modeldiff::JsonPatchWriter patch(writer);
+    std::string path;
+    modeldiff::diffModel(env, before, after, path, patch);
+    patch.finish();
+}
+
+/**
+ * Compile dotted Restaurant field paths (e.g. "menu.price") for writeProjectedRestaurant.
+ * @throws projection::ProjectionError if a path names no field.
+ */
+std::unique_ptr<projection::Selection> compileRestaurantProjection(const std::vector<std::string>& paths) {
+    return projection::compile<RestaurantModel>(paths);
+}
+
+/**
+ * Write only the selected fields of the restaurant as JSON; the cache is not used.
+ */
+void writeProjectedRestaurant(JNIEnv* env, RestaurantShadow& restShadow, const projection::Selection& selection,
+                              JsonWriter& writer) {
+    NATIVE_STATS_PHASE(Encode);
+    JsonEncoder encoder(writer);
+    projection::encodeProjected(env, restShadow, selection, encoder);
+}
+
+/**
+ * writeProjectedRestaurant for every Restaurant of a java.util.List, as a JSON array or NDJSON.
+ */
+void writeProjectedRestaurantList(JNIEnv* env, jobject restaurantList, const projection::Selection& selection,
+                                  bool ndjson, JsonWriter& writer) {
+    JavaObjectList restaurants(env, restaurantList);
+    writeRestaurantsSequential(env, restaurants, ndjson, writer, [&](RestaurantShadow& restShadow) {
+        writeProjectedRestaurant(env, restShadow, selection, writer);
+    });
+}
+
+/**
+ * Copy the rating and cuisines of every Restaurant of a java.util.List, and the price and category of every
+ * menu item, into a new columnar store. A null restaurant becomes a row that never matches, a null menu item
+ * one with a NaN price and no category.
+ */
+std::unique_ptr<columns::RestaurantColumns> loadRestaurantColumns(JNIEnv* env, jobject restaurantList) {
+    auto store = std::make_unique<columns::RestaurantColumns>();
+    JavaObjectList restaurants(env, restaurantList);
+    std::string text; // UTF-8 of the cuisine or category being dictionary-encoded
+    LocalFrameChunker frames(env, 16, 32);
+    for (jint i = 0; i < restaurants.size(); i++) {
+        frames.next();
+        jobject elem = restaurants.get(env, i);
+        if (!elem) {
+            store->addMissingRestaurant();
+            continue;
+        }
+        RestaurantShadow restShadow(env, elem);
+        store->addRestaurant(restShadow.getRating(env));
+
+        JavaObjectList cuisines(env, restShadow.getCuisines(env));
+        for (jint c = 0; c < cuisines.size(); c++) {
+            auto cuisine = static_cast<jstring>(cuisines.get(env, c));
+            if (cuisine) {
+                store->addCuisine(assignUtf8(env, cuisine, text));
+                env->DeleteLocalRef(cuisine);
+                NATIVE_STATS_LOCAL_REF_DELETED();
+            }
+        }
+
+        JavaObjectList menu(env, restShadow.getMenu(env));
+        LocalFrameChunker itemFrames(env, 64, 4);
+        for (jint m = 0; m < menu.size(); m++) {
+            itemFrames.next();
+            jobject item = menu.get(env, m);
+            if (!item) {
+                store->addMenuItem(std::numeric_limits<double>::quiet_NaN(), std::nullopt);
+                continue;
+            }
+            MenuItemShadow itemShadow(env, item);
+            jstring category = itemShadow.readJString<MenuItemShadow::field("category")>(env);
+            store->addMenuItem(itemShadow.getPrice(env),
+                               category ? std::optional<std::string_view>(assignUtf8(env, category, text))
+                                        : std::nullopt);
         }
     }
-    oss << "],";
-
-    // OpeningHours array
-    oss << "\"openingHours\":[";
-    for (int i = 0; i < openHoursCount; i++) {
-        jobject elem = getListElement(env, openHoursList, i);
-        OpeningHourShadow ohShadow(env, elem);
-
-        oss << "{";
-        oss << R"("dayOfWeek":")" << ohShadow.getDayOfWeek(env) << "\",";
-        oss << R"("openTime":")" << ohShadow.getOpenTime(env) << "\",";
-        oss << R"("closeTime":")" << ohShadow.getCloseTime(env) << "\"";
-        oss << "}";
-        if (i < openHoursCount - 1) {
-            oss << ",";
+    return store;
+}
+
+/**
+ * Compile the openingHours of every Restaurant of a java.util.List into a new weekly minute bitmap index, at
+ * minute resolution (seconds are dropped). Only exactly equal open and close times mean open around the clock;
+ * a non-empty interval within one minute opens that minute alone. A null restaurant, and entries with a null day
+ * or time, stay closed.
+ */
+std::unique_ptr<hours::OpeningHoursIndex> loadOpeningHoursIndex(JNIEnv* env, jobject restaurantList) {
+    auto index = std::make_unique<hours::OpeningHoursIndex>();
+    JavaObjectList restaurants(env, restaurantList);
+    LocalFrameChunker frames(env, 16, 32);
+    for (jint i = 0; i < restaurants.size(); i++) {
+        frames.next();
+        index->addRestaurant();
+        jobject elem = restaurants.get(env, i);
+        if (!elem) continue;
+        RestaurantShadow restShadow(env, elem);
+        JavaObjectList openingHours(env, restShadow.getOpeningHours(env));
+        for (jint h = 0; h < openingHours.size(); h++) {
+            jobject hour = openingHours.get(env, h);
+            if (!hour) continue;
+            OpeningHourShadow hourShadow(env, hour);
+            jint day = hourShadow.getDayOfWeekOrdinal(env);
+            temporal::LocalTimeParts open;
+            temporal::LocalTimeParts close;
+            if (day >= 0 && day < 7 && hourShadow.getOpenTimeParts(env, open) &&
+                hourShadow.getCloseTimeParts(env, close)) {
+                int openMinute = open.minuteOfDay();
+                int closeMinute = close.minuteOfDay();
+                // Decided before truncating: 09:00:00-09:00:30 is not 24 hours
+                if (openMinute == closeMinute &&
+                    (close.second > open.second || (close.second == open.second && close.nano > open.nano))) {
+                    closeMinute = openMinute + 1;
+                }
+                index->addInterval(static_cast<uint32_t>(day), static_cast<uint32_t>(openMinute),
+                                   static_cast<uint32_t>(closeMinute));
+            }
+            env->DeleteLocalRef(hour);
+            NATIVE_STATS_LOCAL_REF_DELETED();
         }
     }
-    oss << "],";
-
-    // Menu array
-    oss << "\"menu\":[";
-    for (int i = 0; i < menuCount; i++) {
-        jobject elem = getListElement(env, menuList, i);
-        MenuItemShadow miShadow(env, elem);
-
-        oss << "{";
-        oss << R"("id":")" << miShadow.getId(env) << "\",";
-        oss << R"("name":")" << miShadow.getName(env) << "\",";
-        oss << R"("description":")" << miShadow.getDescription(env) << "\",";
-        oss << "\"price\":" << miShadow.getPrice(env) << ",";
-        oss << R"("category":")" << miShadow.getCategory(env) << "\"";
-        oss << "}";
-        if (i < menuCount - 1) {
-            oss << ",";
+    index->finish();
+    return index;
+}
+
+/**
+ * Normalize the name and description of every menu item of restShadow into menu, which is cleared first.
+ * Null items are left out; item indices stay those of the Kotlin menu list.
+ */
+static void readMenuText(JNIEnv* env, RestaurantShadow& restShadow, search::MenuText& menu) {
+    menu.clear();
+    JavaObjectList items(env, restShadow.getMenu(env));
+    LocalFrameChunker itemFrames(env, 64, 4);
+    for (jint m = 0; m < items.size(); m++) {
+        itemFrames.next();
+        jobject item = items.get(env, m);
+        if (!item) continue;
+        MenuItemShadow itemShadow(env, item);
+        // One string view at a time: a long one is pinned with GetStringCritical
+        {
+            JavaStringChars name(env, itemShadow.readJString<MenuItemShadow::field("name")>(env));
+            menu.addItem(static_cast<uint32_t>(m), name.data(), name.size());
+        }
+        jstring description = itemShadow.readJString<MenuItemShadow::field("description")>(env);
+        if (description) {
+            JavaStringChars chars(env, description);
+            menu.setDescription(chars.data(), chars.size());
         }
     }
-    oss << "]";
+}
 
-    oss << "}"; // end JSON object
+/**
+ * Index the menu item names and descriptions of every Restaurant of a java.util.List into a new trigram index,
+ * restaurant i of the list under index i. A null restaurant has no menu items.
+ */
+std::unique_ptr<search::TrigramIndex> loadMenuSearchIndex(JNIEnv* env, jobject restaurantList) {
+    auto index = std::make_unique<search::TrigramIndex>();
+    JavaObjectList restaurants(env, restaurantList);
+    LocalFrameChunker frames(env, 16, 32);
+    search::MenuText menu;
+    for (jint i = 0; i < restaurants.size(); i++) {
+        frames.next();
+        jobject elem = restaurants.get(env, i);
+        if (!elem) continue;
+        RestaurantShadow restShadow(env, elem);
+        readMenuText(env, restShadow, menu);
+        index->replaceRestaurant(static_cast<uint32_t>(i), menu);
+    }
+    return index;
+}
 
-    return oss.str();
+/**
+ * Replace the menu items indexed under restaurantIndex with those of restaurant; null removes them.
+ */
+void updateMenuSearchIndex(JNIEnv* env, search::TrigramIndex& index, jint restaurantIndex, jobject restaurant) {
+    if (!restaurant) {
+        index.removeRestaurant(static_cast<uint32_t>(restaurantIndex));
+        return;
+    }
+    RestaurantShadow restShadow(env, restaurant);
+    search::MenuText menu;
+    readMenuText(env, restShadow, menu);
+    index.replaceRestaurant(static_cast<uint32_t>(restaurantIndex), menu);
 }
@@ -0,0 +1,147 @@
+#ifndef ANDROID_SDK_SCRATCHARENA_H
+#define ANDROID_SDK_SCRATCHARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class ScratchArena
+ * @brief Per-thread bump allocator for the transient data of one native call (e.g. the UTF-8 strings the
+ *        shadow accessors return as std::string_view).
+ *
+ * Allocation is a pointer bump in the current block; nothing is freed individually. A native entry point opens
+ * a ScratchArena::Scope, and when the outermost scope of the thread closes the arena rewinds, invalidating
+ * everything allocated in it. A call that outgrew the main block gets overflow blocks; on rewind they are
+ * merged into one main block big enough for that call, so from then on calls of the same size do not allocate.
+ *
+ * Usage:
+ *   ScratchArena::Scope scratch;
+ *   std::string_view id = restShadow.getId(env); // valid until scratch closes
+ */
+class ScratchArena {
+public:
+    static constexpr size_t kInitialBlockSize = 16 * 1024;
+    static constexpr size_t kMaxRetainedBlockSize = 1024 * 1024;
+
+    /**
+     * Opens the calling thread's arena for one native call; nested scopes share it.
+     */
+    class Scope {
+    public:
+        Scope() : arena_(current()) {
+            arena_.depth_++;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope() {
+            if (--arena_.depth_ == 0) {
+                arena_.rewind();
+            }
+        }
+
+    private:
+        ScratchArena& arena_;
+    };
+
+    static ScratchArena& current() {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /**
+     * @return size bytes aligned to alignment (a power of two), valid until the arena rewinds.
+     */
+    char* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= capacity_) {
+            used_ = offset + size;
+            return block_.get() + offset;
+        }
+        return allocateOverflow(size, alignment);
+    }
+
+    std::string_view copy(const char* text, size_t length) {
+        char* out = allocate(length, 1);
+        std::memcpy(out, text, length);
+        return std::string_view(out, length);
+    }
+
+    /**
+     * Returns the last allocation's unused tail: shrinks an allocation of allocated bytes to used bytes.
+     * Only valid right after that allocation.
+     */
+    void shrinkLast(char* allocation, size_t allocated, size_t used) {
+        if (!overflow_.empty() || allocation + allocated != block_.get() + used_) {
+            return; // Overflow blocks are not reused within the call anyway
+        }
+        used_ -= allocated - used;
+    }
+
+    /**
+     * Bytes reserved by the arena's main block.
+     */
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    std::unique_ptr<char[]> block_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    std::vector<std::unique_ptr<char[]>> overflow_;
+    size_t overflowBytes_ = 0;
+    size_t overflowUsed_ = 0;     // Of the last overflow block
+    size_t overflowCapacity_ = 0;
+    int depth_ = 0;
+
+    char* allocateOverflow(size_t size, size_t alignment) {
+        if (!block_ && overflow_.empty() && size + alignment <= kInitialBlockSize) {
+            block_.reset(new char[kInitialBlockSize]);
+            capacity_ = kInitialBlockSize;
+            return allocate(size, alignment);
+        }
+        uintptr_t offset = (overflowUsed_ + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        if (overflow_.empty() || offset + size > overflowCapacity_) {
+            // new char[] is aligned for any fundamental type; larger alignments take the slack
+            overflowCapacity_ = std::max(size + alignment, std::max(capacity_, kInitialBlockSize));
+            overflow_.emplace_back(new char[overflowCapacity_]);
+            overflowBytes_ += overflowCapacity_;
+            auto address = reinterpret_cast<uintptr_t>(overflow_.back().get());
+            offset = ((address + alignment - 1) & ~(uintptr_t(alignment) - 1)) - address;
+        }
+        overflowUsed_ = offset + size;
+        return overflow_.back().get() + offset;
+    }
+
+    void rewind() {
+        if (!overflow_.empty()) {
+            size_t needed = used_ + overflowBytes_;
+            size_t grown = capacity_ ? capacity_ : kInitialBlockSize;
+            while (grown < needed && grown < kMaxRetainedBlockSize) {
+                grown *= 2;
+            }
+            if (grown > capacity_) {
+                block_.reset(new char[grown]);
+                capacity_ = grown;
+            }
+            overflow_.clear();
+            overflowBytes_ = 0;
+            overflowUsed_ = 0;
+            overflowCapacity_ = 0;
+        }
+        used_ = 0;
+    }
+};
+
+#endif // ANDROID_SDK_SCRATCHARENA_H
@@ -0,0 +1,143 @@
+#ifndef ANDROID_SDK_SERIALIZATIONCACHE_H
+#define ANDROID_SDK_SERIALIZATIONCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @class SerializationCache
+ * @brief Byte-bounded LRU cache of encoded output, shared by all threads; off (capacity 0) by default.
+ *
+ * Entries map a key to the fingerprint of the content they were encoded from and the encoded bytes.
+ * A lookup only hits when the fingerprint still matches, so changed content is never served stale
+ * (up to 64-bit hash collisions).
+ *
+ * Keys in use (see RestaurantNative.cpp):
+ *   R<format>:<restaurant id>          whole restaurants, validated by the restaurant's fingerprint
+ *   F<format>:<field>:<fingerprint>    encoded list fields, shared by every restaurant with the same list
+ */
+class SerializationCache {
+public:
+    struct Stats {
+        int64_t hits;
+        int64_t misses;
+        int64_t fragmentHits;
+        int64_t fragmentMisses;
+        int64_t evictions;
+        int64_t entries;
+        int64_t bytes;
+    };
+
+    static bool enabled() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_ > 0;
+    }
+
+    /**
+     * Sets the byte budget, evicting as needed; 0 disables the cache and drops everything.
+     */
+    static void setCapacity(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = bytes;
+        evictToCapacity();
+    }
+
+    /**
+     * Calls use(const char* bytes, size_t length) with the cached bytes for key if the entry's fingerprint
+     * matches. It runs under the cache lock, so the bytes can be appended straight into the output without an
+     * intermediate copy; use must not call back into the cache.
+     */
+    template <typename Use>
+    static bool lookup(const std::string& key, uint64_t fingerprint, Use&& use, bool fragment = false) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(key);
+        bool hit = found != index_.end() && found->second->fingerprint == fingerprint;
+        (fragment ? (hit ? stats_.fragmentHits : stats_.fragmentMisses) : (hit ? stats_.hits : stats_.misses))++;
+        if (!hit) {
+            return false;
+        }
+        entries_.splice(entries_.begin(), entries_, found->second); // Most recently used first
+        const std::string& bytes = found->second->bytes;
+        use(bytes.data(), bytes.size());
+        return true;
+    }
+
+    static void store(const std::string& key, uint64_t fingerprint, const char* bytes, size_t length) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entrySize(key, length) > capacity_) {
+            return; // Would evict everything and still not fit
+        }
+        removeLocked(key);
+        entries_.push_front(Entry{key, fingerprint, std::string(bytes, length)});
+        index_.emplace(key, entries_.begin());
+        size_ += entrySize(key, length);
+        evictToCapacity();
+    }
+
+    static void remove(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        removeLocked(key);
+    }
+
+    static void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+        size_ = 0;
+    }
+
+    static Stats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats current = stats_;
+        current.entries = static_cast<int64_t>(entries_.size());
+        current.bytes = static_cast<int64_t>(size_);
+        return current;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t fingerprint;
+        std::string bytes;
+    };
+
+    // Rough per-entry bookkeeping (list node, hash node, string headers)
+    static constexpr size_t kEntryOverhead = 128;
+
+    inline static std::mutex mutex_;
+    inline static std::list<Entry> entries_;
+    inline static std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    inline static size_t capacity_ = 0;
+    inline static size_t size_ = 0;
+    inline static Stats stats_ = {};
+
+    static size_t entrySize(const std::string& key, size_t length) {
+        return key.size() * 2 + length + kEntryOverhead;
+    }
+
+    static void removeLocked(const std::string& key) {
+        auto found = index_.find(key);
+        if (found == index_.end()) {
+            return;
+        }
+        size_ -= entrySize(key, found->second->bytes.size());
+        entries_.erase(found->second);
+        index_.erase(found);
+    }
+
+    static void evictToCapacity() {
+        while (size_ > capacity_ && !entries_.empty()) {
+            const Entry& oldest = entries_.back();
+            size_ -= entrySize(oldest.key, oldest.bytes.size());
+            index_.erase(oldest.key);
+            entries_.pop_back();
+            stats_.evictions++;
+        }
+    }
+};
+
+#endif // ANDROID_SDK_SERIALIZATIONCACHE_H
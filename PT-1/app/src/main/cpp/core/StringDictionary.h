@@ -0,0 +1,289 @@
+#ifndef ANDROID_SDK_STRINGDICTIONARY_H
+#define ANDROID_SDK_STRINGDICTIONARY_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class StringDictionary
+ * @brief Per-call dictionary of the strings an encoder has already written, so a repeated value is encoded once.
+ *
+ * Entries are keyed by UTF-16 content and keep the value's encoded bytes; an encoder that meets the same text
+ * again copies those bytes instead of transcoding, or, in CBOR, writes a back-reference (see CborEncoder).
+ * A dictionary belongs to one call and one output format, and is not thread-safe.
+ *
+ * Identity shortcut: the traversal may also remember, per call site (a model field), the Java object whose text
+ * it just encoded. When the next object at that site is the same one (IsSameObject), it skips reading the chars
+ * altogether. Sites whose objects keep changing are no longer checked after kIdentityMissLimit misses in a row.
+ * The dictionary stores the objects as opaque pointers; the JNI side retains and releases them.
+ *
+ * Strings longer than kMaxStringLength (descriptions) rarely repeat and are never stored or hashed.
+ */
+class StringDictionary {
+public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr size_t kMaxStringLength = 32;
+    static constexpr size_t kMaxEntries = 16 * 1024;
+    static constexpr uint32_t kIdentityMissLimit = 16;
+
+    struct Stats {
+        int64_t lookups;
+        int64_t hits;         // Transcodes saved
+        int64_t identityHits; // JNI string reads saved
+        int64_t bytesSaved;   // Output bytes saved by back-references
+    };
+
+    /**
+     * Global switch for the native entry points; off by default.
+     */
+    inline static std::atomic<bool> enabled{false};
+
+    StringDictionary() : slots_(kInitialSlots, kNone) {}
+
+    StringDictionary(const StringDictionary&) = delete;
+    StringDictionary& operator=(const StringDictionary&) = delete;
+
+    ~StringDictionary() {
+        totalLookups_ += stats_.lookups;
+        totalHits_ += stats_.hits;
+        totalIdentityHits_ += stats_.identityHits;
+        totalBytesSaved_ += stats_.bytesSaved;
+    }
+
+    /**
+     * @return The entry holding text, or kNone. Also becomes lastEntry().
+     */
+    uint32_t lookup(const char16_t* text, size_t length) {
+        lastEntry_ = kNone;
+        if (length > kMaxStringLength) {
+            return kNone;
+        }
+        stats_.lookups++;
+        uint64_t hash = hashOf(text, length);
+        for (size_t slot = hash & (slots_.size() - 1);; slot = (slot + 1) & (slots_.size() - 1)) {
+            uint32_t entry = slots_[slot];
+            if (entry == kNone) {
+                return kNone;
+            }
+            const Entry& candidate = entries_[entry];
+            if (candidate.hash == hash && candidate.textLength == length &&
+                std::memcmp(&text_[candidate.textOffset], text, length * sizeof(char16_t)) == 0) {
+                stats_.hits++;
+                lastEntry_ = entry;
+                return entry;
+            }
+        }
+    }
+
+    /**
+     * Stores text, which lookup() did not find, with its encoding; also becomes lastEntry().
+     * @param refIndex Free for the encoder, e.g. the string's index in a CBOR stringref table.
+     * @return The new entry, or kNone when text is too long or the dictionary is full.
+     */
+    uint32_t insert(const char16_t* text, size_t length, const char* encoded, size_t encodedLength,
+                    uint32_t refIndex = kNone) {
+        lastEntry_ = kNone;
+        if (length > kMaxStringLength || entries_.size() >= kMaxEntries) {
+            return kNone;
+        }
+        if ((entries_.size() + 1) * 2 > slots_.size()) {
+            rehash(slots_.size() * 2);
+        }
+        auto entry = static_cast<uint32_t>(entries_.size());
+        uint64_t hash = hashOf(text, length);
+        entries_.push_back(Entry{hash, static_cast<uint32_t>(text_.size()), static_cast<uint32_t>(length),
+                                 static_cast<uint32_t>(encoded_.size()), static_cast<uint32_t>(encodedLength),
+                                 refIndex});
+        text_.insert(text_.end(), text, text + length);
+        encoded_.insert(encoded_.end(), encoded, encoded + encodedLength);
+        place(entry);
+        lastEntry_ = entry;
+        return entry;
+    }
+
+    /**
+     * The entry found or stored by the last lookup() or insert(), or kNone.
+     */
+    uint32_t lastEntry() const {
+        return lastEntry_;
+    }
+
+    std::string_view encoded(uint32_t entry) const {
+        const Entry& e = entries_[entry];
+        return std::string_view(encoded_.data() + e.encodedOffset, e.encodedLength);
+    }
+
+    uint32_t refIndex(uint32_t entry) const {
+        return entries_[entry].refIndex;
+    }
+
+    void setRefIndex(uint32_t entry, uint32_t refIndex) {
+        entries_[entry].refIndex = refIndex;
+    }
+
+    /**
+     * Back-reference index of UTF-8 text (keys, day names, times), kNone until the encoder sets one.
+     */
+    uint32_t& utf8RefIndex(std::string_view text) {
+        auto found = utf8Refs_.find(text);
+        if (found != utf8Refs_.end()) {
+            return found->second;
+        }
+        utf8Text_.emplace_back(text);
+        return utf8Refs_.emplace(utf8Text_.back(), kNone).first->second;
+    }
+
+    /**
+     * Claims the next index of the encoder's back-reference table.
+     */
+    uint32_t appendRef() {
+        return refCount_++;
+    }
+
+    uint32_t refCount() const {
+        return refCount_;
+    }
+
+    void addBytesSaved(size_t bytes) {
+        stats_.bytesSaved += static_cast<int64_t>(bytes);
+    }
+
+    /**
+     * The entry of the object last remembered at site, if sameObject(last) says object is that same object.
+     */
+    template <typename SameObject>
+    uint32_t findSameObject(const void* site, SameObject&& sameObject) {
+        IdentitySlot* slot = identitySlot(site);
+        if (!slot->object || slot->misses >= kIdentityMissLimit) {
+            return kNone;
+        }
+        if (!sameObject(slot->object)) {
+            slot->misses++;
+            return kNone;
+        }
+        slot->misses = 0;
+        stats_.lookups++;
+        stats_.identityHits++;
+        stats_.hits++;
+        return slot->entry;
+    }
+
+    /**
+     * Remembers the object just encoded at site as lastEntry(), replacing the previous one.
+     * @param retain Returns a reference that stays valid for the rest of the call.
+     * @param release Releases a reference returned by retain.
+     */
+    template <typename Retain, typename Release>
+    void rememberObject(const void* site, Retain&& retain, Release&& release) {
+        IdentitySlot* slot = identitySlot(site);
+        if (lastEntry_ == kNone || slot->misses >= kIdentityMissLimit || slot->entry == lastEntry_) {
+            return;
+        }
+        if (slot->object) {
+            release(slot->object);
+        }
+        slot->object = retain();
+        slot->entry = lastEntry_;
+    }
+
+    /**
+     * Releases every remembered object; the owner calls this before the dictionary goes away.
+     */
+    template <typename Release>
+    void releaseObjects(Release&& release) {
+        for (IdentitySlot& slot : identitySlots_) {
+            if (slot.object) {
+                release(slot.object);
+                slot.object = nullptr;
+            }
+        }
+    }
+
+    const Stats& stats() const {
+        return stats_;
+    }
+
+    /**
+     * Sums over every dictionary destroyed so far.
+     */
+    static Stats totals() {
+        return Stats{totalLookups_, totalHits_, totalIdentityHits_, totalBytesSaved_};
+    }
+
+private:
+    static constexpr size_t kInitialSlots = 256;
+
+    struct Entry {
+        uint64_t hash;
+        uint32_t textOffset;
+        uint32_t textLength;
+        uint32_t encodedOffset;
+        uint32_t encodedLength;
+        uint32_t refIndex;
+    };
+
+    struct IdentitySlot {
+        const void* site;
+        const void* object;
+        uint32_t entry;
+        uint32_t misses;
+    };
+
+    // Sums of the Stats of destroyed dictionaries
+    inline static std::atomic<int64_t> totalLookups_{0};
+    inline static std::atomic<int64_t> totalHits_{0};
+    inline static std::atomic<int64_t> totalIdentityHits_{0};
+    inline static std::atomic<int64_t> totalBytesSaved_{0};
+
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> slots_; // Open addressing, linear probing; at most half full
+    std::vector<char16_t> text_;
+    std::vector<char> encoded_;
+    std::deque<std::string> utf8Text_; // Owns the keys of utf8Refs_; a deque never moves its elements
+    std::unordered_map<std::string_view, uint32_t> utf8Refs_;
+    std::vector<IdentitySlot> identitySlots_;
+    uint32_t refCount_ = 0;
+    uint32_t lastEntry_ = kNone;
+    Stats stats_{};
+
+    static uint64_t hashOf(const char16_t* text, size_t length) {
+        uint64_t hash = 0x9E3779B97F4A7C15ull ^ length;
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ text[i]) * 0x100000001B3ull;
+        }
+        return hash ^ (hash >> 29);
+    }
+
+    void place(uint32_t entry) {
+        size_t mask = slots_.size() - 1;
+        size_t slot = entries_[entry].hash & mask;
+        while (slots_[slot] != kNone) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = entry;
+    }
+
+    void rehash(size_t slotCount) {
+        slots_.assign(slotCount, kNone);
+        for (uint32_t entry = 0; entry < entries_.size(); entry++) {
+            place(entry);
+        }
+    }
+
+    // A handful of sites per model, so a linear scan beats hashing
+    IdentitySlot* identitySlot(const void* site) {
+        for (IdentitySlot& slot : identitySlots_) {
+            if (slot.site == site) return &slot;
+        }
+        identitySlots_.push_back(IdentitySlot{site, nullptr, kNone, 0});
+        return &identitySlots_.back();
+    }
+};
+
+#endif // ANDROID_SDK_STRINGDICTIONARY_H
@@ -0,0 +1,152 @@
+#ifndef ANDROID_SDK_TEMPORALFORMAT_H
+#define ANDROID_SDK_TEMPORALFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * Native formatting of java.time values, byte-for-byte identical to their toString().
+ */
+namespace temporal {
+
+struct DayName {
+    const char* text;
+    size_t length;
+};
+
+/**
+ * DayOfWeek.name() indexed by ordinal (MONDAY = 0).
+ */
+inline constexpr DayName kDayOfWeekNames[7] = {
+        {"MONDAY", 6}, {"TUESDAY", 7}, {"WEDNESDAY", 9}, {"THURSDAY", 8},
+        {"FRIDAY", 6}, {"SATURDAY", 8}, {"SUNDAY", 6}
+};
+
+/**
+ * The primitive state of a java.time.LocalTime.
+ */
+struct LocalTimeParts {
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int nano = 0;
+
+    int minuteOfDay() const { return hour * 60 + minute; }
+};
+
+/**
+ * Longest LocalTime.toString(): "HH:mm:ss.nnnnnnnnn".
+ */
+constexpr size_t kMaxLocalTimeLength = 18;
+
+namespace detail {
+
+inline char* twoDigits(int value, char* out) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+    return out + 2;
+}
+
+inline char* fixedDigits(uint32_t value, int width, char* out) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+} // namespace detail
+
+/**
+ * Formats like LocalTime.toString(): HH:mm, then :ss if seconds or nanos are set, then the
+ * nanos as 3, 6 or 9 digits, whichever is the shortest exact form.
+ * @param out At least kMaxLocalTimeLength bytes.
+ * @return The number of bytes written.
+ */
+inline size_t formatLocalTime(const LocalTimeParts& time, char* out) {
+    char* p = detail::twoDigits(time.hour, out);
+    *p++ = ':';
+    p = detail::twoDigits(time.minute, p);
+    if (time.second > 0 || time.nano > 0) {
+        *p++ = ':';
+        p = detail::twoDigits(time.second, p);
+        if (time.nano > 0) {
+            *p++ = '.';
+            auto nano = static_cast<uint32_t>(time.nano);
+            if (nano % 1000000 == 0) {
+                p = detail::fixedDigits(nano / 1000000, 3, p);
+            } else if (nano % 1000 == 0) {
+                p = detail::fixedDigits(nano / 1000, 6, p);
+            } else {
+                p = detail::fixedDigits(nano, 9, p);
+            }
+        }
+    }
+    return static_cast<size_t>(p - out);
+}
+
+inline std::string toString(const LocalTimeParts& time) {
+    char buffer[kMaxLocalTimeLength];
+    return std::string(buffer, formatLocalTime(time, buffer));
+}
+
+/**
+ * @return The ordinal of the DayOfWeek.name() in text, or -1 if it is not one.
+ */
+inline int parseDayOfWeek(const char* text, size_t length) {
+    for (int ordinal = 0; ordinal < 7; ordinal++) {
+        const DayName& day = kDayOfWeekNames[ordinal];
+        if (day.length == length && std::memcmp(day.text, text, length) == 0) {
+            return ordinal;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Parses what LocalTime.toString() produces: HH:mm, optionally :ss and then 1 to 9 fraction digits.
+ * @return false if text is not such a time.
+ */
+inline bool parseLocalTime(const char* text, size_t length, LocalTimeParts& time) {
+    auto digit = [&](size_t i) { return i < length && text[i] >= '0' && text[i] <= '9'; };
+    auto twoDigits = [&](size_t i) { return (text[i] - '0') * 10 + (text[i + 1] - '0'); };
+
+    if (length < 5 || !digit(0) || !digit(1) || text[2] != ':' || !digit(3) || !digit(4)) {
+        return false;
+    }
+    LocalTimeParts parsed;
+    parsed.hour = twoDigits(0);
+    parsed.minute = twoDigits(3);
+    size_t i = 5;
+    if (i < length) {
+        if (text[i] != ':' || !digit(i + 1) || !digit(i + 2)) {
+            return false;
+        }
+        parsed.second = twoDigits(i + 1);
+        i += 3;
+        if (i < length) {
+            if (text[i] != '.' || !digit(i + 1)) {
+                return false;
+            }
+            int scale = 100000000;
+            for (i++; i < length; i++) {
+                if (!digit(i) || scale == 0) {
+                    return false;
+                }
+                parsed.nano += (text[i] - '0') * scale;
+                scale /= 10;
+            }
+        }
+    }
+    if (parsed.hour > 23 || parsed.minute > 59 || parsed.second > 59) {
+        return false;
+    }
+    time = parsed;
+    return true;
+}
+
+} // namespace temporal
+
+#endif // ANDROID_SDK_TEMPORALFORMAT_H
@@ -0,0 +1,537 @@
+#ifndef ANDROID_SDK_TRIGRAMINDEX_H
+#define ANDROID_SDK_TRIGRAMINDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Utf16ToUtf8.h"
+
+/**
+ * Full-text search over short texts (menu item names and descriptions) with a trigram index.
+ *
+ * Text is normalized before it is indexed or searched: letters are case-folded (ASCII, Latin-1, Greek and
+ * Cyrillic capitals), every run of ASCII spaces and punctuation becomes a single space, and one space is put in
+ * front. "Gluten-Free Pasta" is therefore stored as " gluten free pasta", a substring search for "gluten free"
+ * finds it, and a prefix search, which looks for " " + query, only matches at the start of a word.
+ *
+ * Every 3-byte window of the normalized UTF-8 is a trigram with a posting list of the documents containing it.
+ * A query intersects the posting lists of its own trigrams, then confirms each candidate against the stored text.
+ */
+namespace search {
+
+/**
+ * Simple case folding of one UTF-16 code unit; ASCII characters other than letters and digits become ' '.
+ */
+inline char16_t foldCodeUnit(char16_t c) {
+    if (c < 0x80) {
+        if (c >= 'A' && c <= 'Z') return static_cast<char16_t>(c + 0x20);
+        bool alphanumeric = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+        return alphanumeric ? c : u' ';
+    }
+    if ((c >= 0xC0 && c <= 0xDE && c != 0xD7) ||        // Latin-1 capitals, except the multiplication sign
+        (c >= 0x391 && c <= 0x3A9 && c != 0x3A2) ||     // Greek capitals
+        (c >= 0x410 && c <= 0x42F)) {                   // Cyrillic А-Я
+        return static_cast<char16_t>(c + 0x20);
+    }
+    if (c >= 0x400 && c <= 0x40F) return static_cast<char16_t>(c + 0x50); // Cyrillic Ѐ-Џ
+    return c;
+}
+
+/**
+ * Appends the normalized UTF-8 of text (see above) to out: a leading space, then the folded words.
+ */
+inline void appendNormalized(const char16_t* text, size_t length, std::string& out) {
+    thread_local std::u16string folded; // Keeps its capacity from call to call
+    folded.assign(1, u' ');
+    for (size_t i = 0; i < length; i++) {
+        char16_t c = foldCodeUnit(text[i]);
+        if (c != u' ' || folded.back() != u' ') {
+            folded.push_back(c);
+        }
+    }
+    if (folded.size() > 1 && folded.back() == u' ') {
+        folded.pop_back();
+    }
+    size_t start = out.size();
+    out.resize(start + utf16::maxUtf8Length(folded.size(), false));
+    out.resize(start + utf16::transcode<false>(folded.data(), folded.size(), &out[start]));
+}
+
+/**
+ * @class PostingList
+ * @brief Ascending document ids, varint delta-encoded in blocks of kBlockSize.
+ *
+ * Each block records its first id and byte offset, so a cursor can gallop over the blocks and decode only the
+ * block that may hold its target.
+ */
+class PostingList {
+public:
+    static constexpr size_t kBlockSize = 128;
+
+    /**
+     * Appends doc, which must be greater than every id already in the list.
+     */
+    void append(uint32_t doc) {
+        if (count_ % kBlockSize == 0) {
+            blocks_.push_back(Block{doc, static_cast<uint32_t>(bytes_.size())});
+        } else {
+            for (uint32_t delta = doc - last_; ; delta >>= 7) {
+                if (delta < 0x80) {
+                    bytes_.push_back(static_cast<uint8_t>(delta));
+                    break;
+                }
+                bytes_.push_back(static_cast<uint8_t>(delta | 0x80));
+            }
+        }
+        last_ = doc;
+        count_++;
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+    size_t blockCount() const {
+        return blocks_.size();
+    }
+
+    uint32_t blockFirst(size_t block) const {
+        return blocks_[block].first;
+    }
+
+    /**
+     * Decodes block into out.
+     * @return The number of ids in the block.
+     */
+    size_t decode(size_t block, uint32_t* out) const {
+        size_t count = std::min(kBlockSize, count_ - block * kBlockSize);
+        const uint8_t* in = bytes_.data() + blocks_[block].offset;
+        uint32_t doc = blocks_[block].first;
+        out[0] = doc;
+        for (size_t i = 1; i < count; i++) {
+            uint32_t delta = 0;
+            for (unsigned shift = 0; ; shift += 7) {
+                uint8_t byte = *in++;
+                delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if (byte < 0x80) break;
+            }
+            doc += delta;
+            out[i] = doc;
+        }
+        return count;
+    }
+
+    size_t memoryBytes() const {
+        return bytes_.capacity() + blocks_.capacity() * sizeof(Block);
+    }
+
+private:
+    struct Block {
+        uint32_t first;
+        uint32_t offset;
+    };
+
+    std::vector<uint8_t> bytes_;
+    std::vector<Block> blocks_;
+    size_t count_ = 0;
+    uint32_t last_ = 0;
+};
+
+/**
+ * @class PostingCursor
+ * @brief Forward iterator over a PostingList with galloping seek.
+ */
+class PostingCursor {
+public:
+    explicit PostingCursor(const PostingList& list) : list_(&list) {
+        load(0);
+    }
+
+    bool done() const {
+        return index_ >= count_;
+    }
+
+    uint32_t doc() const {
+        return decoded_[index_];
+    }
+
+    void next() {
+        if (++index_ == count_ && block_ + 1 < list_->blockCount()) {
+            load(block_ + 1);
+        }
+    }
+
+    /**
+     * Moves to the first id >= target (or past the end). Never moves backwards.
+     */
+    void seek(uint32_t target) {
+        if (done() || doc() >= target) {
+            return;
+        }
+        if (target > decoded_[count_ - 1]) {
+            // Gallop over the block heads for the last block starting at or before target, or the next block
+            // when even that one starts past it
+            size_t low = block_ + 1;
+            size_t step = 1;
+            size_t high = low;
+            while (high < list_->blockCount() && list_->blockFirst(high) <= target) {
+                low = high;
+                high += step;
+                step *= 2;
+            }
+            if (low >= list_->blockCount()) {
+                index_ = count_; // Every remaining id is below target
+                return;
+            }
+            high = std::min(high, list_->blockCount());
+            while (high - low > 1) {
+                size_t middle = low + (high - low) / 2;
+                if (list_->blockFirst(middle) <= target) low = middle; else high = middle;
+            }
+            load(low);
+        }
+        index_ = static_cast<size_t>(std::lower_bound(decoded_ + index_, decoded_ + count_, target) - decoded_);
+        if (index_ == count_ && block_ + 1 < list_->blockCount()) {
+            load(block_ + 1);
+        }
+    }
+
+private:
+    const PostingList* list_;
+    size_t block_ = 0;
+    size_t index_ = 0;
+    size_t count_ = 0;
+    uint32_t decoded_[PostingList::kBlockSize];
+
+    void load(size_t block) {
+        block_ = block;
+        index_ = 0;
+        count_ = block < list_->blockCount() ? list_->decode(block, decoded_) : 0;
+    }
+};
+
+/**
+ * @class MenuText
+ * @brief The normalized names and descriptions of one restaurant's menu, ready to go into a TrigramIndex.
+ *
+ * Normalizing needs no lock, so a menu is prepared first and the index is then held only to swap it in.
+ */
+class MenuText {
+public:
+    struct Item {
+        uint32_t index; // Position in the restaurant's menu
+        uint32_t nameLength;
+        uint32_t descriptionLength;
+    };
+
+    void clear() {
+        text_.clear();
+        items_.clear();
+    }
+
+    /**
+     * Adds menu item index with an empty description; a null name is passed as empty.
+     */
+    void addItem(uint32_t index, const char16_t* name, size_t nameLength) {
+        size_t start = text_.size();
+        appendNormalized(name, nameLength, text_);
+        items_.push_back(Item{index, static_cast<uint32_t>(text_.size() - start), 1});
+        text_.push_back(' '); // What an empty description normalizes to
+    }
+
+    /**
+     * Sets the description of the last item added.
+     */
+    void setDescription(const char16_t* description, size_t length) {
+        text_.resize(text_.size() - items_.back().descriptionLength);
+        size_t start = text_.size();
+        appendNormalized(description, length, text_);
+        items_.back().descriptionLength = static_cast<uint32_t>(text_.size() - start);
+    }
+
+    const std::string& text() const {
+        return text_;
+    }
+
+    const std::vector<Item>& items() const {
+        return items_;
+    }
+
+private:
+    std::string text_; // Name then description of each item, back to back
+    std::vector<Item> items_;
+};
+
+/**
+ * @class TrigramIndex
+ * @brief Searchable names and descriptions of the menu items of many restaurants, updatable per restaurant.
+ *
+ * Every menu item is a document with an id in insertion order, so posting lists only ever grow at the end and a
+ * menu edit touches only the lists of its own trigrams. Replacing or removing a restaurant's menu marks its old
+ * documents dead; queries skip them, and once a quarter of the documents are dead the index is compacted from
+ * the live ones. Searches may run concurrently with each other; updates take the index exclusively.
+ */
+class TrigramIndex {
+public:
+    struct Hit {
+        uint32_t restaurant;
+        uint32_t item;
+        int32_t score;
+    };
+
+    /**
+     * Replaces the menu items of restaurant with those of menu; an empty menu removes the restaurant.
+     */
+    void replaceRestaurant(uint32_t restaurant, const MenuText& menu) {
+        std::unique_lock<std::shared_mutex> lock(lock_);
+        removeDocuments(restaurant);
+        uint32_t offset = 0;
+        for (const MenuText::Item& item : menu.items()) {
+            auto base = static_cast<uint32_t>(text_.size());
+            text_.append(menu.text(), offset, item.nameLength + item.descriptionLength);
+            addDocument(Document{restaurant, item.index, base, item.nameLength, base + item.nameLength,
+                                 item.descriptionLength, true});
+            offset += item.nameLength + item.descriptionLength;
+        }
+        if (dead_ * 4 > documents_.size()) {
+            compact();
+        }
+    }
+
+    void removeRestaurant(uint32_t restaurant) {
+        replaceRestaurant(restaurant, MenuText());
+    }
+
+    /**
+     * Menu items whose normalized name or description contains the normalized query, best first: name matches
+     * before description matches, whole names and word starts first, then earlier positions; ties in
+     * (restaurant, item) order. With prefix, the query must start a word.
+     * @param limit Maximum hits, 0 for all.
+     */
+    std::vector<Hit> search(const char16_t* query, size_t length, bool prefix, size_t limit) const {
+        std::string pattern;
+        appendNormalized(query, length, pattern);
+        if (pattern.size() <= 1) {
+            return {}; // Nothing searchable in the query
+        }
+        if (!prefix) {
+            pattern.erase(0, 1);
+        }
+
+        std::shared_lock<std::shared_mutex> lock(lock_);
+        std::vector<Hit> hits;
+        auto consider = [&](uint32_t id) {
+            const Document& doc = documents_[id];
+            if (!doc.live) return;
+            int32_t score = scoreOf(doc, pattern);
+            if (score > 0) {
+                hits.push_back(Hit{doc.restaurant, doc.item, score});
+            }
+        };
+        if (pattern.size() < 3) {
+            for (uint32_t id = 0; id < documents_.size(); id++) consider(id);
+        } else {
+            intersect(pattern, consider);
+        }
+
+        auto better = [](const Hit& a, const Hit& b) {
+            if (a.score != b.score) return a.score > b.score;
+            return a.restaurant != b.restaurant ? a.restaurant < b.restaurant : a.item < b.item;
+        };
+        if (limit > 0 && hits.size() > limit) {
+            std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(limit), hits.end(), better);
+            hits.resize(limit);
+        } else {
+            std::sort(hits.begin(), hits.end(), better);
+        }
+        return hits;
+    }
+
+    size_t documentCount() const {
+        std::shared_lock<std::shared_mutex> lock(lock_);
+        return documents_.size() - dead_;
+    }
+
+    size_t trigramCount() const {
+        std::shared_lock<std::shared_mutex> lock(lock_);
+        return postings_.size();
+    }
+
+    size_t memoryBytes() const {
+        std::shared_lock<std::shared_mutex> lock(lock_);
+        size_t bytes = text_.capacity() + documents_.capacity() * sizeof(Document);
+        for (const auto& [trigram, list] : postings_) {
+            bytes += sizeof(trigram) + sizeof(list) + list.memoryBytes();
+        }
+        return bytes;
+    }
+
+private:
+    struct Document {
+        uint32_t restaurant;
+        uint32_t item;
+        uint32_t nameOffset; // Normalized text in text_
+        uint32_t nameLength;
+        uint32_t descriptionOffset;
+        uint32_t descriptionLength;
+        bool live;
+    };
+
+    mutable std::shared_mutex lock_;
+    std::vector<Document> documents_;
+    std::string text_;
+    std::unordered_map<uint32_t, PostingList> postings_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> restaurantDocuments_;
+    size_t dead_ = 0;
+    std::vector<uint32_t> trigramScratch_;
+
+    static uint32_t trigramAt(std::string_view text, size_t i) {
+        return static_cast<uint32_t>(static_cast<uint8_t>(text[i])) << 16 |
+               static_cast<uint32_t>(static_cast<uint8_t>(text[i + 1])) << 8 |
+               static_cast<uint32_t>(static_cast<uint8_t>(text[i + 2]));
+    }
+
+    static void collectTrigrams(std::string_view text, std::vector<uint32_t>& out) {
+        for (size_t i = 0; i + 3 <= text.size(); i++) {
+            out.push_back(trigramAt(text, i));
+        }
+    }
+
+    std::string_view name(const Document& doc) const {
+        return std::string_view(text_).substr(doc.nameOffset, doc.nameLength);
+    }
+
+    std::string_view description(const Document& doc) const {
+        return std::string_view(text_).substr(doc.descriptionOffset, doc.descriptionLength);
+    }
+
+    void addDocument(const Document& doc) {
+        auto id = static_cast<uint32_t>(documents_.size());
+        documents_.push_back(doc);
+        restaurantDocuments_[doc.restaurant].push_back(id);
+        trigramScratch_.clear();
+        collectTrigrams(name(doc), trigramScratch_);
+        collectTrigrams(description(doc), trigramScratch_);
+        std::sort(trigramScratch_.begin(), trigramScratch_.end());
+        trigramScratch_.erase(std::unique(trigramScratch_.begin(), trigramScratch_.end()), trigramScratch_.end());
+        for (uint32_t trigram : trigramScratch_) {
+            postings_[trigram].append(id);
+        }
+    }
+
+    void removeDocuments(uint32_t restaurant) {
+        auto found = restaurantDocuments_.find(restaurant);
+        if (found == restaurantDocuments_.end()) {
+            return;
+        }
+        for (uint32_t id : found->second) {
+            documents_[id].live = false;
+        }
+        dead_ += found->second.size();
+        restaurantDocuments_.erase(found);
+    }
+
+    // Renumbers the live documents densely and re-encodes every posting list without the dead ones
+    void compact() {
+        std::vector<Document> live;
+        live.reserve(documents_.size() - dead_);
+        std::string text;
+        for (const Document& doc : documents_) {
+            if (!doc.live) continue;
+            Document moved = doc;
+            moved.nameOffset = static_cast<uint32_t>(text.size());
+            text.append(name(doc));
+            moved.descriptionOffset = static_cast<uint32_t>(text.size());
+            text.append(description(doc));
+            live.push_back(moved);
+        }
+        documents_.clear();
+        text_ = std::move(text);
+        postings_.clear();
+        restaurantDocuments_.clear();
+        dead_ = 0;
+        for (const Document& doc : live) {
+            addDocument(doc);
+        }
+    }
+
+    /**
+     * Calls candidate(id) for every document holding all trigrams of pattern, ascending, by intersecting
+     * their posting lists shortest first.
+     */
+    template <typename Candidate>
+    void intersect(std::string_view pattern, Candidate&& candidate) const {
+        std::vector<uint32_t> trigrams;
+        collectTrigrams(pattern, trigrams);
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+        std::vector<const PostingList*> lists;
+        for (uint32_t trigram : trigrams) {
+            auto found = postings_.find(trigram);
+            if (found == postings_.end()) {
+                return; // Some trigram occurs nowhere
+            }
+            lists.push_back(&found->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const PostingList* a, const PostingList* b) {
+            return a->size() < b->size();
+        });
+
+        std::vector<PostingCursor> cursors;
+        cursors.reserve(lists.size());
+        for (const PostingList* list : lists) {
+            cursors.emplace_back(*list);
+        }
+        PostingCursor& lead = cursors[0];
+        while (!lead.done()) {
+            uint32_t target = lead.doc();
+            bool all = true;
+            for (size_t i = 1; i < cursors.size(); i++) {
+                cursors[i].seek(target);
+                if (cursors[i].done()) {
+                    return;
+                }
+                if (cursors[i].doc() != target) {
+                    lead.seek(cursors[i].doc());
+                    all = false;
+                    break;
+                }
+            }
+            if (all) {
+                candidate(target);
+                lead.next();
+            }
+        }
+    }
+
+    // Larger is better, 0 for no match
+    int32_t scoreOf(const Document& doc, std::string_view pattern) const {
+        std::string_view docName = name(doc);
+        size_t position = docName.find(pattern);
+        if (position != std::string_view::npos) {
+            int32_t score = 1000 - static_cast<int32_t>(std::min<size_t>(position, 100));
+            bool wordStart = pattern.front() == ' ' || docName[position - 1] == ' ';
+            if (wordStart) score += 200;
+            if (docName.size() - 1 == pattern.size() || docName.size() == pattern.size()) score += 500; // Whole name
+            return score;
+        }
+        std::string_view docDescription = description(doc);
+        position = docDescription.find(pattern);
+        if (position != std::string_view::npos) {
+            int32_t score = 200 - static_cast<int32_t>(std::min<size_t>(position, 100));
+            bool wordStart = pattern.front() == ' ' || docDescription[position - 1] == ' ';
+            return wordStart ? score + 50 : score;
+        }
+        return 0;
+    }
+};
+
+} // namespace search
+
+#endif // ANDROID_SDK_TRIGRAMINDEX_H
@@ -0,0 +1,195 @@
+#ifndef ANDROID_SDK_UTF16TOUTF8_H
+#define ANDROID_SDK_UTF16TOUTF8_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define UTF16_KERNEL_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define UTF16_KERNEL_NEON 1
+#endif
+
+/**
+ * Single-pass UTF-16 -> standard UTF-8 transcoder, optionally JSON-escaping at the same time.
+ *
+ * Runs of 8 code units that are plain ASCII (and, when escaping, contain no '"', '\\' or control
+ * characters) are narrowed with SSE2 on x86 or NEON on ARM; everything else takes the scalar path.
+ * Surrogate pairs become 4-byte sequences (not CESU-8 like GetStringUTFChars); unpaired surrogates
+ * become U+FFFD.
+ */
+namespace utf16 {
+
+/**
+ * Upper bound of the bytes transcode() writes for length code units ("\u001f" is 6 bytes).
+ */
+constexpr size_t maxUtf8Length(size_t length, bool jsonEscape) {
+    return length * (jsonEscape ? 6 : 3);
+}
+
+namespace detail {
+
+// Second character of the two-character escape, 'u' for \u00XX, 0 when no escape is needed
+struct EscapeTable {
+    char entries[128];
+
+    constexpr EscapeTable() : entries() {
+        for (int c = 0; c < 0x20; c++) entries[c] = 'u';
+        entries['\b'] = 'b';
+        entries['\f'] = 'f';
+        entries['\n'] = 'n';
+        entries['\r'] = 'r';
+        entries['\t'] = 't';
+        entries['"'] = '"';
+        entries['\\'] = '\\';
+    }
+};
+
+inline constexpr EscapeTable kEscapes{};
+inline constexpr char kHexDigits[] = "0123456789abcdef";
+
+/**
+ * @return How many leading code units of src[0..length) can be copied as single bytes (multiple of 8).
+ */
+template <bool JsonEscape>
+inline size_t copyAsciiRun(const char16_t* src, size_t length, char* out) {
+    size_t i = 0;
+#if defined(UTF16_KERNEL_SSE2)
+    const __m128i nonAsciiBits = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= length; i += 8) {
+        __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i special = _mm_cmpeq_epi16(_mm_and_si128(units, nonAsciiBits), zero); // 0xFFFF where ASCII
+        if (JsonEscape) {
+            // Lanes are ASCII (non-negative) wherever it matters, so signed compares are safe
+            __m128i needsEscape = _mm_or_si128(
+                    _mm_cmplt_epi16(units, _mm_set1_epi16(0x20)),
+                    _mm_or_si128(_mm_cmpeq_epi16(units, _mm_set1_epi16('"')),
+                                 _mm_cmpeq_epi16(units, _mm_set1_epi16('\\'))));
+            special = _mm_andnot_si128(needsEscape, special);
+        }
+        if (_mm_movemask_epi8(special) != 0xFFFF) break;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(units, units));
+    }
+#elif defined(UTF16_KERNEL_NEON)
+    for (; i + 8 <= length; i += 8) {
+        uint16x8_t units = vld1q_u16(reinterpret_cast<const uint16_t*>(src + i));
+        uint16x8_t special = vcgeq_u16(units, vdupq_n_u16(0x80));
+        if (JsonEscape) {
+            special = vorrq_u16(special, vcltq_u16(units, vdupq_n_u16(0x20)));
+            special = vorrq_u16(special, vceqq_u16(units, vdupq_n_u16('"')));
+            special = vorrq_u16(special, vceqq_u16(units, vdupq_n_u16('\\')));
+        }
+        uint64x2_t lanes = vreinterpretq_u64_u16(special);
+        if ((vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) != 0) break;
+        vst1_u8(reinterpret_cast<uint8_t*>(out + i), vmovn_u16(units));
+    }
+#else
+    (void)src;
+    (void)length;
+    (void)out;
+#endif
+    return i;
+}
+
+} // namespace detail
+
+/**
+ * Transcodes src[0..length) into out, which must hold maxUtf8Length(length, JsonEscape) bytes.
+ * No quotes are added.
+ * @return The number of bytes written.
+ */
+template <bool JsonEscape>
+inline size_t transcode(const char16_t* src, size_t length, char* out) {
+    char* start = out;
+    size_t i = 0;
+    while (i < length) {
+        size_t run = detail::copyAsciiRun<JsonEscape>(src + i, length - i, out);
+        i += run;
+        out += run;
+
+        // Scalar path: at least one code unit, then back to the vector loop
+        size_t stop = i + 8 < length ? i + 8 : length;
+        while (i < stop) {
+            uint32_t c = src[i++];
+            if (c < 0x80) {
+                char escape = JsonEscape ? detail::kEscapes.entries[c] : 0;
+                if (!escape) {
+                    *out++ = static_cast<char>(c);
+                } else if (escape != 'u') {
+                    out[0] = '\\';
+                    out[1] = escape;
+                    out += 2;
+                } else {
+                    out[0] = '\\';
+                    out[1] = 'u';
+                    out[2] = '0';
+                    out[3] = '0';
+                    out[4] = detail::kHexDigits[c >> 4];
+                    out[5] = detail::kHexDigits[c & 0xF];
+                    out += 6;
+                }
+            } else if (c < 0x800) {
+                out[0] = static_cast<char>(0xC0 | (c >> 6));
+                out[1] = static_cast<char>(0x80 | (c & 0x3F));
+                out += 2;
+            } else if (c >= 0xD800 && c <= 0xDFFF) {
+                if (c <= 0xDBFF && i < length && src[i] >= 0xDC00 && src[i] <= 0xDFFF) {
+                    uint32_t codePoint = 0x10000 + ((c - 0xD800) << 10) + (src[i++] - 0xDC00);
+                    out[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+                    out[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                    out[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                    out[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+                    out += 4;
+                    if (stop < i) stop = i;
+                } else {
+                    // Unpaired surrogate: U+FFFD REPLACEMENT CHARACTER
+                    out[0] = static_cast<char>(0xEF);
+                    out[1] = static_cast<char>(0xBF);
+                    out[2] = static_cast<char>(0xBD);
+                    out += 3;
+                }
+            } else {
+                out[0] = static_cast<char>(0xE0 | (c >> 12));
+                out[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                out[2] = static_cast<char>(0x80 | (c & 0x3F));
+                out += 3;
+            }
+        }
+    }
+    return static_cast<size_t>(out - start);
+}
+
+/**
+ * JSON-escapes UTF-8 text into out, which must hold 6 * length bytes.
+ * @return The number of bytes written.
+ */
+inline size_t escapeUtf8(const char* src, size_t length, char* out) {
+    char* start = out;
+    for (size_t i = 0; i < length; i++) {
+        auto c = static_cast<unsigned char>(src[i]);
+        char escape = c < 0x80 ? detail::kEscapes.entries[c] : 0;
+        if (!escape) {
+            *out++ = static_cast<char>(c);
+        } else if (escape != 'u') {
+            out[0] = '\\';
+            out[1] = escape;
+            out += 2;
+        } else {
+            out[0] = '\\';
+            out[1] = 'u';
+            out[2] = '0';
+            out[3] = '0';
+            out[4] = detail::kHexDigits[c >> 4];
+            out[5] = detail::kHexDigits[c & 0xF];
+            out += 6;
+        }
+    }
+    return static_cast<size_t>(out - start);
+}
+
+} // namespace utf16
+
+#endif // ANDROID_SDK_UTF16TOUTF8_H
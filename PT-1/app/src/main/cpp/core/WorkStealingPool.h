@@ -0,0 +1,216 @@
+#ifndef ANDROID_SDK_WORKSTEALINGPOOL_H
+#define ANDROID_SDK_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class TaskGroup
+ * @brief Counts the outstanding tasks of one batch so its submitter can wait for exactly those, and keeps the
+ * first exception one of them threw.
+ */
+class TaskGroup {
+public:
+    void add() {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void done() {
+        // Under the mutex, so a waiter that saw the count reach zero cannot destroy the group mid-notify
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            finished_.notify_all();
+        }
+    }
+
+    bool finished() const {
+        return pending_.load(std::memory_order_acquire) == 0;
+    }
+
+    size_t pending() const {
+        return pending_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Records the exception of a failed task; later ones of the same batch are dropped.
+     */
+    void fail(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+            error_ = std::move(error);
+        }
+    }
+
+private:
+    friend class WorkStealingPool;
+
+    std::atomic<size_t> pending_{0};
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    std::exception_ptr error_;
+};
+
+/**
+ * @class WorkStealingPool
+ * @brief Fixed set of worker threads, each with its own task deque.
+ *
+ * Submitted tasks are dealt round-robin onto the workers' deques. A worker runs its own tasks newest first
+ * and, when it runs out, steals the oldest task of another worker, so uneven tasks (a restaurant with a
+ * 100k-item menu next to ordinary ones) do not leave cores idle. The deques are short and only touched
+ * once per task, so each is guarded by a plain mutex.
+ *
+ * Workers never attach to the JVM: tasks must not make JNI calls. A task that throws does not take its thread
+ * down: the exception is stored in its TaskGroup, the group's other tasks still run, and wait() rethrows it on
+ * the waiting thread.
+ */
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threadCount) : queues_(threadCount) {
+        for (auto& queue : queues_) {
+            queue = std::make_unique<Queue>();
+        }
+        threads_.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++) {
+            threads_.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * Finishes every queued task, then joins the workers.
+     */
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    size_t threadCount() const {
+        return threads_.size();
+    }
+
+    /**
+     * Queues task as part of group; group must outlive it.
+     */
+    void submit(TaskGroup& group, std::function<void()> task) {
+        group.add();
+        size_t target = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        {
+            std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+            queues_[target]->tasks.push_back(Task{&group, std::move(task)});
+        }
+        queued_.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+        }
+        wake_.notify_one();
+    }
+
+    /**
+     * Runs one queued task (of any group) on the calling thread.
+     * @return false if every deque was empty.
+     */
+    bool helpOne() {
+        return runOne(nextQueue_.load(std::memory_order_relaxed) % queues_.size(), false);
+    }
+
+    /**
+     * Blocks until every task of group has run, running queued tasks on the calling thread meanwhile.
+     * Then rethrows the first exception a task of group threw, if any.
+     */
+    void wait(TaskGroup& group) {
+        while (!group.finished()) {
+            if (!helpOne()) {
+                std::unique_lock<std::mutex> lock(group.mutex_);
+                group.finished_.wait(lock, [&] { return group.finished(); });
+            }
+        }
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(group.mutex_); // Let the last done() return first
+            error = group.error_;
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    struct Task {
+        TaskGroup* group = nullptr;
+        std::function<void()> run;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> nextQueue_{0};
+    std::atomic<size_t> queued_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    /**
+     * Pops from queue self's back (LIFO, still warm in cache), else steals from another queue's front.
+     */
+    bool runOne(size_t self, bool ownBack) {
+        Task task;
+        bool found = false;
+        for (size_t i = 0; i < queues_.size() && !found; i++) {
+            Queue& queue = *queues_[(self + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            if (i == 0 && ownBack) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            found = true;
+        }
+        if (!found) {
+            return false;
+        }
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        try {
+            task.run();
+        } catch (...) {
+            task.group->fail(std::current_exception());
+        }
+        task.group->done();
+        return true;
+    }
+
+    void workerLoop(size_t self) {
+        for (;;) {
+            if (runOne(self, true)) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wake_.wait(lock, [&] { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+            if (stopping_ && queued_.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+};
+
+#endif // ANDROID_SDK_WORKSTEALINGPOOL_H
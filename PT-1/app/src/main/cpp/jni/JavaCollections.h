@@ -0,0 +1,359 @@
+#ifndef ANDROID_SDK_JAVACOLLECTIONS_H
+#define ANDROID_SDK_JAVACOLLECTIONS_H
+
+#include <jni.h>
+#include <stdexcept>
+#include <vector>
+#include "../core/NativeStats.h"
+
+#if defined(__ANDROID__)
+#include <android/log.h>
+#endif
+
+/**
+ * @class JavaCollections
+ * @brief Class, method and field IDs for java.util collections, resolved once in JNI_OnLoad.
+ *
+ * Used by JavaObjectList and JavaMapEntries; call init() before either of them.
+ */
+class JavaCollections {
+private:
+    inline static jclass collectionClass;
+    inline static jclass arrayListClass;
+    inline static jclass arraysArrayListClass;
+    inline static jclass stringClass;
+    inline static jclass arraysClass;
+
+    inline static jmethodID collectionSizeMethodId;
+    inline static jmethodID collectionToArrayMethodId;
+    inline static jmethodID mapEntrySetMethodId;
+    inline static jmethodID mapEntryGetKeyMethodId;
+    inline static jmethodID mapEntryGetValueMethodId;
+    inline static jmethodID arraysAsListMethodId;
+    inline static jmethodID stringFromBytesMethodId;
+    inline static jobject utf8Charset;
+
+    // Backing storage of the common List implementations, for the no-copy fast path. These are private libcore
+    // fields, i.e. non-SDK interfaces (hidden API): any Android release may restrict them, and the runtime then
+    // denies GetFieldID with NoSuchFieldError. verifyListFastPath() drops all three unless reading them works.
+    inline static jfieldID arrayListElementDataFieldId;
+    inline static jfieldID arrayListSizeFieldId;
+    inline static jfieldID arraysArrayListArrayFieldId;
+
+    static jclass findGlobalClass(JNIEnv* env, const char* name) {
+        jclass localClass = env->FindClass(name);
+        if (!localClass) {
+            env->ExceptionClear();
+            return nullptr;
+        }
+        auto globalClass = static_cast<jclass>(env->NewGlobalRef(localClass));
+        env->DeleteLocalRef(localClass);
+        return globalClass;
+    }
+
+    static jfieldID findField(JNIEnv* env, jclass clazz, const char* name, const char* type) {
+        if (!clazz) return nullptr;
+        jfieldID fieldId = env->GetFieldID(clazz, name, type);
+        if (!fieldId) {
+            env->ExceptionClear(); // The fast path is optional
+        }
+        return fieldId;
+    }
+
+    // Reads a probe list of each kind through the fast path fields and compares with what was put in. On any
+    // failure the fields are cleared, so every list takes the toArray() path, and one warning is logged.
+    static void verifyListFastPath(JNIEnv* env) {
+        bool verified = false;
+        jclass objectClass = env->FindClass("java/lang/Object");
+        jmethodID arrayListConstructorId = objectClass && arrayListClass
+                ? env->GetMethodID(arrayListClass, "<init>", "(Ljava/util/Collection;)V") : nullptr;
+        // The element is only compared by identity; any object does
+        jobjectArray elements = arrayListConstructorId ? env->NewObjectArray(1, objectClass, stringClass) : nullptr;
+        jobject fixedList = elements ? newList(env, elements) : nullptr;
+        jobject arrayList = fixedList ? env->NewObject(arrayListClass, arrayListConstructorId, fixedList) : nullptr;
+        if (arrayList && arrayListElementDataFieldId && arrayListSizeFieldId && arraysArrayListArrayFieldId &&
+            isExactly(env, fixedList, arraysArrayListClass) && isExactly(env, arrayList, arrayListClass)) {
+            jobject backing = env->GetObjectField(fixedList, arraysArrayListArrayFieldId);
+            auto copy = static_cast<jobjectArray>(env->GetObjectField(arrayList, arrayListElementDataFieldId));
+            jint size = env->GetIntField(arrayList, arrayListSizeFieldId);
+            jobject element = copy && !env->ExceptionCheck() ? env->GetObjectArrayElement(copy, 0) : nullptr;
+            verified = !env->ExceptionCheck() && env->IsSameObject(backing, elements) && size == 1 &&
+                       env->IsSameObject(element, stringClass);
+            env->DeleteLocalRef(element);
+            env->DeleteLocalRef(copy);
+            env->DeleteLocalRef(backing);
+        }
+        env->ExceptionClear();
+        env->DeleteLocalRef(arrayList);
+        env->DeleteLocalRef(fixedList);
+        env->DeleteLocalRef(elements);
+        env->DeleteLocalRef(objectClass);
+
+        if (!verified) {
+            arrayListElementDataFieldId = nullptr;
+            arrayListSizeFieldId = nullptr;
+            arraysArrayListArrayFieldId = nullptr;
+#if defined(__ANDROID__)
+            __android_log_print(ANDROID_LOG_WARN, "RestaurantNative",
+                                "List backing fields are not accessible; lists are read through toArray()");
+#endif
+        }
+    }
+
+    static bool isExactly(JNIEnv* env, jobject obj, jclass clazz) {
+        if (!clazz) return false;
+        NATIVE_STATS_JNI(nativestats::JniCall::ListRead, 3);
+        jclass objClass = env->GetObjectClass(obj);
+        bool same = env->IsSameObject(objClass, clazz);
+        env->DeleteLocalRef(objClass);
+        return same;
+    }
+
+    friend class JavaObjectList;
+    friend class JavaMapEntries;
+
+public:
+    static bool init(JNIEnv* env) {
+        if (!env) return false;
+
+        collectionClass = findGlobalClass(env, "java/util/Collection");
+        jclass mapClass = env->FindClass("java/util/Map");
+        jclass mapEntryClass = env->FindClass("java/util/Map$Entry");
+        if (!collectionClass || !mapClass || !mapEntryClass) {
+            return false;
+        }
+
+        collectionSizeMethodId    = env->GetMethodID(collectionClass, "size", "()I");
+        collectionToArrayMethodId = env->GetMethodID(collectionClass, "toArray", "()[Ljava/lang/Object;");
+        mapEntrySetMethodId       = env->GetMethodID(mapClass, "entrySet", "()Ljava/util/Set;");
+        mapEntryGetKeyMethodId    = env->GetMethodID(mapEntryClass, "getKey", "()Ljava/lang/Object;");
+        mapEntryGetValueMethodId  = env->GetMethodID(mapEntryClass, "getValue", "()Ljava/lang/Object;");
+        env->DeleteLocalRef(mapClass);
+        env->DeleteLocalRef(mapEntryClass);
+
+        if (!collectionSizeMethodId || !collectionToArrayMethodId || !mapEntrySetMethodId ||
+            !mapEntryGetKeyMethodId || !mapEntryGetValueMethodId) {
+            return false;
+        }
+
+        // For building lists in one call from a filled array
+        stringClass = findGlobalClass(env, "java/lang/String");
+        arraysClass = findGlobalClass(env, "java/util/Arrays");
+        if (!stringClass || !arraysClass) {
+            return false;
+        }
+        arraysAsListMethodId = env->GetStaticMethodID(arraysClass, "asList", "([Ljava/lang/Object;)Ljava/util/List;");
+        if (!arraysAsListMethodId) {
+            return false;
+        }
+
+        // For Strings from UTF-8 that NewStringUTF cannot take (newJavaStringFromUtf8)
+        stringFromBytesMethodId = env->GetMethodID(stringClass, "<init>", "([BLjava/nio/charset/Charset;)V");
+        jclass charsetsClass = env->FindClass("java/nio/charset/StandardCharsets");
+        if (!stringFromBytesMethodId || !charsetsClass) {
+            return false;
+        }
+        jfieldID utf8FieldId = env->GetStaticFieldID(charsetsClass, "UTF_8", "Ljava/nio/charset/Charset;");
+        jobject utf8 = utf8FieldId ? env->GetStaticObjectField(charsetsClass, utf8FieldId) : nullptr;
+        utf8Charset = utf8 ? env->NewGlobalRef(utf8) : nullptr;
+        env->DeleteLocalRef(utf8);
+        env->DeleteLocalRef(charsetsClass);
+        if (!utf8Charset) {
+            return false;
+        }
+
+        // ArrayList (also Kotlin's mutableListOf / List(n) { }) and Arrays$ArrayList (Kotlin's listOf(a, b, ...))
+        arrayListClass              = findGlobalClass(env, "java/util/ArrayList");
+        arrayListElementDataFieldId = findField(env, arrayListClass, "elementData", "[Ljava/lang/Object;");
+        arrayListSizeFieldId        = findField(env, arrayListClass, "size", "I");
+        arraysArrayListClass        = findGlobalClass(env, "java/util/Arrays$ArrayList");
+        arraysArrayListArrayFieldId = findField(env, arraysArrayListClass, "a", "[Ljava/lang/Object;");
+        verifyListFastPath(env);
+
+        return true;
+    }
+
+    /**
+     * Switch for the backing-array fast path of JavaObjectList, to benchmark it and test the toArray() path.
+     * Has no effect once init() found the fields inaccessible.
+     */
+    inline static bool listFastPathEnabled = true;
+
+    /**
+     * @return collection.size(), or 0 for null.
+     */
+    static jint size(JNIEnv* env, jobject collection) {
+        return collection ? env->CallIntMethod(collection, collectionSizeMethodId) : 0;
+    }
+
+    static jclass javaStringClass() {
+        return stringClass;
+    }
+
+    /**
+     * @return A new local reference to new String(utf8Bytes, StandardCharsets.UTF_8), or null with an exception
+     *         pending.
+     */
+    static jstring newStringFromUtf8Bytes(JNIEnv* env, jbyteArray utf8Bytes) {
+        return static_cast<jstring>(env->NewObject(stringClass, stringFromBytesMethodId, utf8Bytes, utf8Charset));
+    }
+
+    /**
+     * @return A new local reference to Arrays.asList(elements): a fixed-size List backed by the array,
+     *         which JavaObjectList reads back without a copy.
+     */
+    static jobject newList(JNIEnv* env, jobjectArray elements) {
+        return env->CallStaticObjectMethod(arraysClass, arraysAsListMethodId, elements);
+    }
+};
+
+/**
+ * @class JavaObjectList
+ * @brief Indexed, read-only view of a java.util.Collection (List, Set, ...) through one object array.
+ *
+ * Construction fetches all elements in one go: ArrayList and Arrays$ArrayList expose their backing
+ * array directly (no copy), anything else goes through a single Collection.toArray() call. The backing arrays
+ * are hidden-API fields; when the runtime denies them (see JavaCollections::init), every list uses toArray().
+ * get() is then a plain GetObjectArrayElement instead of an interface dispatch of List.get(i).
+ *
+ * Usage:
+ *   JavaObjectList menu(env, menuList);
+ *   for (jint i = 0; i < menu.size(); i++) {
+ *       jobject item = menu.get(env, i); // new local reference
+ *   }
+ */
+class JavaObjectList {
+public:
+    JavaObjectList(JNIEnv* env, jobject collection) : env_(env), array_(nullptr), size_(0) {
+        if (!env) {
+            throw std::runtime_error("Invalid constructor arguments for JavaObjectList.");
+        }
+        if (!collection) {
+            return;
+        }
+
+        bool fastPath = JavaCollections::listFastPathEnabled;
+        if (fastPath && JavaCollections::arrayListElementDataFieldId && JavaCollections::arrayListSizeFieldId &&
+            JavaCollections::isExactly(env, collection, JavaCollections::arrayListClass)) {
+            // elementData may be longer than the list; size bounds the valid prefix
+            array_ = (jobjectArray)env->GetObjectField(collection, JavaCollections::arrayListElementDataFieldId);
+            size_ = env->GetIntField(collection, JavaCollections::arrayListSizeFieldId);
+        } else if (fastPath && JavaCollections::arraysArrayListArrayFieldId &&
+                   JavaCollections::isExactly(env, collection, JavaCollections::arraysArrayListClass)) {
+            array_ = (jobjectArray)env->GetObjectField(collection, JavaCollections::arraysArrayListArrayFieldId);
+            size_ = array_ ? env->GetArrayLength(array_) : 0;
+        } else {
+            array_ = (jobjectArray)env->CallObjectMethod(collection, JavaCollections::collectionToArrayMethodId);
+            size_ = array_ ? env->GetArrayLength(array_) : 0;
+        }
+        NATIVE_STATS_JNI(nativestats::JniCall::ListRead, 2); // The array and the size
+        NATIVE_STATS_LOCAL_REF(array_);
+    }
+
+    JavaObjectList(const JavaObjectList&) = delete;
+    JavaObjectList& operator=(const JavaObjectList&) = delete;
+
+    ~JavaObjectList() {
+        if (array_) {
+            NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+            env_->DeleteLocalRef(array_);
+            NATIVE_STATS_LOCAL_REF_DELETED();
+        }
+    }
+
+    jint size() const {
+        return size_;
+    }
+
+    /**
+     * @return A new local reference to the element at index; the caller releases it.
+     */
+    jobject get(JNIEnv* env, jint index) const {
+        NATIVE_STATS_JNI(nativestats::JniCall::ListRead, 1);
+        jobject element = env->GetObjectArrayElement(array_, index);
+        NATIVE_STATS_LOCAL_REF(element);
+        return element;
+    }
+
+private:
+    JNIEnv* env_;
+    jobjectArray array_;
+    jint size_;
+};
+
+/**
+ * @class JavaMapEntries
+ * @brief Indexed view of a java.util.Map's entries, fetched through one entrySet().toArray() call.
+ */
+class JavaMapEntries {
+public:
+    JavaMapEntries(JNIEnv* env, jobject map)
+            : env_(env),
+              entrySet_(map ? env->CallObjectMethod(map, JavaCollections::mapEntrySetMethodId) : nullptr),
+              entries_(env, entrySet_) {}
+
+    JavaMapEntries(const JavaMapEntries&) = delete;
+    JavaMapEntries& operator=(const JavaMapEntries&) = delete;
+
+    ~JavaMapEntries() {
+        if (entrySet_) {
+            env_->DeleteLocalRef(entrySet_);
+        }
+    }
+
+    jint size() const {
+        return entries_.size();
+    }
+
+    /**
+     * @return New local references to the key and value of the entry at index.
+     */
+    void get(JNIEnv* env, jint index, jobject& key, jobject& value) const {
+        jobject entry = entries_.get(env, index);
+        key = env->CallObjectMethod(entry, JavaCollections::mapEntryGetKeyMethodId);
+        value = env->CallObjectMethod(entry, JavaCollections::mapEntryGetValueMethodId);
+        env->DeleteLocalRef(entry);
+        NATIVE_STATS_LOCAL_REF_DELETED();
+    }
+
+private:
+    JNIEnv* env_;
+    jobject entrySet_;
+    JavaObjectList entries_;
+};
+
+/**
+ * Copies a Java primitive array (int[], long[], double[], ...) into a std::vector in one call.
+ * A null array reads as empty.
+ */
+inline std::vector<jint> readJavaArray(JNIEnv* env, jintArray array) {
+    std::vector<jint> values(array ? env->GetArrayLength(array) : 0);
+    if (!values.empty()) env->GetIntArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+    return values;
+}
+
+inline std::vector<jlong> readJavaArray(JNIEnv* env, jlongArray array) {
+    std::vector<jlong> values(array ? env->GetArrayLength(array) : 0);
+    if (!values.empty()) env->GetLongArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+    return values;
+}
+
+inline std::vector<jdouble> readJavaArray(JNIEnv* env, jdoubleArray array) {
+    std::vector<jdouble> values(array ? env->GetArrayLength(array) : 0);
+    if (!values.empty()) env->GetDoubleArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+    return values;
+}
+
+inline std::vector<jfloat> readJavaArray(JNIEnv* env, jfloatArray array) {
+    std::vector<jfloat> values(array ? env->GetArrayLength(array) : 0);
+    if (!values.empty()) env->GetFloatArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+    return values;
+}
+
+inline std::vector<jboolean> readJavaArray(JNIEnv* env, jbooleanArray array) {
+    std::vector<jboolean> values(array ? env->GetArrayLength(array) : 0);
+    if (!values.empty()) env->GetBooleanArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+    return values;
+}
+
+#endif // ANDROID_SDK_JAVACOLLECTIONS_H
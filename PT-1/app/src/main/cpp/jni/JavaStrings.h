@@ -0,0 +1,151 @@
+#ifndef ANDROID_SDK_JAVASTRINGS_H
+#define ANDROID_SDK_JAVASTRINGS_H
+
+#include <jni.h>
+#include <string>
+#include <string_view>
+#include "../core/JsonWriter.h"
+#include "../core/NativeStats.h"
+#include "../core/ScratchArena.h"
+#include "../core/Utf16ToUtf8.h"
+#include "JavaCollections.h"
+
+/**
+ * @class JavaStringChars
+ * @brief Borrowed view of a jstring's UTF-16 code units, without GetStringUTFChars' allocation
+ *        and modified-UTF-8 conversion.
+ *
+ * Short strings are copied into an inline buffer with one GetStringRegion call. Longer strings are
+ * pinned with GetStringCritical, so NO other JNI call may be made while a long-string view is alive.
+ */
+class JavaStringChars {
+public:
+    static constexpr jsize kInlineCapacity = 256;
+
+    JavaStringChars(JNIEnv* env, jstring javaStr)
+            : env_(env), javaStr_(javaStr), critical_(nullptr), length_(0) {
+        if (!javaStr) {
+            return;
+        }
+        NATIVE_STATS_PHASE(StringRead);
+        NATIVE_STATS_JNI(nativestats::JniCall::StringRead, 2);
+        length_ = env->GetStringLength(javaStr);
+        if (length_ <= kInlineCapacity) {
+            env->GetStringRegion(javaStr, 0, length_, inline_);
+        } else {
+            critical_ = env->GetStringCritical(javaStr, nullptr);
+        }
+    }
+
+    JavaStringChars(const JavaStringChars&) = delete;
+    JavaStringChars& operator=(const JavaStringChars&) = delete;
+
+    ~JavaStringChars() {
+        if (critical_) {
+            NATIVE_STATS_JNI(nativestats::JniCall::StringRead, 1);
+            env_->ReleaseStringCritical(javaStr_, critical_);
+        }
+    }
+
+    const char16_t* data() const {
+        return reinterpret_cast<const char16_t*>(critical_ ? critical_ : inline_);
+    }
+
+    size_t size() const {
+        return static_cast<size_t>(length_);
+    }
+
+private:
+    JNIEnv* env_;
+    jstring javaStr_;
+    const jchar* critical_;
+    jsize length_;
+    jchar inline_[kInlineCapacity];
+};
+
+/**
+ * Writes javaStr as a JSON string (null as ""), transcoding UTF-16 straight into the writer,
+ * then deletes javaStr's local reference.
+ */
+inline void writeJsonString(JNIEnv* env, JsonWriter& writer, jstring javaStr) {
+    {
+        JavaStringChars chars(env, javaStr);
+        writer.quotedUtf16(chars.data(), chars.size());
+    }
+    if (javaStr) {
+        env->DeleteLocalRef(javaStr);
+        NATIVE_STATS_LOCAL_REF_DELETED();
+    }
+}
+
+/**
+ * @return javaStr as standard UTF-8 (surrogate pairs as 4-byte sequences), or "" for null.
+ */
+inline std::string toUtf8String(JNIEnv* env, jstring javaStr) {
+    JavaStringChars chars(env, javaStr);
+    std::string result(utf16::maxUtf8Length(chars.size(), false), '\0');
+    result.resize(utf16::transcode<false>(chars.data(), chars.size(), &result[0]));
+    return result;
+}
+
+/**
+ * Transcodes javaStr to standard UTF-8 into out ("" for null), reusing out's capacity.
+ * @return A view of out.
+ */
+inline std::string_view assignUtf8(JNIEnv* env, jstring javaStr, std::string& out) {
+    JavaStringChars chars(env, javaStr);
+    out.resize(utf16::maxUtf8Length(chars.size(), false));
+    out.resize(utf16::transcode<false>(chars.data(), chars.size(), &out[0]));
+    return out;
+}
+
+/**
+ * Transcodes javaStr to standard UTF-8 in arena ("" for null), without a heap allocation once the arena is warm.
+ * @return A view valid until the arena's scope closes.
+ */
+inline std::string_view toScratchUtf8(JNIEnv* env, jstring javaStr, ScratchArena& arena = ScratchArena::current()) {
+    JavaStringChars chars(env, javaStr);
+    size_t capacity = utf16::maxUtf8Length(chars.size(), false);
+    char* out = arena.allocate(capacity, 1);
+    size_t length = utf16::transcode<false>(chars.data(), chars.size(), out);
+    arena.shrinkLast(out, capacity, length);
+    return std::string_view(out, length);
+}
+
+/**
+ * Creates a Java String from standard UTF-8.
+ * NewStringUTF expects modified UTF-8, which encodes supplementary characters (emoji) as surrogate
+ * pairs, so text containing 4-byte sequences is decoded through String(byte[], UTF_8) instead; the
+ * constructor and charset are cached by JavaCollections::init.
+ * @param utf8 NUL-terminated at utf8[length].
+ */
+inline jstring newJavaStringFromUtf8(JNIEnv* env, const char* utf8, size_t length) {
+    NATIVE_STATS_PHASE(ResultString);
+    bool hasSupplementary = false;
+    for (size_t i = 0; i < length; i++) {
+        if (static_cast<unsigned char>(utf8[i]) >= 0xF0) {
+            hasSupplementary = true;
+            break;
+        }
+    }
+    if (!hasSupplementary) {
+        NATIVE_STATS_JNI(nativestats::JniCall::StringCreation, 1);
+        jstring result = env->NewStringUTF(utf8);
+        NATIVE_STATS_LOCAL_REF(result);
+        return result;
+    }
+
+    NATIVE_STATS_JNI(nativestats::JniCall::StringCreation, 4);
+
+    jbyteArray bytes = env->NewByteArray(static_cast<jsize>(length));
+    if (!bytes) {
+        return nullptr; // OutOfMemoryError pending
+    }
+    env->SetByteArrayRegion(bytes, 0, static_cast<jsize>(length), reinterpret_cast<const jbyte*>(utf8));
+    jstring result = JavaCollections::newStringFromUtf8Bytes(env, bytes);
+    env->DeleteLocalRef(bytes);
+    NATIVE_STATS_LOCAL_REF(result);
+    return result;
+}
+
+#endif // ANDROID_SDK_JAVASTRINGS_H
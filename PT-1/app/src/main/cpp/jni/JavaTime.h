@@ -0,0 +1,100 @@
+#ifndef ANDROID_SDK_JAVATIME_H
+#define ANDROID_SDK_JAVATIME_H
+
+#include <jni.h>
+#include "../core/TemporalFormat.h"
+#include "shadowClasses/ShadowProperty.h"
+
+/**
+ * @class JavaTime
+ * @brief Primitive reads of java.time.DayOfWeek and java.time.LocalTime, resolved once in JNI_OnLoad.
+ *
+ * The enum ordinal and the LocalTime components are read through their backing fields
+ * (with getter fallback), so no toString() call or Java String is needed to format them.
+ * For decoding, the DayOfWeek constants are cached as global references and LocalTime.of is resolved once.
+ */
+class JavaTime {
+private:
+    // java.lang.Enum.ordinal and the java.time.LocalTime components
+    inline static ShadowProperty enumOrdinalProperty;
+    inline static ShadowProperty hourProperty;
+    inline static ShadowProperty minuteProperty;
+    inline static ShadowProperty secondProperty;
+    inline static ShadowProperty nanoProperty;
+
+    // DayOfWeek.values(), indexed by ordinal, and LocalTime.of(int, int, int, int)
+    inline static jobject dayOfWeekConstants[7];
+    inline static jclass localTimeClass;
+    inline static jmethodID localTimeOfMethodId;
+
+public:
+    static bool init(JNIEnv* env) {
+        if (!env) return false;
+
+        jclass enumClass = env->FindClass("java/lang/Enum");
+        jclass localTimeClass = env->FindClass("java/time/LocalTime");
+        if (!enumClass || !localTimeClass) {
+            return false;
+        }
+        enumOrdinalProperty.init(env, enumClass, "ordinal", "ordinal", "I");
+        hourProperty.init(env, localTimeClass, "hour", "B", "getHour", "I");
+        minuteProperty.init(env, localTimeClass, "minute", "B", "getMinute", "I");
+        secondProperty.init(env, localTimeClass, "second", "B", "getSecond", "I");
+        nanoProperty.init(env, localTimeClass, "nano", "I", "getNano", "I");
+        env->DeleteLocalRef(enumClass);
+
+        JavaTime::localTimeClass = static_cast<jclass>(env->NewGlobalRef(localTimeClass));
+        env->DeleteLocalRef(localTimeClass);
+        localTimeOfMethodId = env->GetStaticMethodID(JavaTime::localTimeClass, "of", "(IIII)Ljava/time/LocalTime;");
+
+        jclass dayOfWeekClass = env->FindClass("java/time/DayOfWeek");
+        if (!dayOfWeekClass) {
+            return false;
+        }
+        jmethodID valuesMethodId = env->GetStaticMethodID(dayOfWeekClass, "values", "()[Ljava/time/DayOfWeek;");
+        auto values = (jobjectArray)env->CallStaticObjectMethod(dayOfWeekClass, valuesMethodId);
+        for (jsize i = 0; i < 7; i++) {
+            jobject day = env->GetObjectArrayElement(values, i);
+            dayOfWeekConstants[i] = env->NewGlobalRef(day);
+            env->DeleteLocalRef(day);
+        }
+        env->DeleteLocalRef(values);
+        env->DeleteLocalRef(dayOfWeekClass);
+
+        return enumOrdinalProperty && hourProperty && minuteProperty && secondProperty && nanoProperty &&
+               localTimeOfMethodId;
+    }
+
+    /**
+     * @return dayOfWeek.ordinal() (MONDAY = 0), or -1 for null.
+     */
+    static jint readOrdinal(JNIEnv* env, jobject enumValue) {
+        return enumValue ? enumOrdinalProperty.readInt(env, enumValue) : -1;
+    }
+
+    static temporal::LocalTimeParts readLocalTime(JNIEnv* env, jobject localTime) {
+        temporal::LocalTimeParts time;
+        time.hour   = hourProperty.readInt(env, localTime);
+        time.minute = minuteProperty.readInt(env, localTime);
+        time.second = secondProperty.readInt(env, localTime);
+        time.nano   = nanoProperty.readInt(env, localTime);
+        return time;
+    }
+
+    /**
+     * @return The cached DayOfWeek constant (a global reference; do not delete it), or null if out of range.
+     */
+    static jobject dayOfWeek(jint ordinal) {
+        return ordinal >= 0 && ordinal < 7 ? dayOfWeekConstants[ordinal] : nullptr;
+    }
+
+    /**
+     * @return A new local reference to LocalTime.of(hour, minute, second, nano).
+     */
+    static jobject newLocalTime(JNIEnv* env, const temporal::LocalTimeParts& time) {
+        return env->CallStaticObjectMethod(localTimeClass, localTimeOfMethodId,
+                                           time.hour, time.minute, time.second, time.nano);
+    }
+};
+
+#endif // ANDROID_SDK_JAVATIME_H
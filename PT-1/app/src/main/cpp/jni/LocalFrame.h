@@ -0,0 +1,76 @@
+#ifndef ANDROID_SDK_LOCALFRAME_H
+#define ANDROID_SDK_LOCALFRAME_H
+
+#include <jni.h>
+#include <cstdint>
+#include "../core/NativeStats.h"
+
+/**
+ * @class LocalFrameChunker
+ * @brief Bounds the local references created by a loop over a Java collection.
+ *
+ * Every chunkSize iterations the current local frame is popped, releasing every local reference
+ * created inside it, and a fresh frame is pushed. The peak local-reference count therefore depends
+ * on chunkSize, not on the length of the list.
+ *
+ * Usage:
+ *   LocalFrameChunker frames(env);
+ *   for (int i = 0; i < count; i++) {
+ *       frames.next();
+ *       jobject elem = ...; // released at the latest when its chunk ends
+ *   }
+ *
+ * Nothing created inside the loop may be used after it ends, or across chunk boundaries.
+ */
+class LocalFrameChunker {
+public:
+    static constexpr jint kDefaultChunkSize = 64;
+
+    /**
+     * @param refsPerIteration Upper estimate of the local references one iteration creates.
+     */
+    explicit LocalFrameChunker(JNIEnv* env, jint chunkSize = kDefaultChunkSize, jint refsPerIteration = 8)
+            : env_(env), chunkSize_(chunkSize), capacity_(chunkSize * refsPerIteration), used_(0), open_(false) {}
+
+    LocalFrameChunker(const LocalFrameChunker&) = delete;
+    LocalFrameChunker& operator=(const LocalFrameChunker&) = delete;
+
+    /**
+     * Call at the start of every iteration.
+     */
+    void next() {
+        if (open_ && used_ < chunkSize_) {
+            used_++;
+            return;
+        }
+        if (open_) {
+            NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+            env_->PopLocalFrame(nullptr);
+            NATIVE_STATS_LOCAL_FRAME_POPPED(liveAtPush_);
+        }
+        NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+        open_ = env_->PushLocalFrame(capacity_) == JNI_OK;
+        if (open_) {
+            NATIVE_STATS_LOCAL_FRAME_PUSHED(liveAtPush_);
+        }
+        used_ = 1;
+    }
+
+    ~LocalFrameChunker() {
+        if (open_) {
+            NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+            env_->PopLocalFrame(nullptr);
+            NATIVE_STATS_LOCAL_FRAME_POPPED(liveAtPush_);
+        }
+    }
+
+private:
+    JNIEnv* env_;
+    jint chunkSize_;
+    jint capacity_;
+    jint used_;
+    bool open_;
+    int64_t liveAtPush_ = 0; // Instrumented builds: the counted live local references when the frame was pushed
+};
+
+#endif // ANDROID_SDK_LOCALFRAME_H
@@ -0,0 +1,158 @@
+#ifndef ANDROID_SDK_SERIALIZATIONEXECUTOR_H
+#define ANDROID_SDK_SERIALIZATIONEXECUTOR_H
+
+#include <jni.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "../core/NativeStats.h"
+
+/**
+ * @class SerializationExecutor
+ * @brief One native background thread, attached to the JVM, that runs jobs and completes CompletableFutures.
+ *
+ * Any Java thread may submit (multi-producer); the single executor thread consumes the bounded queue in
+ * submission order. A job runs on the executor thread with its JNIEnv and returns the result object; the
+ * executor then calls future.complete(result), or future.completeExceptionally(...) if the job left an
+ * exception pending. A future that is already done when its job comes up (cancelled by the caller) is
+ * skipped without running the job.
+ *
+ * The thread is started on the first submit and attached as a daemon, so it never keeps the VM alive. If it
+ * cannot attach, submit rejects the job rather than queueing it.
+ */
+class SerializationExecutor {
+public:
+    /**
+     * Runs on the executor thread; returns a local reference, or null with an exception pending.
+     */
+    using Job = std::function<jobject(JNIEnv*)>;
+
+    static constexpr size_t kQueueCapacity = 1024;
+
+    static bool init(JNIEnv* env, JavaVM* vm) {
+        if (!env || !vm) return false;
+        javaVm = vm;
+
+        jclass futureClass = env->FindClass("java/util/concurrent/CompletableFuture");
+        if (!futureClass) {
+            return false;
+        }
+        completeMethodId = env->GetMethodID(futureClass, "complete", "(Ljava/lang/Object;)Z");
+        completeExceptionallyMethodId = env->GetMethodID(futureClass, "completeExceptionally", "(Ljava/lang/Throwable;)Z");
+        isDoneMethodId = env->GetMethodID(futureClass, "isDone", "()Z");
+        env->DeleteLocalRef(futureClass);
+
+        return completeMethodId && completeExceptionallyMethodId && isDoneMethodId;
+    }
+
+    /**
+     * Queues job to complete future (a CompletableFuture).
+     * @return false if the queue is full or the executor thread could not attach to the JVM; the future is left
+     *         untouched.
+     */
+    static bool submit(JNIEnv* env, jobject future, Job job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (queue.size() >= kQueueCapacity || !ensureStarted(lock)) {
+            return false;
+        }
+        NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+        NATIVE_STATS_GLOBAL_REF();
+        queue.push_back(Task{env->NewGlobalRef(future), std::move(job)});
+        available.notify_one();
+        return true;
+    }
+
+private:
+    struct Task {
+        jobject future = nullptr; // Global reference
+        Job job;
+    };
+
+    inline static JavaVM* javaVm;
+    inline static jmethodID completeMethodId;
+    inline static jmethodID completeExceptionallyMethodId;
+    inline static jmethodID isDoneMethodId;
+
+    enum class State { Stopped, Starting, Running };
+
+    inline static std::mutex mutex;
+    inline static std::condition_variable available;
+    inline static std::deque<Task> queue;
+    inline static std::condition_variable stateChanged;
+    inline static State state = State::Stopped;
+
+    /**
+     * Starts the executor thread if it is not running and waits until it has attached. Only tasks accepted while
+     * it runs are queued, so a thread that fails to attach never leaves a future without a consumer; the next
+     * submit tries again.
+     */
+    static bool ensureStarted(std::unique_lock<std::mutex>& lock) {
+        if (state == State::Stopped) {
+            state = State::Starting;
+            std::thread(run).detach();
+        }
+        stateChanged.wait(lock, [] { return state != State::Starting; });
+        return state == State::Running;
+    }
+
+    static JNIEnv* attachCurrentThread() {
+        JNIEnv* env = nullptr;
+        JavaVMAttachArgs args{JNI_VERSION_1_6, "RestaurantSerializer", nullptr};
+#ifdef __ANDROID__
+        jint status = javaVm->AttachCurrentThreadAsDaemon(&env, &args);
+#else
+        jint status = javaVm->AttachCurrentThreadAsDaemon(reinterpret_cast<void**>(&env), &args);
+#endif
+        return status == JNI_OK ? env : nullptr;
+    }
+
+    static void run() {
+        JNIEnv* env = attachCurrentThread();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            state = env ? State::Running : State::Stopped;
+        }
+        stateChanged.notify_all();
+        if (!env) {
+            return;
+        }
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                available.wait(lock, [] { return !queue.empty(); });
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+            execute(env, task);
+            env->DeleteGlobalRef(task.future);
+        }
+    }
+
+    static void execute(JNIEnv* env, Task& task) {
+        if (env->CallBooleanMethod(task.future, isDoneMethodId)) {
+            return; // Cancelled (or completed) by the caller
+        }
+        jobject result = task.job(env);
+        jthrowable error = env->ExceptionOccurred();
+        if (error) {
+            env->ExceptionClear();
+            env->CallBooleanMethod(task.future, completeExceptionallyMethodId, error);
+            env->DeleteLocalRef(error);
+        } else {
+            env->CallBooleanMethod(task.future, completeMethodId, result);
+        }
+        if (result) {
+            env->DeleteLocalRef(result);
+        }
+        // Dependent stages run inside complete(); CompletableFuture captures their exceptions, but be safe
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+        }
+    }
+};
+
+#endif // ANDROID_SDK_SERIALIZATIONEXECUTOR_H
@@ -1,26 +1,712 @@
 #include <jni.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "shadowClasses/RestaurantShadow.h"
 #include "shadowClasses/AddressShadow.h"
 #include "shadowClasses/MenuItemShadow.h"
 #include "shadowClasses/OpeningHourShadow.h"
+#include "shadowClasses/ShadowProperty.h"
+#include "JavaTime.h"
+#include "JavaCollections.h"
+#include "JavaStrings.h"
+#include "SerializationExecutor.h"
+#include "../core/EventTape.h"
+#include "../core/FdWriter.h"
+#include "../core/JsonWriter.h"
+#include "../core/JsonReader.h"
+#include "../core/ModelDecoding.h"
+#include "../core/ModelProjection.h"
+#include "../core/NativeStats.h"
+#include "../core/OpeningHoursIndex.h"
+#include "../core/OutputFormat.h"
+#include "../core/RestaurantColumns.h"
+#include "../core/ScratchArena.h"
+#include "../core/SerializationCache.h"
+#include "../core/StringDictionary.h"
+#include "../core/TrigramIndex.h"
 
-extern std::string buildJsonFromRestaurant(JNIEnv *env, RestaurantShadow &restShadow);
+extern void writeJsonFromRestaurant(JNIEnv *env, RestaurantShadow &restShadow, JsonWriter &writer);
+extern void encodeRestaurant(JNIEnv *env, RestaurantShadow &restShadow, OutputFormat format, JsonWriter &out);
+extern void invalidateCachedRestaurant(const std::string &id);
+extern void writeRestaurantPatch(JNIEnv *env, RestaurantShadow &before, RestaurantShadow &after, JsonWriter &writer);
+extern jobject readRestaurantFromJson(JNIEnv *env, const char *json, size_t length);
+extern void writeJsonFromRestaurantList(JNIEnv *env, jobject restaurantList, bool ndjson, JsonWriter &writer);
+extern void encodeRestaurantList(JNIEnv *env, jobject restaurantList, OutputFormat format, JsonWriter &out);
+extern void setBatchThreadCount(size_t threads);
+extern void captureRestaurant(JNIEnv *env, RestaurantShadow &restShadow, EventTape &tape);
+extern void writeJsonFromCapture(const EventTape &tape, JsonWriter &writer);
+extern size_t exportRestaurantList(JNIEnv *env, jobject restaurantList, int fd, bool overlapIo);
+extern std::unique_ptr<projection::Selection> compileRestaurantProjection(const std::vector<std::string> &paths);
+extern void writeProjectedRestaurant(JNIEnv *env, RestaurantShadow &restShadow, const projection::Selection &selection,
+                                     JsonWriter &writer);
+extern void writeProjectedRestaurantList(JNIEnv *env, jobject restaurantList, const projection::Selection &selection,
+                                         bool ndjson, JsonWriter &writer);
+extern std::unique_ptr<columns::RestaurantColumns> loadRestaurantColumns(JNIEnv *env, jobject restaurantList);
+extern std::unique_ptr<hours::OpeningHoursIndex> loadOpeningHoursIndex(JNIEnv *env, jobject restaurantList);
+extern std::unique_ptr<search::TrigramIndex> loadMenuSearchIndex(JNIEnv *env, jobject restaurantList);
+extern void updateMenuSearchIndex(JNIEnv *env, search::TrigramIndex &index, jint restaurantIndex, jobject restaurant);
 
 JavaVM *globalJvm = nullptr;
 
 // Kotlin Function declaration (without Java_ prefix)
 jstring serializeRestaurant(JNIEnv *env, jobject thiz, jobject jRestaurant) {
+    NATIVE_STATS_CALL("serializeRestaurant");
+    ScratchArena::Scope scratch; // Strings read from the models live here until the call returns
     RestaurantShadow restShadow(env, jRestaurant);
-    std::string json = buildJsonFromRestaurant(env, restShadow);
-    return env->NewStringUTF(json.c_str());
+    JsonWriter writer(OutputBuffer::kThreadScratch); // Reuses the storage of the thread's previous call
+    encodeRestaurant(env, restShadow, OutputFormat::Json, writer);
+    NATIVE_STATS_BYTES(writer.size());
+    return newJavaStringFromUtf8(env, writer.c_str(), writer.size());
+}
+
+static void throwIllegalArgument(JNIEnv *env, const char *message) {
+    jclass exceptionClass = env->FindClass("java/lang/IllegalArgumentException");
+    env->ThrowNew(exceptionClass, message);
+}
+
+// Writes UTF-8 JSON into a direct ByteBuffer starting at index 0.
+// Returns the byte count, or the required size if it exceeds the buffer's capacity (contents are unspecified then).
+jint serializeRestaurantInto(JNIEnv *env, jobject thiz, jobject jRestaurant, jobject jBuffer) {
+    NATIVE_STATS_CALL("serializeRestaurantInto");
+    ScratchArena::Scope scratch;
+    void *address = jBuffer ? env->GetDirectBufferAddress(jBuffer) : nullptr;
+    jlong capacity = jBuffer ? env->GetDirectBufferCapacity(jBuffer) : -1;
+    if (!address || capacity < 0) {
+        throwIllegalArgument(env, "serializeRestaurantInto requires a direct ByteBuffer");
+        return -1;
+    }
+
+    RestaurantShadow restShadow(env, jRestaurant);
+    // Encodes in place; the writer only falls back to the heap once the buffer is full
+    JsonWriter writer(static_cast<char *>(address), static_cast<size_t>(capacity));
+    encodeRestaurant(env, restShadow, OutputFormat::Json, writer);
+    NATIVE_STATS_BYTES(writer.size());
+    return static_cast<jint>(writer.size());
+}
+
+// Encodes a Restaurant as JSON, CBOR or MessagePack (SerializationFormat.ordinal) into a new byte[]
+jbyteArray serializeRestaurantAs(JNIEnv *env, jobject thiz, jobject jRestaurant, jint format) {
+    NATIVE_STATS_CALL("serializeRestaurantAs");
+    ScratchArena::Scope scratch;
+    if (!isValidOutputFormat(format)) {
+        throwIllegalArgument(env, "Unknown serialization format");
+        return nullptr;
+    }
+
+    RestaurantShadow restShadow(env, jRestaurant);
+    JsonWriter out(OutputBuffer::kThreadScratch);
+    encodeRestaurant(env, restShadow, static_cast<OutputFormat>(format), out);
+    NATIVE_STATS_BYTES(out.size());
+
+    jbyteArray bytes = env->NewByteArray(static_cast<jsize>(out.size()));
+    if (!bytes) {
+        return nullptr; // OutOfMemoryError pending
+    }
+    env->SetByteArrayRegion(bytes, 0, static_cast<jsize>(out.size()), reinterpret_cast<const jbyte *>(out.data()));
+    return bytes;
+}
+
+// Same as serializeRestaurantInto, in any SerializationFormat
+jint serializeRestaurantAsInto(JNIEnv *env, jobject thiz, jobject jRestaurant, jint format, jobject jBuffer) {
+    NATIVE_STATS_CALL("serializeRestaurantAsInto");
+    ScratchArena::Scope scratch;
+    if (!isValidOutputFormat(format)) {
+        throwIllegalArgument(env, "Unknown serialization format");
+        return -1;
+    }
+    void *address = jBuffer ? env->GetDirectBufferAddress(jBuffer) : nullptr;
+    jlong capacity = jBuffer ? env->GetDirectBufferCapacity(jBuffer) : -1;
+    if (!address || capacity < 0) {
+        throwIllegalArgument(env, "serializeRestaurantInto requires a direct ByteBuffer");
+        return -1;
+    }
+
+    RestaurantShadow restShadow(env, jRestaurant);
+    JsonWriter out(static_cast<char *>(address), static_cast<size_t>(capacity));
+    encodeRestaurant(env, restShadow, static_cast<OutputFormat>(format), out);
+    NATIVE_STATS_BYTES(out.size());
+    return static_cast<jint>(out.size());
+}
+
+// Captures the restaurant now and encodes it on the executor thread, completing the CompletableFuture
+// with the JSON String. Returns false, without touching the future, if the executor queue is full.
+jboolean serializeRestaurantAsyncInto(JNIEnv *env, jobject thiz, jobject jRestaurant, jobject jFuture) {
+    NATIVE_STATS_CALL("serializeRestaurantAsync");
+    ScratchArena::Scope scratch;
+    auto tape = std::make_shared<EventTape>();
+    {
+        RestaurantShadow restShadow(env, jRestaurant);
+        captureRestaurant(env, restShadow, *tape);
+    }
+    bool queued = SerializationExecutor::submit(env, jFuture, [tape](JNIEnv *workerEnv) -> jobject {
+        NATIVE_STATS_CALL("serializeRestaurantAsync/complete");
+        JsonWriter writer(OutputBuffer::kThreadScratch);
+        writeJsonFromCapture(*tape, writer);
+        NATIVE_STATS_BYTES(writer.size());
+        return newJavaStringFromUtf8(workerEnv, writer.c_str(), writer.size());
+    });
+    return queued ? JNI_TRUE : JNI_FALSE;
+}
+
+// RFC 6902 JSON Patch from one Restaurant version to another, as a JSON array string
+jstring diffRestaurants(JNIEnv *env, jobject thiz, jobject jBefore, jobject jAfter) {
+    if (!jBefore || !jAfter) {
+        throwIllegalArgument(env, "diffRestaurants requires two restaurants");
+        return nullptr;
+    }
+    NATIVE_STATS_CALL("diffRestaurants");
+    ScratchArena::Scope scratch;
+    RestaurantShadow before(env, jBefore);
+    RestaurantShadow after(env, jAfter);
+    JsonWriter writer(OutputBuffer::kThreadScratch);
+    writeRestaurantPatch(env, before, after, writer);
+    NATIVE_STATS_BYTES(writer.size());
+    return newJavaStringFromUtf8(env, writer.c_str(), writer.size());
+}
+
+// Decodes JSON into a new Restaurant; malformed input throws IllegalArgumentException
+static jobject decodeRestaurant(JNIEnv *env, const char *json, size_t length) {
+    NATIVE_STATS_CALL("deserializeRestaurant");
+    ScratchArena::Scope scratch;
+    try {
+        return readRestaurantFromJson(env, json, length);
+    } catch (const JsonParseError &error) {
+        throwIllegalArgument(env, error.what());
+    } catch (const modelread::PendingJavaException &) {
+        // Propagates to the caller as is
+    } catch (const std::runtime_error &error) {
+        jclass exceptionClass = env->FindClass("java/lang/IllegalStateException");
+        env->ThrowNew(exceptionClass, error.what());
+    }
+    return nullptr;
+}
+
+// Decodes the JSON in a direct ByteBuffer's bytes [offset, offset + length)
+jobject deserializeRestaurantFromBuffer(JNIEnv *env, jobject thiz, jobject jBuffer, jint offset, jint length) {
+    auto *address = jBuffer ? static_cast<const char *>(env->GetDirectBufferAddress(jBuffer)) : nullptr;
+    jlong capacity = jBuffer ? env->GetDirectBufferCapacity(jBuffer) : -1;
+    if (!address || capacity < 0) {
+        throwIllegalArgument(env, "deserializeRestaurant requires a direct ByteBuffer");
+        return nullptr;
+    }
+    if (offset < 0 || length < 0 || static_cast<jlong>(offset) + length > capacity) {
+        throwIllegalArgument(env, "Range outside of the buffer");
+        return nullptr;
+    }
+    return decodeRestaurant(env, address + offset, static_cast<size_t>(length));
+}
+
+jobject deserializeRestaurantFromString(JNIEnv *env, jobject thiz, jstring jJson) {
+    ScratchArena::Scope scratch;
+    std::string_view json = toScratchUtf8(env, jJson);
+    return decodeRestaurant(env, json.data(), json.size());
+}
+
+// Serializes a whole List<Restaurant> in one JNI crossing, as a JSON array or NDJSON
+jstring serializeRestaurants(JNIEnv *env, jobject thiz, jobject jRestaurants, jboolean ndjson) {
+    NATIVE_STATS_CALL("serializeRestaurants");
+    ScratchArena::Scope scratch;
+    JsonWriter writer(OutputBuffer::kThreadScratch);
+    try {
+        writeJsonFromRestaurantList(env, jRestaurants, ndjson == JNI_TRUE, writer);
+    } catch (const modelread::PendingJavaException &) {
+        return nullptr; // Propagates to the caller as is
+    } catch (const std::exception &error) {
+        // e.g. std::bad_alloc on a batch pool thread, rethrown here; a JNI call may already have thrown
+        if (!env->ExceptionCheck()) {
+            jclass exceptionClass = env->FindClass("java/lang/IllegalStateException");
+            env->ThrowNew(exceptionClass, error.what());
+        }
+        return nullptr;
+    }
+    NATIVE_STATS_BYTES(writer.size());
+    return newJavaStringFromUtf8(env, writer.c_str(), writer.size());
+}
+
+// Compiles a List<String> of dotted Restaurant field paths; the handle owns a projection::Selection
+jlong compileProjectionPlan(JNIEnv *env, jobject thiz, jobject jFieldPaths) {
+    std::vector<std::string> paths;
+    {
+        JavaObjectList elements(env, jFieldPaths);
+        paths.reserve(static_cast<size_t>(elements.size()));
+        for (jint i = 0; i < elements.size(); i++) {
+            auto jPath = static_cast<jstring>(elements.get(env, i));
+            if (!jPath) {
+                throwIllegalArgument(env, "Field paths must not be null");
+                return 0;
+            }
+            paths.push_back(toUtf8String(env, jPath));
+            env->DeleteLocalRef(jPath);
+            NATIVE_STATS_LOCAL_REF_DELETED();
+        }
+    }
+    try {
+        return reinterpret_cast<jlong>(compileRestaurantProjection(paths).release());
+    } catch (const projection::ProjectionError &error) {
+        throwIllegalArgument(env, error.what());
+        return 0;
+    }
+}
+
+void releaseProjectionPlan(JNIEnv *env, jobject thiz, jlong plan) {
+    delete reinterpret_cast<projection::Selection *>(plan);
+}
+
+// JSON of only the fields selected by a compileProjectionPlan handle
+jstring serializeRestaurantProjectedWith(JNIEnv *env, jobject thiz, jobject jRestaurant, jlong plan) {
+    NATIVE_STATS_CALL("serializeRestaurantProjected");
+    ScratchArena::Scope scratch;
+    RestaurantShadow restShadow(env, jRestaurant);
+    JsonWriter writer(OutputBuffer::kThreadScratch);
+    writeProjectedRestaurant(env, restShadow, *reinterpret_cast<const projection::Selection *>(plan), writer);
+    NATIVE_STATS_BYTES(writer.size());
+    return newJavaStringFromUtf8(env, writer.c_str(), writer.size());
+}
+
+jstring serializeRestaurantsProjectedWith(JNIEnv *env, jobject thiz, jobject jRestaurants, jlong plan, jboolean ndjson) {
+    NATIVE_STATS_CALL("serializeRestaurantsProjected");
+    ScratchArena::Scope scratch;
+    JsonWriter writer(OutputBuffer::kThreadScratch);
+    writeProjectedRestaurantList(env, jRestaurants, *reinterpret_cast<const projection::Selection *>(plan),
+                                 ndjson == JNI_TRUE, writer);
+    NATIVE_STATS_BYTES(writer.size());
+    return newJavaStringFromUtf8(env, writer.c_str(), writer.size());
+}
+
+// Encodes a List<Restaurant> as one array in any SerializationFormat into a new byte[]
+jbyteArray serializeRestaurantsAs(JNIEnv *env, jobject thiz, jobject jRestaurants, jint format) {
+    NATIVE_STATS_CALL("serializeRestaurantsAs");
+    ScratchArena::Scope scratch;
+    if (!isValidOutputFormat(format)) {
+        throwIllegalArgument(env, "Unknown serialization format");
+        return nullptr;
+    }
+
+    JsonWriter out(OutputBuffer::kThreadScratch);
+    encodeRestaurantList(env, jRestaurants, static_cast<OutputFormat>(format), out);
+    NATIVE_STATS_BYTES(out.size());
+
+    jbyteArray bytes = env->NewByteArray(static_cast<jsize>(out.size()));
+    if (!bytes) {
+        return nullptr; // OutOfMemoryError pending
+    }
+    env->SetByteArrayRegion(bytes, 0, static_cast<jsize>(out.size()), reinterpret_cast<const jbyte *>(out.data()));
+    return bytes;
+}
+
+// Copies a List<Restaurant> into a columnar store; the handle owns a columns::RestaurantColumns
+jlong loadRestaurantStore(JNIEnv *env, jobject thiz, jobject jRestaurants) {
+    NATIVE_STATS_CALL("loadRestaurantStore");
+    return reinterpret_cast<jlong>(loadRestaurantColumns(env, jRestaurants).release());
+}
+
+void releaseRestaurantStore(JNIEnv *env, jobject thiz, jlong store) {
+    delete reinterpret_cast<columns::RestaurantColumns *>(store);
+}
+
+// {restaurants, menuItems, memoryBytes}
+jlongArray getRestaurantStoreInfo(JNIEnv *env, jobject thiz, jlong store) {
+    auto *table = reinterpret_cast<const columns::RestaurantColumns *>(store);
+    const jlong values[] = {static_cast<jlong>(table->restaurantCount()), static_cast<jlong>(table->menuItemCount()),
+                            static_cast<jlong>(table->memoryBytes())};
+    jlongArray result = env->NewLongArray(3);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 3, values);
+    }
+    return result;
+}
+
+// A null jstring leaves the filter's string unset; the view lives in the caller's ScratchArena::Scope
+static std::optional<std::string_view> optionalUtf8(JNIEnv *env, jstring text) {
+    return text ? std::optional<std::string_view>(toScratchUtf8(env, text)) : std::nullopt;
+}
+
+static jintArray newIntArray(JNIEnv *env, const std::vector<uint32_t> &values) {
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    if (result) {
+        env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()),
+                               reinterpret_cast<const jint *>(values.data()));
+    }
+    return result;
+}
+
+// Indices of the restaurants matching the filter, ascending; the menu item filter applies when hasMenuItemFilter
+jintArray filterRestaurantStore(JNIEnv *env, jobject thiz, jlong store, jdouble minRating, jdouble ratingBelow,
+                                jstring jCuisine, jboolean hasMenuItemFilter, jdouble minPrice, jdouble priceBelow,
+                                jstring jCategory) {
+    NATIVE_STATS_CALL("filterRestaurantStore");
+    ScratchArena::Scope scratch;
+    columns::RestaurantFilter filter;
+    filter.minRating = minRating;
+    filter.ratingBelow = ratingBelow;
+    filter.cuisine = optionalUtf8(env, jCuisine);
+    if (hasMenuItemFilter == JNI_TRUE) {
+        filter.menuItem = columns::MenuItemFilter{minPrice, priceBelow, optionalUtf8(env, jCategory)};
+    }
+    return newIntArray(env, reinterpret_cast<const columns::RestaurantColumns *>(store)->filterRestaurants(filter));
+}
+
+// (restaurant index, menu index) pairs of the matching menu items, flattened, ascending
+jintArray filterRestaurantStoreMenu(JNIEnv *env, jobject thiz, jlong store, jdouble minPrice, jdouble priceBelow,
+                                    jstring jCategory) {
+    NATIVE_STATS_CALL("filterRestaurantStoreMenu");
+    ScratchArena::Scope scratch;
+    columns::MenuItemFilter filter{minPrice, priceBelow, optionalUtf8(env, jCategory)};
+    return newIntArray(env, reinterpret_cast<const columns::RestaurantColumns *>(store)->filterMenuItems(filter));
+}
+
+// {count, min, max, mean, histogram...} of the prices of the matching menu items
+jdoubleArray summarizeRestaurantStorePrices(JNIEnv *env, jobject thiz, jlong store, jdouble minPrice,
+                                            jdouble priceBelow, jstring jCategory, jint buckets) {
+    NATIVE_STATS_CALL("summarizeRestaurantStorePrices");
+    ScratchArena::Scope scratch;
+    columns::MenuItemFilter filter{minPrice, priceBelow, optionalUtf8(env, jCategory)};
+    columns::PriceSummary summary = reinterpret_cast<const columns::RestaurantColumns *>(store)->summarizePrices(
+            filter, buckets > 0 ? static_cast<size_t>(buckets) : 0);
+    std::vector<jdouble> values = {static_cast<jdouble>(summary.count), summary.min, summary.max, summary.mean};
+    values.insert(values.end(), summary.histogram.begin(), summary.histogram.end());
+    jdoubleArray result = env->NewDoubleArray(static_cast<jsize>(values.size()));
+    if (result) {
+        env->SetDoubleArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    }
+    return result;
+}
+
+// Compiles the opening hours of a List<Restaurant>; the handle owns an hours::OpeningHoursIndex
+jlong loadOpeningHoursIndexHandle(JNIEnv *env, jobject thiz, jobject jRestaurants) {
+    NATIVE_STATS_CALL("loadOpeningHoursIndex");
+    return reinterpret_cast<jlong>(loadOpeningHoursIndex(env, jRestaurants).release());
+}
+
+void releaseOpeningHoursIndexHandle(JNIEnv *env, jobject thiz, jlong index) {
+    delete reinterpret_cast<hours::OpeningHoursIndex *>(index);
+}
+
+// {restaurants, memoryBytes}
+jlongArray getOpeningHoursIndexInfo(JNIEnv *env, jobject thiz, jlong index) {
+    auto *hoursIndex = reinterpret_cast<const hours::OpeningHoursIndex *>(index);
+    const jlong values[] = {static_cast<jlong>(hoursIndex->restaurantCount()),
+                            static_cast<jlong>(hoursIndex->memoryBytes())};
+    jlongArray result = env->NewLongArray(2);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 2, values);
+    }
+    return result;
+}
+
+jboolean isRestaurantOpenAt(JNIEnv *env, jobject thiz, jlong index, jint restaurant, jint weekMinute) {
+    auto *hoursIndex = reinterpret_cast<const hours::OpeningHoursIndex *>(index);
+    return hoursIndex->isOpenAt(static_cast<size_t>(restaurant), static_cast<uint32_t>(weekMinute)) ? JNI_TRUE
+                                                                                                   : JNI_FALSE;
+}
+
+// Minutes until the restaurant opens, 0 when open, -1 when it never opens
+jint minutesUntilRestaurantOpens(JNIEnv *env, jobject thiz, jlong index, jint restaurant, jint weekMinute) {
+    auto *hoursIndex = reinterpret_cast<const hours::OpeningHoursIndex *>(index);
+    return hoursIndex->minutesUntilOpen(static_cast<size_t>(restaurant), static_cast<uint32_t>(weekMinute));
+}
+
+// Indices of the restaurants open at weekMinute, or for all of [weekMinute, weekMinute + minutes), ascending
+jintArray restaurantsOpenThroughout(JNIEnv *env, jobject thiz, jlong index, jint weekMinute, jint minutes) {
+    NATIVE_STATS_CALL("restaurantsOpenThroughout");
+    auto *hoursIndex = reinterpret_cast<const hours::OpeningHoursIndex *>(index);
+    auto minute = static_cast<uint32_t>(weekMinute);
+    return newIntArray(env, minutes <= 1 ? hoursIndex->openAt(minute)
+                                         : hoursIndex->openThroughout(minute, static_cast<uint32_t>(minutes)));
+}
+
+// minutesUntilRestaurantOpens for every restaurant of the index
+jintArray minutesUntilRestaurantsOpen(JNIEnv *env, jobject thiz, jlong index, jint weekMinute) {
+    NATIVE_STATS_CALL("minutesUntilRestaurantsOpen");
+    auto *hoursIndex = reinterpret_cast<const hours::OpeningHoursIndex *>(index);
+    std::vector<int32_t> minutes = hoursIndex->minutesUntilOpen(static_cast<uint32_t>(weekMinute));
+    jintArray result = env->NewIntArray(static_cast<jsize>(minutes.size()));
+    if (result) {
+        env->SetIntArrayRegion(result, 0, static_cast<jsize>(minutes.size()), minutes.data());
+    }
+    return result;
+}
+
+// Indexes the menu item names and descriptions of a List<Restaurant>; the handle owns a search::TrigramIndex
+jlong loadMenuSearchIndexHandle(JNIEnv *env, jobject thiz, jobject jRestaurants) {
+    NATIVE_STATS_CALL("loadMenuSearchIndex");
+    return reinterpret_cast<jlong>(loadMenuSearchIndex(env, jRestaurants).release());
+}
+
+void releaseMenuSearchIndexHandle(JNIEnv *env, jobject thiz, jlong index) {
+    delete reinterpret_cast<search::TrigramIndex *>(index);
+}
+
+// {menu items, trigrams, memoryBytes}
+jlongArray getMenuSearchIndexInfo(JNIEnv *env, jobject thiz, jlong index) {
+    auto *searchIndex = reinterpret_cast<const search::TrigramIndex *>(index);
+    const jlong values[] = {static_cast<jlong>(searchIndex->documentCount()),
+                            static_cast<jlong>(searchIndex->trigramCount()),
+                            static_cast<jlong>(searchIndex->memoryBytes())};
+    jlongArray result = env->NewLongArray(3);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 3, values);
+    }
+    return result;
+}
+
+// Re-indexes the menu of one restaurant in place; a null restaurant removes its menu items
+void updateMenuSearchIndexHandle(JNIEnv *env, jobject thiz, jlong index, jint restaurantIndex, jobject jRestaurant) {
+    NATIVE_STATS_CALL("updateMenuSearchIndex");
+    updateMenuSearchIndex(env, *reinterpret_cast<search::TrigramIndex *>(index), restaurantIndex, jRestaurant);
+}
+
+// (restaurant index, menu index) pairs of the matching menu items, flattened, best match first
+jintArray searchMenuSearchIndex(JNIEnv *env, jobject thiz, jlong index, jstring jQuery, jboolean prefix,
+                                jint limit) {
+    NATIVE_STATS_CALL("searchMenuSearchIndex");
+    std::vector<search::TrigramIndex::Hit> hits;
+    {
+        JavaStringChars query(env, jQuery);
+        hits = reinterpret_cast<const search::TrigramIndex *>(index)->search(
+                query.data(), query.size(), prefix == JNI_TRUE, limit > 0 ? static_cast<size_t>(limit) : 0);
+    }
+    std::vector<uint32_t> pairs;
+    pairs.reserve(2 * hits.size());
+    for (const search::TrigramIndex::Hit &hit : hits) {
+        pairs.push_back(hit.restaurant);
+        pairs.push_back(hit.item);
+    }
+    return newIntArray(env, pairs);
+}
+
+// Switches the shadow classes between backing-field reads and getter calls
+void setFieldAccessEnabled(JNIEnv *env, jobject thiz, jboolean enabled) {
+    ShadowProperty::fieldAccessEnabled = enabled == JNI_TRUE;
+}
+
+// Switches JavaObjectList between the lists' backing arrays and Collection.toArray()
+void setListFastPathEnabled(JNIEnv *env, jobject thiz, jboolean enabled) {
+    JavaCollections::listFastPathEnabled = enabled == JNI_TRUE;
+}
+
+static void throwIOException(JNIEnv *env, const std::string &message) {
+    jclass exceptionClass = env->FindClass("java/io/IOException");
+    env->ThrowNew(exceptionClass, message.c_str());
+}
+
+// Streams the list as NDJSON to fd, which stays open; returns the byte count, or -1 with an exception pending
+jlong exportRestaurantsToFd(JNIEnv *env, jobject thiz, jobject jRestaurants, jint fd, jboolean overlapIo) {
+    NATIVE_STATS_CALL("exportRestaurants");
+    ScratchArena::Scope scratch;
+    try {
+        size_t written = exportRestaurantList(env, jRestaurants, fd, overlapIo == JNI_TRUE);
+        NATIVE_STATS_BYTES(written);
+        return static_cast<jlong>(written);
+    } catch (const IoError &error) {
+        throwIOException(env, error.what());
+    } catch (const modelread::PendingJavaException &) {
+        // Propagates to the caller as is
+    } catch (const std::exception &error) {
+        // e.g. std::bad_alloc, or a shadow read that failed; a JNI call may already have thrown
+        if (!env->ExceptionCheck()) {
+            jclass exceptionClass = env->FindClass("java/lang/IllegalStateException");
+            env->ThrowNew(exceptionClass, error.what());
+        }
+    }
+    return -1;
+}
+
+// Streams the list as NDJSON to a new (or truncated) file at path
+jlong exportRestaurantsToPath(JNIEnv *env, jobject thiz, jobject jRestaurants, jstring jPath, jboolean overlapIo) {
+    std::string path = toUtf8String(env, jPath);
+    ScopedFd fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (fd.get() < 0) {
+        throwIOException(env, path + ": " + std::strerror(errno));
+        return -1;
+    }
+    jlong written = exportRestaurantsToFd(env, thiz, jRestaurants, fd.get(), overlapIo);
+    if (fd.close() != 0 && !env->ExceptionCheck()) {
+        throwIOException(env, path + ": " + std::strerror(errno));
+        return -1;
+    }
+    return written;
+}
+
+// Encoding threads for serializeRestaurants; 1 (the default) encodes on the calling thread
+void setSerializationThreads(JNIEnv *env, jobject thiz, jint threads) {
+    setBatchThreadCount(threads > 0 ? static_cast<size_t>(threads) : 1);
+}
+
+// Opt-in cache of encoded restaurants; 0 bytes (the default) disables it
+void setSerializationCacheCapacity(JNIEnv *env, jobject thiz, jlong bytes) {
+    SerializationCache::setCapacity(bytes > 0 ? static_cast<size_t>(bytes) : 0);
+}
+
+// Drops one restaurant's cached encodings, or the whole cache for a null id
+void invalidateSerializationCache(JNIEnv *env, jobject thiz, jstring jId) {
+    if (!jId) {
+        SerializationCache::clear();
+        return;
+    }
+    invalidateCachedRestaurant(toUtf8String(env, jId));
+}
+
+// {hits, misses, fragmentHits, fragmentMisses, evictions, entries, bytes}
+jlongArray getSerializationCacheStats(JNIEnv *env, jobject thiz) {
+    SerializationCache::Stats stats = SerializationCache::stats();
+    const jlong values[] = {stats.hits, stats.misses, stats.fragmentHits, stats.fragmentMisses,
+                            stats.evictions, stats.entries, stats.bytes};
+    jlongArray result = env->NewLongArray(7);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 7, values);
+    }
+    return result;
+}
+
+// Per-call dictionary of repeated strings (and CBOR stringrefs); off by default
+void setStringDeduplicationEnabled(JNIEnv *env, jobject thiz, jboolean enabled) {
+    StringDictionary::enabled = enabled == JNI_TRUE;
+}
+
+// {lookups, hits, identityHits, bytesSaved}
+jlongArray getStringDeduplicationStats(JNIEnv *env, jobject thiz) {
+    StringDictionary::Stats stats = StringDictionary::totals();
+    const jlong values[] = {stats.lookups, stats.hits, stats.identityHits, stats.bytesSaved};
+    jlongArray result = env->NewLongArray(4);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// {enabled, jniCallKinds, phases, histogramBuckets, counters...}, counters laid out as in NativeStats.h
+jlongArray getNativeStats(JNIEnv *env, jobject thiz) {
+    std::vector<int64_t> counters = nativestats::NativeStats::snapshot();
+    std::vector<jlong> values = {nativestats::kEnabled ? 1 : 0, static_cast<jlong>(nativestats::kJniCallKinds),
+                                 static_cast<jlong>(nativestats::kPhases),
+                                 static_cast<jlong>(nativestats::kHistogramBuckets)};
+    values.insert(values.end(), counters.begin(), counters.end());
+    jlongArray result = env->NewLongArray(static_cast<jsize>(values.size()));
+    if (result) {
+        env->SetLongArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    }
+    return result;
+}
+
+void resetNativeStats(JNIEnv *env, jobject thiz) {
+    nativestats::NativeStats::reset();
+}
+
+void startNativeTrace(JNIEnv *env, jobject thiz, jint maxEvents) {
+    nativestats::NativeStats::startTrace(maxEvents > 0 ? static_cast<size_t>(maxEvents) : 0);
+}
+
+// The spans recorded since startNativeTrace, as Chrome trace event JSON
+jstring stopNativeTrace(JNIEnv *env, jobject thiz) {
+    JsonWriter writer;
+    nativestats::NativeStats::stopTrace(writer);
+    return newJavaStringFromUtf8(env, writer.c_str(), writer.size());
 }
 
 // Init functions, called only once!!!
 static const JNINativeMethod nativeMethods[] = {
         {"serializeRestaurant", "(Lcom/voidmemories/restaurant_serializer/Restaurant;)Ljava/lang/String;",
-         (void *)serializeRestaurant}
+         (void *)serializeRestaurant},
+        {"serializeRestaurantInto", "(Lcom/voidmemories/restaurant_serializer/Restaurant;Ljava/nio/ByteBuffer;)I",
+         (void *)serializeRestaurantInto},
+        {"serializeRestaurantAs", "(Lcom/voidmemories/restaurant_serializer/Restaurant;I)[B",
+         (void *)serializeRestaurantAs},
+        {"serializeRestaurantAsInto", "(Lcom/voidmemories/restaurant_serializer/Restaurant;ILjava/nio/ByteBuffer;)I",
+         (void *)serializeRestaurantAsInto},
+        {"deserializeRestaurantFromBuffer", "(Ljava/nio/ByteBuffer;II)Lcom/voidmemories/restaurant_serializer/Restaurant;",
+         (void *)deserializeRestaurantFromBuffer},
+        {"deserializeRestaurant", "(Ljava/lang/String;)Lcom/voidmemories/restaurant_serializer/Restaurant;",
+         (void *)deserializeRestaurantFromString},
+        {"diffRestaurants", "(Lcom/voidmemories/restaurant_serializer/Restaurant;Lcom/voidmemories/restaurant_serializer/Restaurant;)Ljava/lang/String;",
+         (void *)diffRestaurants},
+        {"serializeRestaurants", "(Ljava/util/List;Z)Ljava/lang/String;",
+         (void *)serializeRestaurants},
+        {"compileProjectionPlan", "(Ljava/util/List;)J",
+         (void *)compileProjectionPlan},
+        {"releaseProjectionPlan", "(J)V",
+         (void *)releaseProjectionPlan},
+        {"serializeRestaurantProjectedWith", "(Lcom/voidmemories/restaurant_serializer/Restaurant;J)Ljava/lang/String;",
+         (void *)serializeRestaurantProjectedWith},
+        {"serializeRestaurantsProjectedWith", "(Ljava/util/List;JZ)Ljava/lang/String;",
+         (void *)serializeRestaurantsProjectedWith},
+        {"serializeRestaurantsAs", "(Ljava/util/List;I)[B",
+         (void *)serializeRestaurantsAs},
+        {"loadRestaurantStoreHandle", "(Ljava/util/List;)J",
+         (void *)loadRestaurantStore},
+        {"releaseRestaurantStoreHandle", "(J)V",
+         (void *)releaseRestaurantStore},
+        {"getRestaurantStoreInfo", "(J)[J",
+         (void *)getRestaurantStoreInfo},
+        {"filterRestaurantStore", "(JDDLjava/lang/String;ZDDLjava/lang/String;)[I",
+         (void *)filterRestaurantStore},
+        {"filterRestaurantStoreMenu", "(JDDLjava/lang/String;)[I",
+         (void *)filterRestaurantStoreMenu},
+        {"summarizeRestaurantStorePrices", "(JDDLjava/lang/String;I)[D",
+         (void *)summarizeRestaurantStorePrices},
+        {"loadOpeningHoursIndexHandle", "(Ljava/util/List;)J",
+         (void *)loadOpeningHoursIndexHandle},
+        {"releaseOpeningHoursIndexHandle", "(J)V",
+         (void *)releaseOpeningHoursIndexHandle},
+        {"getOpeningHoursIndexInfo", "(J)[J",
+         (void *)getOpeningHoursIndexInfo},
+        {"isRestaurantOpenAt", "(JII)Z",
+         (void *)isRestaurantOpenAt},
+        {"minutesUntilRestaurantOpens", "(JII)I",
+         (void *)minutesUntilRestaurantOpens},
+        {"restaurantsOpenThroughout", "(JII)[I",
+         (void *)restaurantsOpenThroughout},
+        {"minutesUntilRestaurantsOpen", "(JI)[I",
+         (void *)minutesUntilRestaurantsOpen},
+        {"loadMenuSearchIndexHandle", "(Ljava/util/List;)J",
+         (void *)loadMenuSearchIndexHandle},
+        {"releaseMenuSearchIndexHandle", "(J)V",
+         (void *)releaseMenuSearchIndexHandle},
+        {"getMenuSearchIndexInfo", "(J)[J",
+         (void *)getMenuSearchIndexInfo},
+        {"updateMenuSearchIndexHandle", "(JILcom/voidmemories/restaurant_serializer/Restaurant;)V",
+         (void *)updateMenuSearchIndexHandle},
+        {"searchMenuSearchIndex", "(JLjava/lang/String;ZI)[I",
+         (void *)searchMenuSearchIndex},
+        {"setFieldAccessEnabled", "(Z)V",
+         (void *)setFieldAccessEnabled},
+        {"setListFastPathEnabled", "(Z)V",
+         (void *)setListFastPathEnabled},
+        {"setStringDeduplicationEnabled", "(Z)V",
+         (void *)setStringDeduplicationEnabled},
+        {"serializeRestaurantAsyncInto",
+         "(Lcom/voidmemories/restaurant_serializer/Restaurant;Ljava/util/concurrent/CompletableFuture;)Z",
+         (void *)serializeRestaurantAsyncInto},
+        {"exportRestaurantsToFd", "(Ljava/util/List;IZ)J",
+         (void *)exportRestaurantsToFd},
+        {"exportRestaurantsToPath", "(Ljava/util/List;Ljava/lang/String;Z)J",
+         (void *)exportRestaurantsToPath},
+        {"setSerializationThreads", "(I)V",
+         (void *)setSerializationThreads},
+        {"setSerializationCacheCapacity", "(J)V",
+         (void *)setSerializationCacheCapacity},
+        {"invalidateSerializationCache", "(Ljava/lang/String;)V",
+         (void *)invalidateSerializationCache},
+        {"getSerializationCacheStatsArray", "()[J",
+         (void *)getSerializationCacheStats},
+        {"getStringDeduplicationStatsArray", "()[J",
+         (void *)getStringDeduplicationStats},
+        {"getNativeStatsArray", "()[J",
+         (void *)getNativeStats},
+        {"resetNativeStats", "()V",
+         (void *)resetNativeStats},
+        {"startNativeTrace", "(I)V",
+         (void *)startNativeTrace},
+        {"stopNativeTrace", "()Ljava/lang/String;",
+         (void *)stopNativeTrace}
 };
 
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void * /*reserved*/) {
@@ -31,10 +717,13 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void * /*reserved*/) {
         return -1;
     }
 
+    JavaCollections::init(env);
+    JavaTime::init(env);
     AddressShadow::init(env);
     MenuItemShadow::init(env);
     OpeningHourShadow::init(env);
     RestaurantShadow::init(env);
+    SerializationExecutor::init(env, vm);
 
     jclass clazz = env->FindClass("com/voidmemories/restaurant_serializer/ExternalFunctions");
     if (!clazz) {
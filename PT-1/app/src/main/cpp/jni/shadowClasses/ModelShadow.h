@@ -0,0 +1,307 @@
+#ifndef ANDROID_SDK_MODELSHADOW_H
+#define ANDROID_SDK_MODELSHADOW_H
+
+#include <jni.h>
+#include <array>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "../JavaTime.h"
+#include "ShadowProperty.h"
+#include "ShadowRef.h"
+
+/**
+ * What a model property holds; decides its JNI signature, how it is read and how it is serialized.
+ */
+enum class FieldKind {
+    String,     // String / String?
+    Double,     // Double
+    Object,     // another model class
+    StringList, // List<String>
+    ObjectList, // List<model class>
+    DayOfWeek,  // java.time.DayOfWeek
+    LocalTime   // java.time.LocalTime
+};
+
+/**
+ * Compile-time description of one property of a Kotlin data class.
+ * Kind (and the nested model for Object/ObjectList) is part of the type, so everything that
+ * depends on it is resolved statically; only the name is a value.
+ */
+template <FieldKind Kind, typename Nested = void>
+struct FieldDescriptor {
+    static constexpr FieldKind kind = Kind;
+    using Model = Nested;
+
+    std::string_view name;
+};
+
+constexpr FieldDescriptor<FieldKind::String> stringField(std::string_view name) { return {name}; }
+constexpr FieldDescriptor<FieldKind::Double> doubleField(std::string_view name) { return {name}; }
+constexpr FieldDescriptor<FieldKind::StringList> stringListField(std::string_view name) { return {name}; }
+constexpr FieldDescriptor<FieldKind::DayOfWeek> dayOfWeekField(std::string_view name) { return {name}; }
+constexpr FieldDescriptor<FieldKind::LocalTime> localTimeField(std::string_view name) { return {name}; }
+
+template <typename Model>
+constexpr FieldDescriptor<FieldKind::Object, Model> objectField(std::string_view name) { return {name}; }
+
+template <typename Model>
+constexpr FieldDescriptor<FieldKind::ObjectList, Model> objectListField(std::string_view name) { return {name}; }
+
+/**
+ * @return The JNI type signature of a property, e.g. "D" or "Ljava/util/List;".
+ */
+template <typename Field>
+std::string jniTypeOf() {
+    switch (Field::kind) {
+        case FieldKind::String:
+            return "Ljava/lang/String;";
+        case FieldKind::Double:
+            return "D";
+        case FieldKind::StringList:
+        case FieldKind::ObjectList:
+            return "Ljava/util/List;";
+        case FieldKind::DayOfWeek:
+            return "Ljava/time/DayOfWeek;";
+        case FieldKind::LocalTime:
+            return "Ljava/time/LocalTime;";
+        case FieldKind::Object:
+            break;
+    }
+    if constexpr (Field::kind == FieldKind::Object) {
+        return std::string("L") + Field::Model::className + ";";
+    }
+    return std::string();
+}
+
+/**
+ * True for model descriptors that declare a keyField.
+ */
+template <typename Model, typename = void>
+struct HasKeyField : std::false_type {};
+
+template <typename Model>
+struct HasKeyField<Model, std::void_t<decltype(Model::keyField)>> : std::true_type {};
+
+/**
+ * Calls f(std::integral_constant<size_t, I>{}) for I = 0 .. N-1, unrolled at compile time.
+ */
+template <typename F, size_t... I>
+constexpr void forEachIndex(F&& f, std::index_sequence<I...>) {
+    (f(std::integral_constant<size_t, I>{}), ...);
+}
+
+/**
+ * @class ModelShadow
+ * @brief Shadow of a Kotlin data class, generated from its model descriptor.
+ *
+ * A model descriptor is a struct with the JNI class name and a constexpr tuple of fields, listed in
+ * the order of the Kotlin declaration:
+ *
+ *   struct AddressModel {
+ *       static constexpr const char* className = "com/voidmemories/restaurant_serializer/Address";
+ *       static constexpr auto fields = std::make_tuple(
+ *               stringField("street"),
+ *               stringField("city"));
+ *   };
+ *
+ * Models that are list elements may also name the field that identifies an element across versions,
+ * e.g. static constexpr std::string_view keyField = "id"; (see ModelDiff.h).
+ *
+ * init() resolves a ShadowProperty (backing field + getter) for every field, and the typed
+ * read<...>() accessors below are instantiated per field index. Field lookups by name happen at
+ * compile time only (see field()); at runtime each access is a direct array slot.
+ */
+template <typename Model>
+class ModelShadow {
+public:
+    using Fields = std::remove_const_t<decltype(Model::fields)>;
+    static constexpr size_t kFieldCount = std::tuple_size_v<Fields>;
+
+    template <size_t I>
+    using FieldAt = std::tuple_element_t<I, Fields>;
+
+    /**
+     * Compile-time index of the field called name; fails to compile (out of range) if there is none.
+     */
+    static constexpr size_t field(std::string_view name) {
+        size_t index = kFieldCount;
+        forEachIndex([&](auto i) {
+            if (index == kFieldCount && std::get<decltype(i)::value>(Model::fields).name == name) {
+                index = decltype(i)::value;
+            }
+        }, std::make_index_sequence<kFieldCount>{});
+        return index;
+    }
+
+    template <size_t I>
+    static constexpr std::string_view fieldName() {
+        return std::get<I>(Model::fields).name;
+    }
+
+    template <typename F>
+    static constexpr void forEachField(F&& f) {
+        forEachIndex(std::forward<F>(f), std::make_index_sequence<kFieldCount>{});
+    }
+
+    static constexpr std::array<std::string_view, kFieldCount> kFieldNames = [] {
+        std::array<std::string_view, kFieldCount> names{};
+        forEachField([&](auto i) { names[decltype(i)::value] = fieldName<decltype(i)::value>(); });
+        return names;
+    }();
+
+    static bool init(JNIEnv* env) {
+        if (!env) return false;
+
+        jclass localClass = env->FindClass(Model::className);
+        if (!localClass) {
+            return false;
+        }
+        modelClass = static_cast<jclass>(env->NewGlobalRef(localClass));
+        env->DeleteLocalRef(localClass);
+        if (!modelClass) {
+            return false;
+        }
+
+        // Kotlin generates a private backing field named like the property and a getX() getter
+        bool resolved = true;
+        std::string constructorSignature = "(";
+        forEachField([&](auto i) {
+            constexpr size_t I = decltype(i)::value;
+            std::string name(fieldName<I>());
+            std::string getterName = "get" + name;
+            getterName[3] = static_cast<char>(std::toupper(static_cast<unsigned char>(getterName[3])));
+            std::string type = jniTypeOf<FieldAt<I>>();
+            resolved &= properties[I].init(env, modelClass, name.c_str(), getterName.c_str(), type.c_str());
+            constructorSignature += type;
+        });
+
+        // The primary constructor takes every property in declaration order
+        constructorSignature += ")V";
+        constructorId = env->GetMethodID(modelClass, "<init>", constructorSignature.c_str());
+        if (!constructorId) {
+            env->ExceptionClear(); // NoSuchMethodError; only decoding needs the constructor
+        }
+        return resolved;
+    }
+
+    static jclass javaClass() {
+        return modelClass;
+    }
+
+    /**
+     * @return The primary constructor, taking the properties in descriptor order; null if it was not found.
+     */
+    static jmethodID constructor() {
+        return constructorId;
+    }
+
+    /**
+     * Runtime index of the field called name, or kFieldCount if there is none.
+     * Tries hint first, so input in declaration order costs one comparison per key.
+     */
+    static size_t fieldIndex(std::string_view name, size_t hint) {
+        if (hint < kFieldCount && kFieldNames[hint] == name) {
+            return hint;
+        }
+        for (size_t i = 0; i < kFieldCount; i++) {
+            if (kFieldNames[i] == name) return i;
+        }
+        return kFieldCount;
+    }
+
+    template <size_t I>
+    static const ShadowProperty& property() {
+        return properties[I];
+    }
+
+    /**
+     * By default the shadow borrows obj and is only valid during the current native call.
+     * Pass ShadowLifetime::Global when it must outlive the call.
+     */
+    ModelShadow(JNIEnv* env, jobject obj, ShadowLifetime lifetime = ShadowLifetime::Scoped)
+            : modelObject(env, obj, lifetime) {
+        if (!env || !obj) {
+            throw std::runtime_error(std::string("Invalid constructor arguments for ") + Model::className);
+        }
+    }
+
+    jobject object() const {
+        return modelObject;
+    }
+
+    // String property as UTF-8 in the thread's ScratchArena, "" for null
+    template <size_t I>
+    std::string_view readString(JNIEnv* env) const {
+        static_assert(FieldAt<I>::kind == FieldKind::String, "not a String field");
+        return checked<I>(env).readString(env, modelObject);
+    }
+
+    // String property as a jstring local reference (or null)
+    template <size_t I>
+    jstring readJString(JNIEnv* env) const {
+        static_assert(FieldAt<I>::kind == FieldKind::String, "not a String field");
+        return static_cast<jstring>(checked<I>(env).readObject(env, modelObject));
+    }
+
+    template <size_t I>
+    jdouble readDouble(JNIEnv* env) const {
+        static_assert(FieldAt<I>::kind == FieldKind::Double, "not a Double field");
+        return checked<I>(env).readDouble(env, modelObject);
+    }
+
+    // Any reference-typed property as a local reference (or null)
+    template <size_t I>
+    jobject readObject(JNIEnv* env) const {
+        static_assert(FieldAt<I>::kind != FieldKind::Double, "not a reference field");
+        return checked<I>(env).readObject(env, modelObject);
+    }
+
+    // DayOfWeek property as its ordinal (MONDAY = 0), -1 for null
+    template <size_t I>
+    jint readDayOfWeekOrdinal(JNIEnv* env) const {
+        static_assert(FieldAt<I>::kind == FieldKind::DayOfWeek, "not a DayOfWeek field");
+        jobject dayOfWeek = checked<I>(env).readObject(env, modelObject);
+        jint ordinal = JavaTime::readOrdinal(env, dayOfWeek);
+        if (dayOfWeek) {
+            env->DeleteLocalRef(dayOfWeek);
+            NATIVE_STATS_LOCAL_REF_DELETED();
+        }
+        return ordinal;
+    }
+
+    // LocalTime property's components; returns false (time untouched) for null
+    template <size_t I>
+    bool readLocalTime(JNIEnv* env, temporal::LocalTimeParts& time) const {
+        static_assert(FieldAt<I>::kind == FieldKind::LocalTime, "not a LocalTime field");
+        jobject localTime = checked<I>(env).readObject(env, modelObject);
+        if (!localTime) {
+            return false;
+        }
+        time = JavaTime::readLocalTime(env, localTime);
+        env->DeleteLocalRef(localTime);
+        NATIVE_STATS_LOCAL_REF_DELETED();
+        return true;
+    }
+
+protected:
+    inline static jclass modelClass;
+    inline static jmethodID constructorId;
+    inline static std::array<ShadowProperty, kFieldCount> properties;
+
+    ShadowRef modelObject;
+
+    template <size_t I>
+    const ShadowProperty& checked(JNIEnv* env) const {
+        if (!env || !modelObject || !properties[I]) {
+            throw std::runtime_error("Invalid state to read " + std::string(fieldName<I>()) + ".");
+        }
+        return properties[I];
+    }
+};
+
+#endif // ANDROID_SDK_MODELSHADOW_H
@@ -0,0 +1,133 @@
+#ifndef ANDROID_SDK_SHADOWPROPERTY_H
+#define ANDROID_SDK_SHADOWPROPERTY_H
+
+#include <jni.h>
+#include <string>
+#include <string_view>
+#include "../JavaStrings.h"
+#include "../../core/NativeStats.h"
+
+/**
+ * @class ShadowProperty
+ * @brief One Kotlin property of a model class, read through its backing field or its getter.
+ *
+ * init() resolves both the getter (e.g. getStreet) and the backing field (e.g. street).
+ * Reads use GetXxxField when the field was found, which skips a full method dispatch,
+ * and fall back to the getter when it was not (e.g. the field was renamed by obfuscation).
+ *
+ * Usage:
+ *   inline static ShadowProperty street;
+ *   street.init(env, addressClass, "street", "getStreet", "Ljava/lang/String;");
+ *   jstring jStreet = (jstring)street.readObject(env, addressObject);
+ */
+class ShadowProperty {
+public:
+    /**
+     * Global switch between field reads and getter calls, mainly to benchmark both modes side by side.
+     */
+    inline static bool fieldAccessEnabled = true;
+
+    /**
+     * @param type JNI type signature of the property, e.g. "D" or "Ljava/lang/String;".
+     * @return false if neither the getter nor the backing field could be resolved.
+     */
+    bool init(JNIEnv* env, jclass clazz, const char* fieldName, const char* getterName, const char* type) {
+        return init(env, clazz, fieldName, type, getterName, type);
+    }
+
+    /**
+     * For properties whose backing field is narrower than the getter's return type,
+     * e.g. LocalTime's "hour" is a byte field but getHour() returns int.
+     */
+    bool init(JNIEnv* env, jclass clazz, const char* fieldName, const char* fieldType,
+              const char* getterName, const char* getterType) {
+        std::string getterSignature = std::string("()") + getterType;
+        getterId_ = env->GetMethodID(clazz, getterName, getterSignature.c_str());
+        if (!getterId_) {
+            env->ExceptionClear(); // NoSuchMethodError
+        }
+        fieldId_ = env->GetFieldID(clazz, fieldName, fieldType);
+        if (!fieldId_) {
+            env->ExceptionClear(); // NoSuchFieldError
+        }
+        fieldKind_ = fieldType[0];
+        return getterId_ || fieldId_;
+    }
+
+    explicit operator bool() const {
+        return getterId_ || fieldId_;
+    }
+
+    /**
+     * @return true if reads currently go through the backing field.
+     */
+    bool readsField() const {
+        return fieldId_ && (fieldAccessEnabled || !getterId_);
+    }
+
+    jobject readObject(JNIEnv* env, jobject obj) const {
+        NATIVE_STATS_PHASE(FieldRead);
+        NATIVE_STATS_JNI(readKind(), 1);
+        jobject value = readsField() ? env->GetObjectField(obj, fieldId_) : env->CallObjectMethod(obj, getterId_);
+        NATIVE_STATS_LOCAL_REF(value);
+        return value;
+    }
+
+    /**
+     * Reads a String property as UTF-8 into the thread's ScratchArena; null reads as an empty string.
+     * The view is valid until the current ScratchArena::Scope closes; the jstring's local reference is released
+     * before returning.
+     */
+    std::string_view readString(JNIEnv* env, jobject obj) const {
+        return toScratchString(env, static_cast<jstring>(readObject(env, obj)));
+    }
+
+    jdouble readDouble(JNIEnv* env, jobject obj) const {
+        NATIVE_STATS_PHASE(FieldRead);
+        NATIVE_STATS_JNI(readKind(), 1);
+        return readsField() ? env->GetDoubleField(obj, fieldId_) : env->CallDoubleMethod(obj, getterId_);
+    }
+
+    /**
+     * Reads an int-returning property whose backing field may be a byte, short or int.
+     */
+    jint readInt(JNIEnv* env, jobject obj) const {
+        NATIVE_STATS_PHASE(FieldRead);
+        NATIVE_STATS_JNI(readKind(), 1);
+        if (!readsField()) {
+            return env->CallIntMethod(obj, getterId_);
+        }
+        switch (fieldKind_) {
+            case 'B':
+                return env->GetByteField(obj, fieldId_);
+            case 'S':
+                return env->GetShortField(obj, fieldId_);
+            default:
+                return env->GetIntField(obj, fieldId_);
+        }
+    }
+
+    /**
+     * Copies javaStr to UTF-8 in the thread's ScratchArena and deletes its local reference.
+     */
+    static std::string_view toScratchString(JNIEnv* env, jstring javaStr) {
+        if (!javaStr) {
+            return std::string_view();
+        }
+        std::string_view result = toScratchUtf8(env, javaStr);
+        env->DeleteLocalRef(javaStr);
+        NATIVE_STATS_LOCAL_REF_DELETED();
+        return result;
+    }
+
+private:
+    jfieldID fieldId_ = nullptr;
+    jmethodID getterId_ = nullptr;
+    char fieldKind_ = 0;
+
+    nativestats::JniCall readKind() const {
+        return readsField() ? nativestats::JniCall::FieldRead : nativestats::JniCall::GetterCall;
+    }
+};
+
+#endif // ANDROID_SDK_SHADOWPROPERTY_H
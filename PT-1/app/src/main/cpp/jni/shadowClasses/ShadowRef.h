@@ -0,0 +1,67 @@
+#ifndef ANDROID_SDK_SHADOWREF_H
+#define ANDROID_SDK_SHADOWREF_H
+
+#include <jni.h>
+#include <utility>
+#include "../../core/NativeStats.h"
+
+extern JavaVM* globalJvm;
+
+/**
+ * How long a shadow keeps its Java object alive.
+ *  - Scoped: borrows the caller's local reference; valid only for the current native call. No JNI work at all.
+ *  - Global: pins the object with a global reference so the shadow may outlive the call (or cross threads).
+ */
+enum class ShadowLifetime {
+    Scoped,
+    Global
+};
+
+/**
+ * @class ShadowRef
+ * @brief The jobject held by a shadow class, owning a global reference only for ShadowLifetime::Global.
+ *
+ * Converts implicitly to jobject so shadow getters can pass it straight to JNI calls.
+ */
+class ShadowRef {
+public:
+    /**
+     * A null env or obj is kept as-is (no reference is created) so the owning shadow can reject it.
+     */
+    ShadowRef(JNIEnv* env, jobject obj, ShadowLifetime lifetime)
+            : object_(obj), ownsGlobalRef_(false) {
+        if (lifetime == ShadowLifetime::Global && env && obj) {
+            NATIVE_STATS_JNI(nativestats::JniCall::Reference, 1);
+            NATIVE_STATS_GLOBAL_REF();
+            object_ = env->NewGlobalRef(obj);
+            ownsGlobalRef_ = true;
+        }
+    }
+
+    ShadowRef(const ShadowRef&) = delete;
+    ShadowRef& operator=(const ShadowRef&) = delete;
+
+    ShadowRef(ShadowRef&& other) noexcept
+            : object_(std::exchange(other.object_, nullptr)), ownsGlobalRef_(other.ownsGlobalRef_) {}
+
+    ~ShadowRef() {
+        if (!ownsGlobalRef_ || !object_) {
+            return;
+        }
+        JNIEnv* env;
+        int getEnvStatus = globalJvm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
+        if (getEnvStatus != JNI_EDETACHED && env != nullptr) {
+            env->DeleteGlobalRef(object_);
+        }
+    }
+
+    operator jobject() const {
+        return object_;
+    }
+
+private:
+    jobject object_;
+    bool ownsGlobalRef_;
+};
+
+#endif // ANDROID_SDK_SHADOWREF_H
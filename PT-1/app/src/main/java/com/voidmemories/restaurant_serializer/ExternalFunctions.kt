@@ -1,9 +1,417 @@
 package com.voidmemories.restaurant_serializer
 
+import android.os.ParcelFileDescriptor
+import java.io.File
+import java.nio.ByteBuffer
+import java.time.DayOfWeek
+import java.time.LocalTime
+import java.util.concurrent.CompletableFuture
+import java.util.concurrent.RejectedExecutionException
+
 class ExternalFunctions {
     init {
         System.loadLibrary("restaurant-lib")
     }
 
     external fun serializeRestaurant(restaurant: Restaurant):String
-}
\ No newline at end of file
+
+    /**
+     * Writes the UTF-8 JSON into a direct [buffer], starting at index 0; position and limit are left untouched.
+     * Returns the number of bytes written, or the required size when it exceeds the buffer's capacity,
+     * in which case the buffer's contents are unspecified.
+     */
+    external fun serializeRestaurantInto(restaurant: Restaurant, buffer: ByteBuffer): Int
+
+    /**
+     * Encodes the restaurant as [format]. Binary formats write doubles as raw IEEE-754 binary64 and
+     * use the same keys and structure as the JSON output.
+     */
+    fun serializeRestaurant(restaurant: Restaurant, format: SerializationFormat): ByteArray =
+        serializeRestaurantAs(restaurant, format.ordinal)
+
+    /**
+     * Same contract as [serializeRestaurantInto], encoded as [format].
+     */
+    fun serializeRestaurantInto(restaurant: Restaurant, format: SerializationFormat, buffer: ByteBuffer): Int =
+        serializeRestaurantAsInto(restaurant, format.ordinal, buffer)
+
+    /**
+     * Decodes a restaurant from JSON as produced by [serializeRestaurant]. Keys may come in any order and
+     * unknown keys are ignored. Throws IllegalArgumentException for malformed JSON.
+     */
+    external fun deserializeRestaurant(json: String): Restaurant
+
+    /**
+     * Decodes a restaurant from the UTF-8 JSON between the direct [buffer]'s position and limit,
+     * without copying it; position and limit are left untouched.
+     */
+    fun deserializeRestaurant(buffer: ByteBuffer): Restaurant =
+        deserializeRestaurantFromBuffer(buffer, buffer.position(), buffer.remaining())
+
+    /**
+     * Serializes [restaurant] to JSON without making the caller wait for the encode. The calling thread only
+     * snapshots the restaurant's contents (the JNI reads); UTF-8 encoding and String creation happen on a native
+     * background thread, which completes the returned future. Cancelling the future before its turn skips the work.
+     * The future fails with [RejectedExecutionException] when 1024 requests are already queued.
+     * The serialization cache is not used.
+     */
+    fun serializeRestaurantAsync(restaurant: Restaurant): CompletableFuture<String> {
+        val future = CompletableFuture<String>()
+        if (!serializeRestaurantAsyncInto(restaurant, future)) {
+            future.completeExceptionally(RejectedExecutionException("Serialization queue is full or not running"))
+        }
+        return future
+    }
+
+    /**
+     * Like [serializeRestaurantAsync], also delivering the outcome to [callback], on the native background thread
+     * (or the caller's, if the request is rejected). The returned future can still be used to cancel.
+     */
+    fun serializeRestaurantAsync(
+        restaurant: Restaurant,
+        callback: (json: String?, error: Throwable?) -> Unit
+    ): CompletableFuture<String> =
+        serializeRestaurantAsync(restaurant).also { it.whenComplete(callback) }
+
+    private external fun serializeRestaurantAsyncInto(restaurant: Restaurant, future: CompletableFuture<String>): Boolean
+
+    /**
+     * Returns the RFC 6902 JSON Patch that turns the JSON of [before] into the JSON of [after].
+     * Menu items are matched by id and opening hours by dayOfWeek, so a reordered or partly edited
+     * list yields move/replace operations instead of a whole new list. Subtrees shared by reference
+     * (e.g. carried over by copy()) are skipped without being read.
+     */
+    external fun diffRestaurants(before: Restaurant, after: Restaurant): String
+
+    /**
+     * Compiles [fieldPaths] into a reusable native projection for [serializeRestaurantProjected]. Paths are property
+     * names, dotted to reach into nested objects and list elements: "address.city", "menu.price". An object or list
+     * named by itself ("menu") is included whole. Throws IllegalArgumentException for a path that names no property.
+     */
+    fun compileProjection(fieldPaths: List<String>): RestaurantProjection =
+        RestaurantProjection(this, compileProjectionPlan(fieldPaths), fieldPaths.toList())
+
+    /**
+     * Serializes only the fields selected by [projection], in the same key order and format as [serializeRestaurant].
+     * Unselected fields are never read from the JVM, so a narrow projection also saves their JNI calls and transcoding.
+     * The serialization cache is not used.
+     */
+    fun serializeRestaurantProjected(restaurant: Restaurant, projection: RestaurantProjection): String =
+        serializeRestaurantProjectedWith(restaurant, projection.handle)
+
+    /**
+     * [serializeRestaurantProjected] for a whole list in one JNI call, as a JSON array or newline-delimited JSON.
+     */
+    fun serializeRestaurantsProjected(
+        restaurants: List<Restaurant>,
+        projection: RestaurantProjection,
+        ndjson: Boolean = false
+    ): String = serializeRestaurantsProjectedWith(restaurants, projection.handle, ndjson)
+
+    internal fun releaseProjection(plan: Long) = releaseProjectionPlan(plan)
+
+    private external fun compileProjectionPlan(fieldPaths: List<String>): Long
+
+    private external fun releaseProjectionPlan(plan: Long)
+
+    private external fun serializeRestaurantProjectedWith(restaurant: Restaurant, plan: Long): String
+
+    private external fun serializeRestaurantsProjectedWith(restaurants: List<Restaurant>, plan: Long, ndjson: Boolean): String
+
+    /**
+     * Copies the ratings, cuisines and menu prices and categories of [restaurants] into a native columnar store in
+     * one JNI call, so that filters and price aggregates run over contiguous columns instead of the object graph.
+     */
+    fun loadRestaurantStore(restaurants: List<Restaurant>): RestaurantStore {
+        val store = loadRestaurantStoreHandle(restaurants)
+        val info = getRestaurantStoreInfo(store)
+        return RestaurantStore(this, store, info[0].toInt(), info[1].toInt(), info[2])
+    }
+
+    /**
+     * Returns the indices in the loaded list of the restaurants matching [filter], ascending.
+     */
+    fun filterRestaurants(store: RestaurantStore, filter: RestaurantFilter): IntArray {
+        val menuItem = filter.menuItem
+        return filterRestaurantStore(
+            store.handle, filter.minRating, filter.ratingBelow, filter.cuisine, menuItem != null,
+            menuItem?.minPrice ?: Double.NEGATIVE_INFINITY, menuItem?.priceBelow ?: Double.POSITIVE_INFINITY,
+            menuItem?.category
+        )
+    }
+
+    /**
+     * Returns the menu items matching [filter] over all restaurants of the store, as pairs flattened into one
+     * array: restaurant index at 2 * i, index in that restaurant's menu at 2 * i + 1, in list order.
+     */
+    fun filterMenuItems(store: RestaurantStore, filter: MenuItemFilter): IntArray =
+        filterRestaurantStoreMenu(store.handle, filter.minPrice, filter.priceBelow, filter.category)
+
+    /**
+     * Returns the count, min, max, mean and a [buckets]-bucket histogram of the prices of the menu items matching
+     * [filter].
+     */
+    fun summarizeMenuPrices(
+        store: RestaurantStore,
+        filter: MenuItemFilter = MenuItemFilter(),
+        buckets: Int = 10
+    ): PriceSummary {
+        val values =
+            summarizeRestaurantStorePrices(store.handle, filter.minPrice, filter.priceBelow, filter.category, buckets)
+        val histogram = LongArray(values.size - 4) { values[4 + it].toLong() }
+        return PriceSummary(values[0].toLong(), values[1], values[2], values[3], histogram)
+    }
+
+    internal fun releaseRestaurantStore(store: Long) = releaseRestaurantStoreHandle(store)
+
+    private external fun loadRestaurantStoreHandle(restaurants: List<Restaurant>): Long
+
+    private external fun releaseRestaurantStoreHandle(store: Long)
+
+    private external fun getRestaurantStoreInfo(store: Long): LongArray
+
+    private external fun filterRestaurantStore(
+        store: Long,
+        minRating: Double,
+        ratingBelow: Double,
+        cuisine: String?,
+        hasMenuItemFilter: Boolean,
+        minPrice: Double,
+        priceBelow: Double,
+        category: String?
+    ): IntArray
+
+    private external fun filterRestaurantStoreMenu(
+        store: Long,
+        minPrice: Double,
+        priceBelow: Double,
+        category: String?
+    ): IntArray
+
+    private external fun summarizeRestaurantStorePrices(
+        store: Long,
+        minPrice: Double,
+        priceBelow: Double,
+        category: String?,
+        buckets: Int
+    ): DoubleArray
+
+    /**
+     * Compiles the opening hours of [restaurants] into a native minute-resolution index in one JNI call, for
+     * "open now" and "next opening" queries over the whole list.
+     */
+    fun loadOpeningHoursIndex(restaurants: List<Restaurant>): OpeningHoursIndex {
+        val index = loadOpeningHoursIndexHandle(restaurants)
+        val info = getOpeningHoursIndexInfo(index)
+        return OpeningHoursIndex(this, index, info[0].toInt(), info[1])
+    }
+
+    /**
+     * Whether the restaurant at [restaurant] in the indexed list is open on [day] at [time].
+     */
+    fun isOpenAt(index: OpeningHoursIndex, restaurant: Int, day: DayOfWeek, time: LocalTime): Boolean {
+        require(restaurant in 0 until index.restaurantCount) { "No restaurant $restaurant in the index" }
+        return isRestaurantOpenAt(index.handle, restaurant, OpeningHoursIndex.weekMinute(day, time))
+    }
+
+    /**
+     * Minutes from [day] [time] until the restaurant at [restaurant] next opens: 0 when it is open then, -1 when it
+     * is never open.
+     */
+    fun minutesUntilOpen(index: OpeningHoursIndex, restaurant: Int, day: DayOfWeek, time: LocalTime): Int {
+        require(restaurant in 0 until index.restaurantCount) { "No restaurant $restaurant in the index" }
+        return minutesUntilRestaurantOpens(index.handle, restaurant, OpeningHoursIndex.weekMinute(day, time))
+    }
+
+    /**
+     * Returns the indices of the restaurants open on [day] at [time] and for at least the following [minutes]
+     * (past midnight and Sunday if need be), ascending. With [minutes] <= 1, simply open at [time].
+     */
+    fun restaurantsOpenAt(index: OpeningHoursIndex, day: DayOfWeek, time: LocalTime, minutes: Int = 1): IntArray =
+        restaurantsOpenThroughout(index.handle, OpeningHoursIndex.weekMinute(day, time), minutes)
+
+    /**
+     * [minutesUntilOpen] for every restaurant of the index, in list order.
+     */
+    fun minutesUntilOpen(index: OpeningHoursIndex, day: DayOfWeek, time: LocalTime): IntArray =
+        minutesUntilRestaurantsOpen(index.handle, OpeningHoursIndex.weekMinute(day, time))
+
+    internal fun releaseOpeningHoursIndex(index: Long) = releaseOpeningHoursIndexHandle(index)
+
+    private external fun loadOpeningHoursIndexHandle(restaurants: List<Restaurant>): Long
+
+    private external fun releaseOpeningHoursIndexHandle(index: Long)
+
+    private external fun getOpeningHoursIndexInfo(index: Long): LongArray
+
+    private external fun isRestaurantOpenAt(index: Long, restaurant: Int, weekMinute: Int): Boolean
+
+    private external fun minutesUntilRestaurantOpens(index: Long, restaurant: Int, weekMinute: Int): Int
+
+    private external fun restaurantsOpenThroughout(index: Long, weekMinute: Int, minutes: Int): IntArray
+
+    private external fun minutesUntilRestaurantsOpen(index: Long, weekMinute: Int): IntArray
+
+    /**
+     * Indexes the name and description of every menu item of [restaurants] for [searchMenu], in one JNI call.
+     */
+    fun loadMenuSearchIndex(restaurants: List<Restaurant>): MenuSearchIndex =
+        MenuSearchIndex(this, loadMenuSearchIndexHandle(restaurants))
+
+    /**
+     * Re-indexes the menu of the restaurant at [restaurantIndex] from [restaurant], leaving the rest of the index
+     * as it is; a null [restaurant] removes its menu items. An index past the end adds a restaurant.
+     */
+    fun updateMenuSearchIndex(index: MenuSearchIndex, restaurantIndex: Int, restaurant: Restaurant?) {
+        require(restaurantIndex >= 0) { "Negative restaurant index $restaurantIndex" }
+        updateMenuSearchIndexHandle(index.handle, restaurantIndex, restaurant)
+    }
+
+    /**
+     * Returns the (restaurant index, menu index) pairs of the menu items whose name or description contains
+     * [query], flattened and best match first: name matches before description matches, whole names and word
+     * starts first, then earlier matches. With [prefix], [query] must start a word. At most [limit] matches,
+     * 0 for all.
+     */
+    fun searchMenu(index: MenuSearchIndex, query: String, prefix: Boolean = false, limit: Int = 50): IntArray =
+        searchMenuSearchIndex(index.handle, query, prefix, limit)
+
+    internal fun menuSearchIndexInfo(index: MenuSearchIndex): LongArray = getMenuSearchIndexInfo(index.handle)
+
+    internal fun releaseMenuSearchIndex(index: Long) = releaseMenuSearchIndexHandle(index)
+
+    private external fun loadMenuSearchIndexHandle(restaurants: List<Restaurant>): Long
+
+    private external fun releaseMenuSearchIndexHandle(index: Long)
+
+    private external fun getMenuSearchIndexInfo(index: Long): LongArray
+
+    private external fun updateMenuSearchIndexHandle(index: Long, restaurantIndex: Int, restaurant: Restaurant?)
+
+    private external fun searchMenuSearchIndex(index: Long, query: String, prefix: Boolean, limit: Int): IntArray
+
+    /**
+     * Serializes the whole list in a single JNI call.
+     * Returns a JSON array, or newline-delimited JSON when [ndjson] is true.
+     */
+    external fun serializeRestaurants(restaurants: List<Restaurant>, ndjson: Boolean = false): String
+
+    /**
+     * Serializes the whole list as one array of [format] in a single JNI call. JSON is the same as
+     * [serializeRestaurants]; in the binary formats a null element is encoded as null.
+     */
+    fun serializeRestaurants(restaurants: List<Restaurant>, format: SerializationFormat): ByteArray =
+        serializeRestaurantsAs(restaurants, format.ordinal)
+
+    /**
+     * Streams [restaurants] to [file] (created or truncated) as newline-delimited JSON, byte for byte what
+     * [serializeRestaurants] returns with ndjson = true, but without ever holding the whole output: records are
+     * encoded into a fixed set of reusable native buffers that are written out with batched writev() calls.
+     * With [overlapIo] a native thread does the writes while encoding continues.
+     * @return the number of bytes written
+     * @throws java.io.IOException if the file cannot be opened or written
+     */
+    fun exportRestaurants(restaurants: List<Restaurant>, file: File, overlapIo: Boolean = true): Long =
+        exportRestaurantsToPath(restaurants, file.path, overlapIo)
+
+    /**
+     * Like the [File] overload, writing at the current position of [fd], which is left open.
+     */
+    fun exportRestaurants(restaurants: List<Restaurant>, fd: ParcelFileDescriptor, overlapIo: Boolean = true): Long =
+        exportRestaurantsToFd(restaurants, fd.fd, overlapIo)
+
+    private external fun exportRestaurantsToPath(restaurants: List<Restaurant>, path: String, overlapIo: Boolean): Long
+
+    private external fun exportRestaurantsToFd(restaurants: List<Restaurant>, fd: Int, overlapIo: Boolean): Long
+
+    /**
+     * Chooses how the native side reads model properties: straight from the backing fields (default),
+     * or through the Kotlin getters. Properties whose field cannot be resolved always use the getter.
+     */
+    external fun setFieldAccessEnabled(enabled: Boolean)
+
+    /**
+     * Chooses how the native side reads ArrayList and Arrays.asList / listOf(a, b, ...) lists: straight from their
+     * backing arrays (default), or through one toArray() call like any other collection. The backing arrays are
+     * non-SDK fields; where the runtime denies them, toArray() is used regardless and a warning is logged once.
+     */
+    external fun setListFastPathEnabled(enabled: Boolean)
+
+    /**
+     * Turns on a per-call dictionary of strings: within one serialize or export call, a string value seen before is
+     * not transcoded again, and a String field holding the very same object as in the previous restaurant is not
+     * even read. JSON and MessagePack output is unchanged. CBOR output becomes a stringref namespace (tag 256)
+     * in which repeats are back-references (tag 25), which decoders without stringref support cannot read.
+     * Has no effect while the serialization cache is enabled. Off by default.
+     */
+    external fun setStringDeduplicationEnabled(enabled: Boolean)
+
+    fun getStringDeduplicationStats(): StringDeduplicationStats =
+        getStringDeduplicationStatsArray().let { StringDeduplicationStats(it[0], it[1], it[2], it[3]) }
+
+    private external fun getStringDeduplicationStatsArray(): LongArray
+
+    private external fun serializeRestaurantAs(restaurant: Restaurant, format: Int): ByteArray
+
+    private external fun serializeRestaurantsAs(restaurants: List<Restaurant>, format: Int): ByteArray
+
+    private external fun serializeRestaurantAsInto(restaurant: Restaurant, format: Int, buffer: ByteBuffer): Int
+
+    private external fun deserializeRestaurantFromBuffer(buffer: ByteBuffer, offset: Int, length: Int): Restaurant
+
+    /**
+     * Sets how many native threads [serializeRestaurants] encodes on; 1, the default, keeps everything on the
+     * calling thread. With more, the calling thread reads the restaurants into a JVM-independent snapshot chunk
+     * by chunk while a work-stealing pool of [threads] workers encodes finished chunks; the output is identical.
+     * Lists of 64 restaurants or fewer, and all calls while the serialization cache is enabled, stay sequential.
+     */
+    external fun setSerializationThreads(threads: Int)
+
+    /**
+     * Enables the native serialization cache with a budget of [bytes] (least recently used entries are evicted),
+     * or disables and empties it with 0, the default. While enabled, every serialize call fingerprints the
+     * restaurant and reuses the previous encoding of an unchanged restaurant, or of its unchanged lists.
+     */
+    external fun setSerializationCacheCapacity(bytes: Long)
+
+    /**
+     * Drops the cached encodings of the restaurant with [restaurantId], or the whole cache when it is null.
+     * Not needed for correctness: changed content never matches its old fingerprint.
+     */
+    external fun invalidateSerializationCache(restaurantId: String? = null)
+
+    fun getSerializationCacheStats(): SerializationCacheStats =
+        getSerializationCacheStatsArray().let {
+            SerializationCacheStats(it[0], it[1], it[2], it[3], it[4], it[5], it[6])
+        }
+
+    private external fun getSerializationCacheStatsArray(): LongArray
+
+    /**
+     * Returns the native layer's JNI call, reference, output byte and phase timing counters. They are only collected
+     * when the library is built with the RESTAURANT_INSTRUMENTATION CMake option; see [NativeStats].
+     */
+    fun getNativeStats(): NativeStats = NativeStats.fromArray(getNativeStatsArray())
+
+    private external fun getNativeStatsArray(): LongArray
+
+    /**
+     * Zeroes the counters reported by [getNativeStats].
+     */
+    external fun resetNativeStats()
+
+    /**
+     * Starts recording a span for every native call, result String creation, batch chunk and export write, keeping
+     * at most [maxEvents]; any trace in progress is discarded. Instrumented builds only, see [getNativeStats].
+     */
+    external fun startNativeTrace(maxEvents: Int = 100_000)
+
+    /**
+     * Stops the trace and returns it in the Chrome trace event format, for chrome://tracing or ui.perfetto.dev.
+     * Timestamps are microseconds since [startNativeTrace]; otherData.droppedEvents counts spans beyond maxEvents.
+     */
+    external fun stopNativeTrace(): String
+
+    fun serializeRestaurants(restaurants: Array<Restaurant>, ndjson: Boolean = false): String =
+        serializeRestaurants(restaurants.asList(), ndjson)
+}
@@ -0,0 +1,34 @@
+package com.voidmemories.restaurant_serializer
+
+/**
+ * A native full-text index of the menu item names and descriptions of a restaurant list, built by
+ * [ExternalFunctions.loadMenuSearchIndex] and searched with [ExternalFunctions.searchMenu]. Text is matched
+ * case-insensitively (ASCII, Latin-1, Greek and Cyrillic letters), and any run of spaces and punctuation matches
+ * any other, so "gluten free" finds "Gluten-Free". Restaurant i of the list is indexed as restaurant i;
+ * [ExternalFunctions.updateMenuSearchIndex] re-indexes a single restaurant after a menu edit.
+ *
+ * Searches may run from any number of threads, and an update waits for the searches in progress. The index holds
+ * native memory until [close], which must not run while another call is using it.
+ */
+class MenuSearchIndex internal constructor(
+    private val functions: ExternalFunctions,
+    private var index: Long
+) : AutoCloseable {
+    internal val handle: Long
+        get() = synchronized(this) { index }.also { check(it != 0L) { "Menu search index is closed" } }
+
+    /** Menu items currently indexed. */
+    val menuItemCount: Int
+        get() = functions.menuSearchIndexInfo(this)[0].toInt()
+
+    /** Native memory held by the index, roughly. */
+    val memoryBytes: Long
+        get() = functions.menuSearchIndexInfo(this)[2]
+
+    override fun close() {
+        val released = synchronized(this) { index.also { index = 0L } }
+        if (released != 0L) {
+            functions.releaseMenuSearchIndex(released)
+        }
+    }
+}
@@ -0,0 +1,86 @@
+package com.voidmemories.restaurant_serializer
+
+/**
+ * Kinds of JNI calls counted by the instrumented native layer, in native enum order (NativeStats.h).
+ */
+enum class JniCallKind { FIELD_READ, GETTER_CALL, STRING_READ, LIST_READ, STRING_CREATION, REFERENCE }
+
+/**
+ * Timed native phases, in native enum order. Phases nest and are timed inclusively: [TRANSCODE] is part of
+ * [ENCODE], which is part of [CALL] (a native entry point end to end).
+ */
+enum class NativePhase { CALL, ENCODE, FIELD_READ, STRING_READ, TRANSCODE, RESULT_STRING, BATCH_CHUNK, FD_WRITE }
+
+/**
+ * How often a phase ran and how long it took; histogram[b] counts durations in [2^b, 2^(b+1)) nanoseconds.
+ */
+class PhaseStats(val count: Long, val totalNanos: Long, val histogram: LongArray) {
+    val meanNanos: Double get() = if (count == 0L) 0.0 else totalNanos.toDouble() / count
+
+    /**
+     * Upper bound of the histogram bucket holding the [quantile] (0..1) of durations, in nanoseconds.
+     */
+    fun quantileNanos(quantile: Double): Long {
+        val rank = Math.ceil(quantile * count).toLong().coerceAtLeast(1)
+        var seen = 0L
+        histogram.forEachIndexed { bucket, hits ->
+            seen += hits
+            if (seen >= rank) return 1L shl (bucket + 1)
+        }
+        return 0
+    }
+
+    override fun toString(): String = "PhaseStats(count=$count, totalNanos=$totalNanos, p50<=${quantileNanos(0.5)}ns, " +
+            "p99<=${quantileNanos(0.99)}ns)"
+}
+
+/**
+ * Counters of the native layer since the library was loaded (or [ExternalFunctions.resetNativeStats]), summed
+ * over all native and JVM threads. Only builds with the RESTAURANT_INSTRUMENTATION CMake option collect them;
+ * otherwise [enabled] is false and everything reads 0.
+ */
+data class NativeStats(
+    val enabled: Boolean,
+    val jniCalls: Map<JniCallKind, Long>,
+    val localRefsCreated: Long,
+    val globalRefsCreated: Long,
+    val bytesProduced: Long,
+    /** C++ heap allocations (operator new) made by the native library, on any thread. */
+    val heapAllocations: Long,
+    /** Most of the counted local references alive at once on one thread; frames and call returns release them. */
+    val localRefsPeak: Long,
+    val phases: Map<NativePhase, PhaseStats>
+) {
+    val totalJniCalls: Long get() = jniCalls.values.sum()
+
+    companion object {
+        /**
+         * Parses the native layout: {enabled, jniCallKinds, phases, histogramBuckets}, one counter per JNI call kind,
+         * local refs, global refs, bytes, heap allocations, local ref peak, then count, total ns and the histogram for
+         * each phase.
+         */
+        internal fun fromArray(values: LongArray): NativeStats {
+            val kinds = values[1].toInt()
+            val phaseCount = values[2].toInt()
+            val buckets = values[3].toInt()
+            check(kinds == JniCallKind.values().size && phaseCount == NativePhase.values().size) {
+                "Native stats layout does not match this build"
+            }
+            var next = 4
+            val jniCalls = JniCallKind.values().associateWith { values[next++] }
+            val localRefs = values[next++]
+            val globalRefs = values[next++]
+            val bytes = values[next++]
+            val heapAllocations = values[next++]
+            val localRefsPeak = values[next++]
+            val phases = NativePhase.values().associateWith {
+                val stats = PhaseStats(values[next], values[next + 1], values.copyOfRange(next + 2, next + 2 + buckets))
+                next += 2 + buckets
+                stats
+            }
+            return NativeStats(
+                values[0] != 0L, jniCalls, localRefs, globalRefs, bytes, heapAllocations, localRefsPeak, phases
+            )
+        }
+    }
+}
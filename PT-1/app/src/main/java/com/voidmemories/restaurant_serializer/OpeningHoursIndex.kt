@@ -0,0 +1,37 @@
+package com.voidmemories.restaurant_serializer
+
+import java.time.DayOfWeek
+import java.time.LocalTime
+
+/**
+ * The weekly opening hours of a restaurant list compiled by [ExternalFunctions.loadOpeningHoursIndex]: each
+ * restaurant's [Restaurant.openingHours] become a 7 x 1440 bit bitmap, one bit per minute of the week. An entry
+ * whose closeTime is not after its openTime runs past midnight into the next day (Sunday's into Monday); equal
+ * times mean open around the clock. Seconds are dropped, except that an interval shorter than a minute within
+ * one minute still opens that minute. It is immutable and may be queried from any thread; it holds native memory
+ * until [close], which must not run while a query is using the index.
+ */
+class OpeningHoursIndex internal constructor(
+    private val functions: ExternalFunctions,
+    private var index: Long,
+    val restaurantCount: Int,
+    val memoryBytes: Long
+) : AutoCloseable {
+    internal val handle: Long
+        get() = synchronized(this) { index }.also { check(it != 0L) { "Opening hours index is closed" } }
+
+    override fun close() {
+        val released = synchronized(this) { index.also { index = 0L } }
+        if (released != 0L) {
+            functions.releaseOpeningHoursIndex(released)
+        }
+    }
+
+    internal companion object {
+        const val MINUTES_PER_DAY = 24 * 60
+
+        /** Minute of the week, MONDAY 00:00 = 0, as the native index counts it. */
+        fun weekMinute(day: DayOfWeek, time: LocalTime): Int =
+            day.ordinal * MINUTES_PER_DAY + time.hour * 60 + time.minute
+    }
+}
@@ -0,0 +1,22 @@
+package com.voidmemories.restaurant_serializer
+
+/**
+ * A compiled field selection for [ExternalFunctions.serializeRestaurantProjected], made by
+ * [ExternalFunctions.compileProjection]. It is immutable and may be shared across threads; it holds native memory
+ * until [close], which must not run while a serialize call is using the projection.
+ */
+class RestaurantProjection internal constructor(
+    private val functions: ExternalFunctions,
+    private var plan: Long,
+    val fieldPaths: List<String>
+) : AutoCloseable {
+    internal val handle: Long
+        get() = synchronized(this) { plan }.also { check(it != 0L) { "Projection is closed" } }
+
+    override fun close() {
+        val released = synchronized(this) { plan.also { plan = 0L } }
+        if (released != 0L) {
+            functions.releaseProjection(released)
+        }
+    }
+}
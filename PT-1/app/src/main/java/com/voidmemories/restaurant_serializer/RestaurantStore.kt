@@ -0,0 +1,59 @@
+package com.voidmemories.restaurant_serializer
+
+/**
+ * A native, column-oriented copy of a restaurant list made by [ExternalFunctions.loadRestaurantStore], for
+ * [ExternalFunctions.filterRestaurants], [ExternalFunctions.filterMenuItems] and
+ * [ExternalFunctions.summarizeMenuPrices]. It holds the ratings, cuisines, menu prices and menu categories as of
+ * loading; later changes to the restaurants are not seen. It is immutable and may be queried from any thread;
+ * it holds native memory until [close], which must not run while a query is using the store.
+ */
+class RestaurantStore internal constructor(
+    private val functions: ExternalFunctions,
+    private var store: Long,
+    val restaurantCount: Int,
+    val menuItemCount: Int,
+    val memoryBytes: Long
+) : AutoCloseable {
+    internal val handle: Long
+        get() = synchronized(this) { store }.also { check(it != 0L) { "Restaurant store is closed" } }
+
+    override fun close() {
+        val released = synchronized(this) { store.also { store = 0L } }
+        if (released != 0L) {
+            functions.releaseRestaurantStore(released)
+        }
+    }
+}
+
+/**
+ * Menu items priced in [minPrice, priceBelow) and, when [category] is set, of exactly that category.
+ * The default bounds match every price.
+ */
+data class MenuItemFilter(
+    val minPrice: Double = Double.NEGATIVE_INFINITY,
+    val priceBelow: Double = Double.POSITIVE_INFINITY,
+    val category: String? = null
+)
+
+/**
+ * Restaurants rated in [minRating, ratingBelow), serving [cuisine] when set, and with at least one menu item
+ * matching [menuItem] when set. The default bounds match every rating; null list elements never match.
+ */
+data class RestaurantFilter(
+    val minRating: Double = Double.NEGATIVE_INFINITY,
+    val ratingBelow: Double = Double.POSITIVE_INFINITY,
+    val cuisine: String? = null,
+    val menuItem: MenuItemFilter? = null
+)
+
+/**
+ * Prices of the menu items matching a [MenuItemFilter], NaN and infinite prices left out. [histogram] counts them
+ * in equal-width buckets from [min] to [max]; [min], [max] and [mean] are 0 when [count] is 0.
+ */
+class PriceSummary(
+    val count: Long,
+    val min: Double,
+    val max: Double,
+    val mean: Double,
+    val histogram: LongArray
+)
@@ -0,0 +1,15 @@
+package com.voidmemories.restaurant_serializer
+
+/**
+ * Counters of the native serialization cache since the library was loaded.
+ * Fragment counters cover list fields (menu, openingHours) reused across restaurants and versions.
+ */
+data class SerializationCacheStats(
+    val hits: Long,
+    val misses: Long,
+    val fragmentHits: Long,
+    val fragmentMisses: Long,
+    val evictions: Long,
+    val entries: Long,
+    val bytes: Long
+)
@@ -0,0 +1,15 @@
+package com.voidmemories.restaurant_serializer
+
+/**
+ * Output formats of the native serializer. The ordinal is passed to native code, so keep the order.
+ */
+enum class SerializationFormat {
+    /** UTF-8 JSON text (RFC 8259) */
+    JSON,
+
+    /** CBOR (RFC 8949) with definite-length maps and arrays */
+    CBOR,
+
+    /** MessagePack */
+    MESSAGE_PACK
+}
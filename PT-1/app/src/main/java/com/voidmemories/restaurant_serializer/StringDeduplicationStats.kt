@@ -0,0 +1,13 @@
+package com.voidmemories.restaurant_serializer
+
+/**
+ * Counters of the per-call string dictionaries since the library was loaded.
+ * [hits] are strings written without transcoding; [identityHits], a subset, were not even read from the JVM.
+ * [bytesSaved] is the CBOR output saved by back-references.
+ */
+data class StringDeduplicationStats(
+    val lookups: Long,
+    val hits: Long,
+    val identityHits: Long,
+    val bytesSaved: Long
+)